@@ -26,6 +26,13 @@ public:
         return MathUtils::MatrixUtils::getZoomMatrix(zoomLevel) * projection;  // Apply zoom
     }
 
+    // Visible world rectangle (minX, minY, maxX, maxY); zoom scales around the viewport centre
+    glm::vec4 getViewBounds() const {
+        glm::vec2 center = position + glm::vec2(viewportWidth, viewportHeight) * 0.5f;
+        glm::vec2 halfExtent = glm::vec2(viewportWidth, viewportHeight) * (0.5f / zoomLevel);
+        return glm::vec4(center - halfExtent, center + halfExtent);
+    }
+
     // Update camera position to follow the target smoothly using lerp
     void lerpFollow(const glm::vec2& target, float lerpFactor = 0.1f) {
         glm::vec2 targetPosition = target - glm::vec2(viewportWidth / 2.0f, viewportHeight / 2.0f);
@@ -5,6 +5,8 @@
 #include <glad/glad.h>
 #include <iostream>
 #include <Gameplay/math_utils.h>
+#include <Render/gl_state.h>
+#include <Render/render_queue.h>
 
 class Character {
 public:
@@ -12,12 +14,19 @@ public:
     glm::vec2 velocity;
     float size;
     unsigned int textureID;
+    glm::vec4 uv = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);  // Current animation frame
+    uint16_t mesh = 0;  // Outline of the visible texels in the backend's SpriteMeshTable
 
     Character(glm::vec2 pos, float s, const char* texturePath) : position(pos), size(s) {
         velocity = glm::vec2(0.0f, 0.0f);  // No initial movement
         textureID = MathUtils::loadTexture(texturePath);  // Load character texture
     }
 
+    // Use a texture created by a RenderBackend
+    Character(glm::vec2 pos, float s, uint32_t texture) : position(pos), size(s), textureID(texture) {
+        velocity = glm::vec2(0.0f, 0.0f);
+    }
+
     // Update character position based on velocity
     void update(float deltaTime) {
         position += velocity * deltaTime;
@@ -36,9 +45,23 @@ public:
     void stopX() { velocity.x = 0.0f; }
     void stopY() { velocity.y = 0.0f; }
 
-    // Bind the character texture before rendering
+    // Bind the character texture before rendering; a no-op if it is still bound
     void bindTexture() {
-        glBindTexture(GL_TEXTURE_2D, textureID);
+        glState().bindTexture(0, textureID);
+    }
+
+    // Queue the character sprite, centred on its position
+    void submit(RenderQueue& queue, uint8_t shader) const {
+        RenderCommand cmd;
+        cmd.position = position - glm::vec2(size * 0.5f);
+        cmd.size = glm::vec2(size);
+        cmd.uv = uv;
+        cmd.mesh = mesh;
+        cmd.color = COLOR_WHITE;
+        cmd.texture = textureID;
+        cmd.shader = shader;
+        cmd.layer = RenderLayer::Sprites;
+        queue.submit(SortKey::batched(cmd.layer, shader, textureID, 0), cmd);
     }
 };
 
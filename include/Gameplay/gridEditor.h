@@ -2,11 +2,16 @@
 #define EDITOR_H
 
 #include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
 #include <vector>
 #include <GLFW/glfw3.h>
 #include <fstream>
 #include <iostream>
 #include <Gameplay/math_utils.h>
+#include <Render/gl_state.h>
+#include <Render/grid_renderer.h>
+#include <Render/render_queue.h>
 
 // Enum for editor modes
 enum class EditorMode { EDIT, PLAY };
@@ -24,51 +29,55 @@ public:
 
     GLuint wallTexture;  // Texture ID for the wall image
 
+    // Changes since the renderer last collected them, so caches can redraw just those tiles
+    std::vector<glm::ivec2> editedTiles;
+    bool mapReloaded = false;
+
     Editor(int width, int height, float tileSize) 
         : gridWidth(width), gridHeight(height), tileSize(tileSize), currentMode(EditorMode::EDIT) {
             tileMap.resize(gridWidth, std::vector<TileType>(gridHeight, TileType::EMPTY));
-            MathUtils::loadTexture("images/wall.jpg");
+            wallTexture = MathUtils::loadTexture("images/wall.jpg");
     }
 
-    // Render the editor grid and tools
-    void renderGrid() {
-        glColor3f(0.8f, 0.8f, 0.8f);
-        glBegin(GL_LINES);
-        for (int i = 0; i <= gridWidth; ++i) {
-            glVertex2f(i * tileSize, 0);
-            glVertex2f(i * tileSize, gridHeight * tileSize);
-        }
-        for (int j = 0; j <= gridHeight; ++j) {
-            glVertex2f(0, j * tileSize);
-            glVertex2f(gridWidth * tileSize, j * tileSize);
-        }
-        glEnd();
+    // Use a wall texture created by a RenderBackend
+    Editor(int width, int height, float tileSize, GLuint wallTexture)
+        : currentMode(EditorMode::EDIT), gridWidth(width), gridHeight(height), tileSize(tileSize), wallTexture(wallTexture) {
+            tileMap.resize(gridWidth, std::vector<TileType>(gridHeight, TileType::EMPTY));
     }
 
-    // Render the wall tiles with the loaded texture
-    void renderTiles() {
-        glEnable(GL_TEXTURE_2D);
-        glBindTexture(GL_TEXTURE_2D, wallTexture);
-        glColor3f(1.0f, 1.0f, 1.0f);  // Ensure the color is white for proper texturing
+    // Draw the editor grid lines; one draw call whatever the map size
+    void renderGrid(GridRenderer& grid) const {
+        grid.draw(glm::vec2(0.0f), gridWidth, gridHeight, tileSize);
+    }
 
-        glBegin(GL_QUADS);
-        for (int i = 0; i < gridWidth; ++i) {
-            for (int j = 0; j < gridHeight; ++j) {
+    // Queue the visible wall tiles in columns [columnBegin, columnEnd); they batch into one draw.
+    // Disjoint column ranges can be submitted from different threads into different queues.
+    void submitTiles(RenderQueue& queue, uint8_t shader, const glm::vec4& viewBounds,
+                     int columnBegin = 0, int columnEnd = -1) const {
+        RenderCommand cmd;
+        cmd.size = glm::vec2(tileSize);
+        cmd.uv = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+        cmd.color = COLOR_WHITE;
+        cmd.texture = wallTexture;
+        cmd.shader = shader;
+        cmd.layer = RenderLayer::Tiles;
+        uint64_t key = SortKey::batched(cmd.layer, shader, wallTexture, 0);
+
+        // Cull to the tiles overlapping the view
+        if (columnEnd < 0) columnEnd = gridWidth;
+        int firstColumn = std::max(columnBegin, static_cast<int>(std::floor(viewBounds.x / tileSize)));
+        int lastColumn = std::min(columnEnd, static_cast<int>(std::floor(viewBounds.z / tileSize)) + 1);
+        int firstRow = std::max(0, static_cast<int>(std::floor(viewBounds.y / tileSize)));
+        int lastRow = std::min(gridHeight, static_cast<int>(std::floor(viewBounds.w / tileSize)) + 1);
+
+        for (int i = firstColumn; i < lastColumn; ++i) {
+            for (int j = firstRow; j < lastRow; ++j) {
                 if (tileMap[i][j] == TileType::WALL) {
-                    float x = i * tileSize;
-                    float y = j * tileSize;
-
-                    // Define the textured quad for the wall
-                    glTexCoord2f(0.0f, 0.0f); glVertex2f(x, y);
-                    glTexCoord2f(1.0f, 0.0f); glVertex2f(x + tileSize, y);
-                    glTexCoord2f(1.0f, 1.0f); glVertex2f(x + tileSize, y + tileSize);
-                    glTexCoord2f(0.0f, 1.0f); glVertex2f(x, y + tileSize);
+                    cmd.position = glm::vec2(i * tileSize, j * tileSize);
+                    queue.submit(key, cmd);
                 }
             }
         }
-        glEnd();
-
-        glDisable(GL_TEXTURE_2D);
     }
 
     // Place a wall at the given position
@@ -76,8 +85,9 @@ public:
         int gridX = static_cast<int>(x / tileSize);
         int gridY = static_cast<int>(y / tileSize);
 
-        if (gridX >= 0 && gridX < gridWidth && gridY >= 0 && gridY < gridHeight) {
+        if (gridX >= 0 && gridX < gridWidth && gridY >= 0 && gridY < gridHeight && tileMap[gridX][gridY] != TileType::WALL) {
             tileMap[gridX][gridY] = TileType::WALL;  // Mark the tile as a wall
+            editedTiles.push_back(glm::ivec2(gridX, gridY));
         }
     }
 
@@ -86,8 +96,9 @@ public:
         int gridX = static_cast<int>(x / tileSize);
         int gridY = static_cast<int>(y / tileSize);
 
-        if (gridX >= 0 && gridX < gridWidth && gridY >= 0 && gridY < gridHeight) {
+        if (gridX >= 0 && gridX < gridWidth && gridY >= 0 && gridY < gridHeight && tileMap[gridX][gridY] != TileType::EMPTY) {
             tileMap[gridX][gridY] = TileType::EMPTY;  // Mark the tile as empty
+            editedTiles.push_back(glm::ivec2(gridX, gridY));
         }
     }
 
@@ -137,6 +148,7 @@ public:
         }
 
         inFile.close();
+        mapReloaded = true;
         std::cout << "Loaded tile map from " << filename << std::endl;
     }
 };
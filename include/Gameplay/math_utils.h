@@ -5,6 +5,9 @@
 #include <stb_image.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <Render/gl_state.h>
+#include <Render/image_cache.h>
+#include <Render/texture_upload.h>
 
 // Utility functions for general math
 namespace MathUtils {
@@ -24,9 +27,15 @@ namespace MathUtils {
     }
 
     unsigned int loadTexture(const char* path) {
+        // A cooked container (tools/texture_cooker) skips the decode and mip generation
+        if (unsigned int cooked = loadCookedTexture(path)) return cooked;
+        // Then the levels an earlier run decoded, which skips stb_image and glGenerateMipmap alike
+        TextureContainer decoded;
+        if (imageCache().load(path, ImageDecodeOptions(), decoded)) return uploadTextureContainer(decoded);
+
         unsigned int texture;
         glGenTextures(1, &texture);
-        glBindTexture(GL_TEXTURE_2D, texture);
+        glState().bindTexture(0, texture);  // Keep the state cache in sync with what we leave bound
 
         // Set texture wrapping/filtering options
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -0,0 +1,322 @@
+#ifndef ASYNC_TEXTURE_LOADER_H
+#define ASYNC_TEXTURE_LOADER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "gl_state.h"
+#include "image.h"
+#include "image_cache.h"
+#include "render_queue.h"
+#include "stream_buffer.h"
+#include "texture_container.h"
+#include "texture_cook.h"
+#include "texture_upload.h"
+#include "thread_pool.h"
+
+// Counters for AsyncTextureLoader; upload figures are for the last update()
+struct TextureLoadStats {
+    size_t decoding = 0;       // Requests still on the workers
+    size_t waiting = 0;        // Decoded, queued for upload
+    size_t uploadedBytes = 0;
+    size_t completed = 0;      // Textures that finished uploading in the last update()
+    size_t totalCompleted = 0;
+    size_t failed = 0;
+};
+
+// A texture whose last level went up in the last update()
+struct LoadedTexture {
+    GLuint texture;
+    uint32_t width, height;
+    size_t bytes;  // Every level, as stored on the GPU
+};
+
+// Loads textures without stalling the frame. load() returns a texture name at
+// once, holding a 1x1 placeholder; workers decode the file (or map its cooked
+// .tex) and build the mip chain, and update() on the GL thread copies the
+// levels into a ring of pixel unpack buffers and uploads from there, a band
+// of rows at a time, until the per-frame byte budget is spent. Levels go up
+// smallest first and BASE_LEVEL drops as each one completes, so the texture
+// goes from the placeholder through blurry to full detail and never samples
+// a level that is still arriving. The name never changes, so whoever holds it
+// sees the real image once it is in.
+// GL 3.3 has no persistent mapping; the ring is a StreamBuffer, which maps
+// each allocation unsynchronized and fences a region before reusing it.
+class AsyncTextureLoader {
+public:
+    size_t uploadBudget;  // Bytes per update(); at least one band always goes up so nothing starves
+    glm::vec4 placeholderColor = glm::vec4(0.5f, 0.5f, 0.5f, 1.0f);
+
+    explicit AsyncTextureLoader(ThreadPool& workerPool, size_t bytesPerFrame = 4 << 20)
+        : uploadBudget(bytesPerFrame), pool(workerPool), staging(GL_PIXEL_UNPACK_BUFFER, bytesPerFrame),
+          shared(std::make_shared<Shared>()) {
+        glState().bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        compressedUploads = supportsS3TC();
+    }
+
+    AsyncTextureLoader(const AsyncTextureLoader&) = delete;
+    AsyncTextureLoader& operator=(const AsyncTextureLoader&) = delete;
+
+    // A texture name that shows the placeholder until the file has been decoded and uploaded
+    GLuint load(const char* path) {
+        GLuint texture;
+        glGenTextures(1, &texture);
+        glState().bindTexture(0, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        uint32_t placeholder = packColor(placeholderColor);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, &placeholder);
+        glState().countIssued(5);
+        loadInto(texture, path);
+        return texture;
+    }
+
+    // Decode 'path' into an existing texture, which keeps its current contents
+    // until the new levels arrive; how hot reload replaces a texture in place
+    void loadInto(GLuint texture, const char* path) {
+        // The workers only see the shared state, so the loader may go away with requests in flight
+        {
+            std::lock_guard<std::mutex> lock(shared->mutex);
+            ++shared->decoding;
+        }
+        std::shared_ptr<Shared> state = shared;
+        std::string file = path;
+        bool compressed = compressedUploads;
+        pool.submit([state, file, texture, compressed] {
+            auto job = std::make_unique<Job>();
+            job->texture = texture;
+            bool ok = decode(file, compressed, *job);
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (ok) state->ready.push_back(std::move(job));
+            else {
+                ++state->failed;
+                state->failedTextures.push_back(texture);
+            }
+            --state->decoding;
+        });
+    }
+
+    // Upload what the workers have finished, within the budget. Call once per
+    // frame on the GL thread; returns how many textures became complete.
+    size_t update() {
+        stats.uploadedBytes = 0;
+        stats.completed = 0;
+        completed.clear();
+        failedTextures.clear();
+        size_t spent = 0;
+
+        while (spent < uploadBudget) {
+            if (!current) {
+                std::lock_guard<std::mutex> lock(shared->mutex);
+                if (shared->ready.empty()) break;
+                current = std::move(shared->ready.front());
+                shared->ready.pop_front();
+            }
+            spent += uploadBand(*current, uploadBudget - spent);
+            if (current->finished) {
+                const Level& base = current->levels[0];
+                completed.push_back({ current->texture, base.width, base.height, current->bytes });
+                ++stats.completed;
+                ++stats.totalCompleted;
+                current.reset();
+            }
+        }
+
+        if (spent > 0) {
+            // Client-memory uploads elsewhere must not read through our buffer
+            glState().bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            staging.endFrame();
+        }
+        stats.uploadedBytes = spent;
+
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        stats.decoding = shared->decoding;
+        stats.waiting = shared->ready.size() + (current ? 1 : 0);
+        stats.failed = shared->failed;
+        failedTextures.swap(shared->failedTextures);
+        return stats.completed;
+    }
+
+    // Nothing left to decode or upload
+    bool idle() {
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        return !current && shared->ready.empty() && shared->decoding == 0;
+    }
+
+    const TextureLoadStats& lastStats() const { return stats; }
+
+    // What finished in the last update()
+    const std::vector<LoadedTexture>& lastCompleted() const { return completed; }
+
+    // Textures whose file failed to decode since the previous update(); they keep what they showed
+    const std::vector<GLuint>& lastFailed() const { return failedTextures; }
+
+private:
+    struct Level {
+        uint32_t width, height;
+        const uint8_t* data;
+    };
+    // A decoded texture and how far its upload has got
+    struct Job {
+        GLuint texture = 0;
+        bool compressed = false;          // BC1 levels from a container
+        TextureContainer container;       // Cooked source; levels point into its mapping
+        std::vector<Image> images;        // Decoded source; levels point into these
+        std::vector<Level> levels;
+        size_t bytes = 0;
+        size_t level = 0;                 // Being uploaded; counts down from the smallest
+        uint32_t row = 0;                 // Next row (block row for BC1) of 'level'
+        bool started = false;
+        bool inPlace = false;             // Same sizes as the texture's current levels: overwrite them
+        bool finished = false;
+    };
+    struct Shared {
+        std::mutex mutex;
+        std::deque<std::unique_ptr<Job>> ready;
+        size_t decoding = 0;
+        size_t failed = 0;
+        std::vector<GLuint> failedTextures;
+    };
+
+    ThreadPool& pool;
+    StreamBuffer staging;
+    std::shared_ptr<Shared> shared;
+    std::unique_ptr<Job> current;
+    bool compressedUploads = false;
+    TextureLoadStats stats;
+    std::vector<LoadedTexture> completed;
+    std::vector<GLuint> failedTextures;
+
+    // Worker side: map the cooked container or the image cache entry when there is one,
+    // otherwise decode and build mips
+    static bool decode(const std::string& path, bool compressedUploads, Job& job) {
+        std::string cooked = cookedTexturePath(path.c_str());
+        if ((!cooked.empty() && job.container.open(cooked.c_str())) ||
+            imageCache().load(path.c_str(), ImageDecodeOptions(), job.container)) {
+            job.compressed = job.container.format() == TextureFormat::BC1 && compressedUploads;
+            if (job.container.format() == TextureFormat::BC1 && !compressedUploads) {
+                for (uint32_t i = 0; i < job.container.levelCount(); ++i) {
+                    job.images.emplace_back();
+                    decodeTextureLevel(job.container, i, job.images.back());
+                }
+            } else {
+                for (uint32_t i = 0; i < job.container.levelCount(); ++i) {
+                    const TextureLevel& level = job.container.level(i);
+                    job.levels.push_back({ level.width, level.height, level.data });
+                    job.bytes += level.size;
+                }
+                return true;
+            }
+        } else {
+            Image image;
+            if (!loadImageThreadSafe(path.c_str(), image)) return false;
+            job.images = buildMipChain(image);
+        }
+        for (const Image& image : job.images) {
+            job.levels.push_back({ static_cast<uint32_t>(image.width), static_cast<uint32_t>(image.height), image.pixels.data() });
+            job.bytes += image.pixels.size();
+        }
+        return true;
+    }
+
+    // GL side: copy up to 'budget' bytes of whole rows (at least one) of the current
+    // level into the unpack ring and upload them; returns the bytes used
+    size_t uploadBand(Job& job, size_t budget) {
+        glState().bindTexture(0, job.texture);
+        if (!job.started) start(job);
+
+        const Level& level = job.levels[job.level];
+        uint32_t rowHeight = job.compressed ? 4 : 1;
+        uint32_t rows = (level.height + rowHeight - 1) / rowHeight;
+        size_t rowBytes = job.compressed ? static_cast<size_t>((level.width + 3) / 4) * 8 : static_cast<size_t>(level.width) * 4;
+        // A level that is sampled while its new storage fills would show undefined rows, so
+        // a single-level texture changing size goes up whole, within this update
+        bool whole = !job.inPlace && job.levels.size() == 1;
+        uint32_t count = whole ? rows : static_cast<uint32_t>(std::min<size_t>(rows - job.row, std::max<size_t>(1, budget / rowBytes)));
+        size_t bytes = count * rowBytes;
+
+        StreamAllocation allocation = staging.allocate(bytes, 4);
+        std::memcpy(allocation.data, level.data + job.row * rowBytes, bytes);
+        staging.commit(allocation);
+
+        GLint mipLevel = static_cast<GLint>(job.level);
+        GLsizei width = static_cast<GLsizei>(level.width), height = static_cast<GLsizei>(level.height);
+        if (job.row == 0 && !job.inPlace) {
+            // Allocate the level with nothing bound to read from, then fill it band by band
+            glState().bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            if (job.compressed) {
+                glCompressedTexImage2D(GL_TEXTURE_2D, mipLevel, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, width, height, 0,
+                                       static_cast<GLsizei>(rows * rowBytes), nullptr);
+            } else {
+                glTexImage2D(GL_TEXTURE_2D, mipLevel, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            }
+            glState().countIssued();
+        }
+
+        glState().bindBuffer(GL_PIXEL_UNPACK_BUFFER, staging.buffer);
+        GLint y = static_cast<GLint>(job.row * rowHeight);
+        GLsizei bandHeight = static_cast<GLsizei>(std::min(level.height - job.row * rowHeight, count * rowHeight));
+        if (job.compressed) {
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, mipLevel, 0, y, width, bandHeight, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT,
+                                      static_cast<GLsizei>(bytes), (void*)allocation.offset);
+        } else {
+            glTexSubImage2D(GL_TEXTURE_2D, mipLevel, 0, y, width, bandHeight, GL_RGBA, GL_UNSIGNED_BYTE,
+                            (void*)allocation.offset);
+        }
+        glState().countIssued();
+
+        job.row += count;
+        if (job.row == rows) {
+            job.row = 0;
+            if (!job.inPlace) {
+                // This level and every smaller one are complete; sample from here down.
+                // Filtering follows MathUtils::loadTexture.
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, mipLevel);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(job.levels.size()) - 1);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, job.levels.size() > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+                glState().countIssued(3);
+            }
+            if (job.level == 0) job.finished = true;
+            else --job.level;
+        }
+        return bytes;
+    }
+
+    // Before the first band: a reload with the same level sizes overwrites them in
+    // place, so the old image stays whole while the bands go up. Otherwise only
+    // level 0 (the placeholder, or the old image) is sampled until a new level is complete.
+    void start(Job& job) {
+        job.started = true;
+        job.level = job.levels.size() - 1;
+        job.inPlace = true;
+        for (size_t i = 0; i < job.levels.size() && job.inPlace; ++i) job.inPlace = matchesStorage(job, i);
+        if (!job.inPlace) {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+            glState().countIssued(2);
+        }
+    }
+
+    bool matchesStorage(const Job& job, size_t index) const {
+        GLint mipLevel = static_cast<GLint>(index), currentWidth = 0, currentHeight = 0, format = 0;
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, mipLevel, GL_TEXTURE_WIDTH, &currentWidth);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, mipLevel, GL_TEXTURE_HEIGHT, &currentHeight);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, mipLevel, GL_TEXTURE_INTERNAL_FORMAT, &format);
+        glState().countIssued(3);
+        GLint wanted = job.compressed ? GL_COMPRESSED_RGBA_S3TC_DXT1_EXT : GL_RGBA8;
+        return currentWidth == static_cast<GLint>(job.levels[index].width) &&
+               currentHeight == static_cast<GLint>(job.levels[index].height) && format == wanted;
+    }
+};
+
+#endif  // ASYNC_TEXTURE_LOADER_H
@@ -0,0 +1,426 @@
+#ifndef ATLAS_PACKER_H
+#define ATLAS_PACKER_H
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <climits>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "image.h"
+
+// Integer rectangle in atlas pixel space
+struct PackRect {
+    int x, y, width, height;
+};
+
+// 'path' as seen from the directory holding 'atlasPath', so a table and the
+// files it names can move together
+inline std::string atlasRelativePath(const std::string& path, const std::string& atlasPath) {
+    namespace fs = std::filesystem;
+    fs::path base = fs::absolute(fs::path(atlasPath)).parent_path().lexically_normal();
+    fs::path relative = fs::absolute(fs::path(path)).lexically_normal().lexically_relative(base);
+    return relative.empty() ? path : relative.generic_string();
+}
+
+enum class PackHeuristic { MaxRectsBestShortSide, MaxRectsBestArea, MaxRectsBottomLeft, Skyline };
+
+// MaxRects bin packer (Jylänki): keeps the list of maximal free rectangles
+// and places each new rectangle into the best-scoring one
+class MaxRectsPacker {
+public:
+    void init(int width, int height) {
+        binWidth = width;
+        binHeight = height;
+        freeRects.clear();
+        newFreeRects.clear();
+        freeRects.push_back({ 0, 0, width, height });
+    }
+
+    bool insert(int width, int height, PackHeuristic heuristic, PackRect& out) {
+        int bestScore1 = INT_MAX, bestScore2 = INT_MAX;
+        bool found = false;
+
+        for (const PackRect& free : freeRects) {
+            if (free.width < width || free.height < height) continue;
+
+            int leftoverX = free.width - width;
+            int leftoverY = free.height - height;
+            int score1, score2;
+            switch (heuristic) {
+            case PackHeuristic::MaxRectsBestArea:
+                score1 = free.width * free.height - width * height;
+                score2 = std::min(leftoverX, leftoverY);
+                break;
+            case PackHeuristic::MaxRectsBottomLeft:
+                score1 = free.y + height;
+                score2 = free.x;
+                break;
+            default:
+                score1 = std::min(leftoverX, leftoverY);
+                score2 = std::max(leftoverX, leftoverY);
+                break;
+            }
+
+            if (score1 < bestScore1 || (score1 == bestScore1 && score2 < bestScore2)) {
+                bestScore1 = score1;
+                bestScore2 = score2;
+                out = { free.x, free.y, width, height };
+                found = true;
+            }
+        }
+
+        if (found) place(out);
+        return found;
+    }
+
+    size_t freeRectCount() const { return freeRects.size(); }
+
+private:
+    int binWidth = 0, binHeight = 0;
+    std::vector<PackRect> freeRects;
+    std::vector<PackRect> newFreeRects;
+    size_t newFreeRectsLastSize = 0;
+
+    static bool contains(const PackRect& outer, const PackRect& inner) {
+        return inner.x >= outer.x && inner.y >= outer.y &&
+               inner.x + inner.width <= outer.x + outer.width &&
+               inner.y + inner.height <= outer.y + outer.height;
+    }
+
+    void place(const PackRect& used) {
+        for (size_t i = 0; i < freeRects.size();) {
+            if (splitFreeRect(freeRects[i], used)) {
+                freeRects[i] = freeRects.back();
+                freeRects.pop_back();
+            } else {
+                ++i;
+            }
+        }
+        pruneFreeList();
+    }
+
+    // Replace a free rectangle that overlaps 'used' with up to four maximal leftovers
+    bool splitFreeRect(const PackRect& free, const PackRect& used) {
+        if (used.x >= free.x + free.width || used.x + used.width <= free.x ||
+            used.y >= free.y + free.height || used.y + used.height <= free.y) {
+            return false;
+        }
+
+        newFreeRectsLastSize = newFreeRects.size();
+
+        if (used.x < free.x + free.width && used.x + used.width > free.x) {
+            if (used.y > free.y && used.y < free.y + free.height) {
+                PackRect below = free;
+                below.height = used.y - free.y;
+                insertNewFreeRect(below);
+            }
+            if (used.y + used.height < free.y + free.height) {
+                PackRect above = free;
+                above.y = used.y + used.height;
+                above.height = free.y + free.height - above.y;
+                insertNewFreeRect(above);
+            }
+        }
+
+        if (used.y < free.y + free.height && used.y + used.height > free.y) {
+            if (used.x > free.x && used.x < free.x + free.width) {
+                PackRect left = free;
+                left.width = used.x - free.x;
+                insertNewFreeRect(left);
+            }
+            if (used.x + used.width < free.x + free.width) {
+                PackRect right = free;
+                right.x = used.x + used.width;
+                right.width = free.x + free.width - right.x;
+                insertNewFreeRect(right);
+            }
+        }
+        return true;
+    }
+
+    // Only compare against leftovers from earlier splits; siblings from one split never contain each other
+    void insertNewFreeRect(const PackRect& rect) {
+        for (size_t i = 0; i < newFreeRectsLastSize;) {
+            if (contains(newFreeRects[i], rect)) return;
+            if (contains(rect, newFreeRects[i])) {
+                newFreeRects[i] = newFreeRects[--newFreeRectsLastSize];
+                newFreeRects[newFreeRectsLastSize] = newFreeRects.back();
+                newFreeRects.pop_back();
+            } else {
+                ++i;
+            }
+        }
+        newFreeRects.push_back(rect);
+    }
+
+    // New leftovers only shrink, so it is enough to test them against the old list
+    void pruneFreeList() {
+        for (const PackRect& old : freeRects) {
+            for (size_t j = 0; j < newFreeRects.size();) {
+                if (contains(old, newFreeRects[j])) {
+                    newFreeRects[j] = newFreeRects.back();
+                    newFreeRects.pop_back();
+                } else {
+                    ++j;
+                }
+            }
+        }
+        freeRects.insert(freeRects.end(), newFreeRects.begin(), newFreeRects.end());
+        newFreeRects.clear();
+    }
+};
+
+// Skyline bottom-left packer: cheaper than MaxRects, slightly less dense
+class SkylinePacker {
+public:
+    void init(int width, int height) {
+        binWidth = width;
+        binHeight = height;
+        skyline.clear();
+        skyline.push_back({ 0, 0, width });
+    }
+
+    bool insert(int width, int height, PackRect& out) {
+        int bestTop = INT_MAX, bestWidth = INT_MAX;
+        int bestIndex = -1;
+
+        for (size_t i = 0; i < skyline.size(); ++i) {
+            int y;
+            if (!fits(i, width, height, y)) continue;
+            if (y + height < bestTop || (y + height == bestTop && skyline[i].width < bestWidth)) {
+                bestTop = y + height;
+                bestWidth = skyline[i].width;
+                bestIndex = static_cast<int>(i);
+                out = { skyline[i].x, y, width, height };
+            }
+        }
+
+        if (bestIndex < 0) return false;
+        addLevel(bestIndex, out);
+        return true;
+    }
+
+private:
+    struct Segment {
+        int x, y, width;
+    };
+
+    int binWidth = 0, binHeight = 0;
+    std::vector<Segment> skyline;
+
+    // Lowest y at which a rectangle starting at segment 'index' rests on the skyline
+    bool fits(size_t index, int width, int height, int& y) const {
+        int x = skyline[index].x;
+        if (x + width > binWidth) return false;
+
+        int widthLeft = width;
+        y = skyline[index].y;
+        for (size_t i = index; widthLeft > 0; ++i) {
+            y = std::max(y, skyline[i].y);
+            if (y + height > binHeight) return false;
+            widthLeft -= skyline[i].width;
+        }
+        return true;
+    }
+
+    void addLevel(int index, const PackRect& rect) {
+        skyline.insert(skyline.begin() + index, { rect.x, rect.y + rect.height, rect.width });
+
+        // Trim or drop the segments now covered by the new one
+        for (size_t i = index + 1; i < skyline.size();) {
+            const Segment& prev = skyline[i - 1];
+            int overlap = prev.x + prev.width - skyline[i].x;
+            if (overlap <= 0) break;
+
+            skyline[i].x += overlap;
+            skyline[i].width -= overlap;
+            if (skyline[i].width > 0) break;
+            skyline.erase(skyline.begin() + i);
+        }
+
+        // Merge neighbours at the same height
+        for (size_t i = 0; i + 1 < skyline.size();) {
+            if (skyline[i].y == skyline[i + 1].y) {
+                skyline[i].width += skyline[i + 1].width;
+                skyline.erase(skyline.begin() + i + 1);
+            } else {
+                ++i;
+            }
+        }
+    }
+};
+
+// A packed sprite: pixel rect of the sprite itself (without padding/extrusion) and its UVs
+struct AtlasRegion {
+    std::string name;
+    int x, y, width, height;
+    glm::vec4 uv;  // u0, v0, u1, v1
+};
+
+// Packs sprites into one RGBA8 page with padding between slots and edge
+// extrusion around each sprite so bilinear filtering never samples a neighbour
+class AtlasPacker {
+public:
+    int width, height;
+    int padding;  // Empty texels between neighbouring slots
+    int extrude;  // Texels of edge replication around every sprite
+    PackHeuristic heuristic;
+
+    AtlasPacker(int w, int h, int pad = 2, int ext = 1, PackHeuristic heur = PackHeuristic::MaxRectsBestShortSide)
+        : width(w), height(h), padding(pad), extrude(ext), heuristic(heur) {
+        clear();
+    }
+
+    void clear() {
+        maxRects.init(width, height);
+        skyline.init(width, height);
+        regions.clear();
+        lookup.clear();
+        spriteArea = 0;
+        usedWidth = 0;
+        usedHeight = 0;
+        lastSlot = { 0, 0, 0, 0 };
+    }
+
+    // Reserve space for a sprite without touching pixels; returns the region index or -1 when full
+    int pack(const std::string& name, int spriteWidth, int spriteHeight) {
+        int slotWidth = spriteWidth + 2 * extrude + padding;
+        int slotHeight = spriteHeight + 2 * extrude + padding;
+
+        PackRect slot;
+        bool packed = heuristic == PackHeuristic::Skyline
+            ? skyline.insert(slotWidth, slotHeight, slot)
+            : maxRects.insert(slotWidth, slotHeight, heuristic, slot);
+        if (!packed) return -1;
+
+        AtlasRegion region;
+        region.name = name;
+        region.x = slot.x + extrude;
+        region.y = slot.y + extrude;
+        region.width = spriteWidth;
+        region.height = spriteHeight;
+        region.uv = glm::vec4(
+            static_cast<float>(region.x) / width,
+            static_cast<float>(region.y) / height,
+            static_cast<float>(region.x + spriteWidth) / width,
+            static_cast<float>(region.y + spriteHeight) / height);
+
+        spriteArea += static_cast<long long>(spriteWidth) * spriteHeight;
+        usedWidth = std::max(usedWidth, slot.x + slot.width);
+        usedHeight = std::max(usedHeight, slot.y + slot.height);
+        lastSlot = slot;
+
+        lookup[name] = static_cast<int>(regions.size());
+        regions.push_back(region);
+        return static_cast<int>(regions.size()) - 1;
+    }
+
+    // Pack a sprite and copy its pixels (plus extruded border) into the page
+    int add(const std::string& name, const Image& sprite) {
+        int index = pack(name, sprite.width, sprite.height);
+        if (index < 0) return -1;
+
+        if (page.empty()) page = Image(width, height);
+        const AtlasRegion& region = regions[index];
+
+        for (int dy = -extrude; dy < sprite.height + extrude; ++dy) {
+            int sy = std::min(std::max(dy, 0), sprite.height - 1);
+            for (int dx = -extrude; dx < sprite.width + extrude; ++dx) {
+                int sx = std::min(std::max(dx, 0), sprite.width - 1);
+                std::memcpy(page.pixel(region.x + dx, region.y + dy), sprite.pixel(sx, sy), 4);
+            }
+        }
+        return index;
+    }
+
+    int find(const std::string& name) const {
+        auto it = lookup.find(name);
+        return it == lookup.end() ? -1 : it->second;
+    }
+
+    const std::vector<AtlasRegion>& getRegions() const { return regions; }
+    const Image& getPage() const { return page; }
+
+    // Slot (with padding and extrusion) of the most recent pack(), for partial uploads
+    const PackRect& lastSlotRect() const { return lastSlot; }
+
+    // Sprite texels over the bounding box of all slots; the packing efficiency metric
+    float occupancy() const {
+        if (usedWidth == 0 || usedHeight == 0) return 0.0f;
+        return static_cast<float>(spriteArea) / (static_cast<float>(usedWidth) * usedHeight);
+    }
+
+    // Save the UV lookup table as text next to the page image
+    bool save(const std::string& atlasPath, const std::string& imagePath) const {
+        if (!writeTGA(imagePath.c_str(), page.empty() ? Image(width, height) : page)) return false;
+
+        std::ofstream outFile(atlasPath);
+        if (!outFile) {
+            std::cerr << "Failed to open file for saving: " << atlasPath << std::endl;
+            return false;
+        }
+
+        outFile << std::quoted(atlasRelativePath(imagePath, atlasPath)) << " " << width << " " << height << " "
+                << padding << " " << extrude << "\n";
+        outFile << regions.size() << "\n";
+        for (const AtlasRegion& region : regions) {
+            outFile << std::quoted(region.name) << " " << region.x << " " << region.y << " "
+                    << region.width << " " << region.height << "\n";
+        }
+        return true;
+    }
+
+    // Load a table written by save(); the page image path, resolved against the
+    // table's directory, is returned for the caller to decode
+    bool load(const std::string& atlasPath, std::string& imagePath) {
+        std::ifstream inFile(atlasPath);
+        if (!inFile) {
+            std::cerr << "Failed to open file for loading: " << atlasPath << std::endl;
+            return false;
+        }
+
+        size_t count = 0;
+        inFile >> std::quoted(imagePath) >> width >> height >> padding >> extrude >> count;
+        std::filesystem::path page(imagePath);
+        if (page.is_relative()) imagePath = (std::filesystem::path(atlasPath).parent_path() / page).lexically_normal().string();
+        clear();
+        for (size_t i = 0; i < count && inFile; ++i) {
+            AtlasRegion region;
+            inFile >> std::quoted(region.name) >> region.x >> region.y >> region.width >> region.height;
+            region.uv = glm::vec4(
+                static_cast<float>(region.x) / width,
+                static_cast<float>(region.y) / height,
+                static_cast<float>(region.x + region.width) / width,
+                static_cast<float>(region.y + region.height) / height);
+            lookup[region.name] = static_cast<int>(regions.size());
+            regions.push_back(region);
+        }
+
+        if (!inFile) {
+            std::cerr << "Malformed atlas file: " << atlasPath << std::endl;
+            return false;
+        }
+        // A loaded table is read-only: new sprites go to a fresh page
+        maxRects.init(0, 0);
+        skyline.init(0, 0);
+        return true;
+    }
+
+private:
+    MaxRectsPacker maxRects;
+    SkylinePacker skyline;
+    std::vector<AtlasRegion> regions;
+    std::unordered_map<std::string, int> lookup;
+    Image page;
+    long long spriteArea = 0;
+    int usedWidth = 0;
+    int usedHeight = 0;
+    PackRect lastSlot;
+};
+
+#endif  // ATLAS_PACKER_H
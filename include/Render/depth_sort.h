@@ -0,0 +1,103 @@
+#ifndef DEPTH_SORT_H
+#define DEPTH_SORT_H
+
+#include <cstdint>
+#include <vector>
+#include "render_queue.h"
+
+// Counters for the last DepthOrder::update
+struct DepthSortStats {
+    size_t count = 0;
+    size_t shifts = 0;        // Elements moved by the insertion sort
+    bool usedRadix = false;   // Disorder exceeded the budget and the radix sort ran
+};
+
+// Persistent back-to-front order for one y-sorted layer. Objects barely move
+// between frames, so last frame's order is almost sorted and an insertion sort
+// finishes in close to O(n). Once it averages more than 'shiftBudget' shifts per
+// element (teleports, a fresh scene) it stops and a radix sort runs instead.
+// Larger depth draws first, so pass y for top-down scenes; ties break by id, so
+// both paths produce the same order.
+class DepthOrder {
+public:
+    size_t shiftBudget = 8;
+
+    // depth[id] for ids [0, count). Ids past the old count are appended, ids
+    // that no longer exist are dropped.
+    void update(const float* depth, size_t count) {
+        stats = DepthSortStats();
+        stats.count = count;
+        resize(count);
+
+        // Checked against the budget for the part sorted so far, so heavy disorder bails out early
+        const size_t slack = 1024;
+        for (size_t i = 1; i < count; ++i) {
+            uint32_t id = order[i];
+            float key = depth[id];
+            size_t j = i;
+            while (j > 0 && drawsBefore(key, id, depth[order[j - 1]], order[j - 1])) {
+                order[j] = order[j - 1];
+                --j;
+            }
+            order[j] = id;
+            stats.shifts += i - j;
+            if (stats.shifts > shiftBudget * (i + slack)) {
+                radixSort(depth);
+                return;
+            }
+        }
+    }
+
+    // Ids back to front
+    const std::vector<uint32_t>& ids() const { return order; }
+    const DepthSortStats& lastStats() const { return stats; }
+
+    // Queue commands[id] in this order. Keys carry the rank as depth, so the
+    // layer stays in order and RenderQueue::sort skips work when it is already sorted.
+    void submit(RenderQueue& queue, uint8_t layer, const RenderCommand* commands) const {
+        for (size_t rank = 0; rank < order.size(); ++rank) {
+            const RenderCommand& cmd = commands[order[rank]];
+            queue.submit(SortKey::ordered(layer, static_cast<uint32_t>(rank), cmd.shader, cmd.texture), cmd);
+        }
+    }
+
+private:
+    std::vector<uint32_t> order;
+    std::vector<SortEntry> entries;
+    std::vector<SortEntry> scratch;
+    DepthSortStats stats;
+
+    static bool drawsBefore(float depthA, uint32_t idA, float depthB, uint32_t idB) {
+        return depthA > depthB || (depthA == depthB && idA < idB);
+    }
+
+    void resize(size_t count) {
+        if (count == order.size()) return;
+        if (count < order.size()) {
+            size_t kept = 0;
+            for (uint32_t id : order) {
+                if (id < count) order[kept++] = id;
+            }
+            order.resize(count);
+            return;
+        }
+        for (size_t id = order.size(); id < count; ++id) order.push_back(static_cast<uint32_t>(id));
+    }
+
+    void radixSort(const float* depth) {
+        size_t count = order.size();
+        entries.resize(count);
+        scratch.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t id = order[i];
+            // Inverted so larger depth sorts first, id below it for the tie-break
+            entries[i].key = (static_cast<uint64_t>(~SortKey::depthFromFloat(depth[id])) << 32) | id;
+            entries[i].index = id;
+        }
+        radixSortEntries(entries.data(), scratch.data(), count);
+        for (size_t i = 0; i < count; ++i) order[i] = entries[i].index;
+        stats.usedRadix = true;
+    }
+};
+
+#endif  // DEPTH_SORT_H
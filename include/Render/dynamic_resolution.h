@@ -0,0 +1,192 @@
+#ifndef DYNAMIC_RESOLUTION_H
+#define DYNAMIC_RESOLUTION_H
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "gl_state.h"
+#include "render_target.h"
+
+// GPU time per frame from GL_TIME_ELAPSED queries. Results are read a few
+// frames late from a ring, so measuring never waits for the GPU.
+class GpuFrameTimer {
+public:
+    explicit GpuFrameTimer(int depth = 4) : queries(depth), issued(depth, false) {
+        glGenQueries(depth, queries.data());
+    }
+
+    ~GpuFrameTimer() { glDeleteQueries(static_cast<GLsizei>(queries.size()), queries.data()); }
+
+    GpuFrameTimer(const GpuFrameTimer&) = delete;
+    GpuFrameTimer& operator=(const GpuFrameTimer&) = delete;
+
+    // Bracket the GPU work of one frame; only one timer may be running at a time
+    void begin() {
+        glBeginQuery(GL_TIME_ELAPSED, queries[head]);
+        glState().countIssued();
+    }
+
+    void end() {
+        glEndQuery(GL_TIME_ELAPSED);
+        issued[head] = true;
+        head = (head + 1) % queries.size();
+        glState().countIssued();
+    }
+
+    // Newest finished measurement in milliseconds, or a negative value if none finished since the last call
+    float poll() {
+        float result = -1.0f;
+        while (issued[tail]) {
+            GLint available = 0;
+            glGetQueryObjectiv(queries[tail], GL_QUERY_RESULT_AVAILABLE, &available);
+            glState().countIssued();
+            // The query about to be reused must be drained even if that means waiting
+            if (!available && tail != head) break;
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(queries[tail], GL_QUERY_RESULT, &nanoseconds);
+            glState().countIssued();
+            result = static_cast<float>(nanoseconds * 1e-6);
+            issued[tail] = false;
+            tail = (tail + 1) % queries.size();
+        }
+        return result;
+    }
+
+private:
+    std::vector<GLuint> queries;
+    std::vector<bool> issued;
+    size_t head = 0;  // Next query to begin
+    size_t tail = 0;  // Oldest query not read yet
+};
+
+// Picks the render scale from measured frame times. A PID controller in
+// velocity form moves a continuous scale toward the frame budget; the scale
+// actually used is quantized to buckets and only changes once the continuous
+// value is well past the bucket edge and the last change has had time to
+// show up in the measurements, so the target is not reallocated every frame.
+// Going up also requires the next bucket to be predicted to fit the budget;
+// otherwise a load between two buckets would flip between them forever.
+class ResolutionController {
+public:
+    float targetFrameMs = 1000.0f / 60.0f;
+    float minScale = 0.5f;
+    float maxScale = 1.0f;
+    float scaleStep = 0.125f;    // Bucket size
+    float hysteresis = 0.5f;     // Extra distance past a bucket edge, in buckets, before switching
+    int settleFrames = 20;       // Frames ignored after a switch while the new cost shows up
+    float kp = 0.3f, ki = 0.05f, kd = 0.1f;
+    float smoothing = 0.2f;      // Weight of a new sample in the smoothed frame time
+
+    // Feed one frame time; returns true when the bucket changed
+    bool update(float frameMs) {
+        if (frameMs <= 0.0f) return false;
+        smoothedMs = smoothedMs > 0.0f ? smoothedMs + (frameMs - smoothedMs) * smoothing : frameMs;
+
+        // Positive error means headroom. Pixel cost grows with scale squared, so
+        // the error is taken on the square root of the time ratio.
+        float error = std::sqrt(targetFrameMs / smoothedMs) - 1.0f;
+        float delta = kp * (error - previousError) + ki * error + kd * (error - 2.0f * previousError + olderError);
+        olderError = previousError;
+        previousError = error;
+        // Clamping the state is the anti-windup, including headroom the next bucket could not use
+        float up = std::min(current + scaleStep, maxScale);
+        bool upFits = smoothedMs * (up * up) / (current * current) < targetFrameMs;
+        continuous = std::clamp(continuous + delta, minScale, upFits ? maxScale : current);
+
+        if (framesSinceChange < settleFrames) {
+            ++framesSinceChange;
+            return false;
+        }
+        float threshold = scaleStep * (0.5f + hysteresis);
+        float next = current;
+        if (up > current && continuous >= std::min(current + threshold, maxScale)) next = up;
+        if (continuous <= std::max(current - threshold, minScale)) next = std::max(current - scaleStep, minScale);
+        if (next == current) return false;
+        current = next;
+        framesSinceChange = 0;
+        ++changes;
+        return true;
+    }
+
+    // Bucketed scale to render at
+    float scale() const { return current; }
+    float continuousScale() const { return continuous; }
+    float frameMs() const { return smoothedMs; }
+    uint32_t bucketChanges() const { return changes; }
+
+private:
+    float current = 1.0f;
+    float continuous = 1.0f;
+    float smoothedMs = 0.0f;
+    float previousError = 0.0f;
+    float olderError = 0.0f;
+    int framesSinceChange = 0;
+    uint32_t changes = 0;
+};
+
+// World rendering at a lower internal resolution, upscaled to the window with
+// a linear blit. At full scale it renders straight into the window instead,
+// so the feature costs nothing when the machine keeps up. Storage is
+// reallocated lazily in begin(), only when the bucket or window size changed.
+class DynamicResolution {
+public:
+    ResolutionController controller;
+
+    // Window framebuffer size, e.g. from the GLFW resize callback
+    void setOutputSize(int width, int height) {
+        outputWidth = width;
+        outputHeight = height;
+    }
+
+    // Feed a frame time in milliseconds
+    void update(float frameMs) { controller.update(frameMs); }
+
+    // Size the world is rendered at this frame
+    int width() const { return std::max(1, static_cast<int>(std::lround(outputWidth * controller.scale()))); }
+    int height() const { return std::max(1, static_cast<int>(std::lround(outputHeight * controller.scale()))); }
+    bool scaled() const { return width() != outputWidth || height() != outputHeight; }
+
+    // Bind where the world should be drawn, covering width() x height().
+    // 'offscreen' keeps it in a texture even at full scale, for post-processing.
+    void begin(bool offscreen = false) {
+        drawnOffscreen = offscreen || scaled();
+        if (!drawnOffscreen) {
+            RenderTarget::bindDefault(outputWidth, outputHeight);
+            return;
+        }
+        if (target.width != width() || target.height != height()) {
+            target.resize(width(), height());
+            ++reallocationCount;
+        }
+        target.bind();
+    }
+
+    // Texture the world went into this frame; 0 when it went straight to the window
+    GLuint sceneTexture() const { return drawnOffscreen ? target.colorTexture : 0; }
+
+    // Upscale into the window and leave it bound for overlays drawn at full resolution.
+    // A post pass reading sceneTexture() can write the window itself instead.
+    void present() {
+        if (drawnOffscreen) {
+            glState().bindFramebuffer(GL_READ_FRAMEBUFFER, target.framebuffer);
+            glState().bindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+            glBlitFramebuffer(0, 0, target.width, target.height, 0, 0, outputWidth, outputHeight,
+                              GL_COLOR_BUFFER_BIT, GL_LINEAR);
+            glState().countIssued();
+        }
+        RenderTarget::bindDefault(outputWidth, outputHeight);
+    }
+
+    uint32_t reallocations() const { return reallocationCount; }
+
+private:
+    RenderTarget target;
+    bool drawnOffscreen = false;
+    int outputWidth = 1;
+    int outputHeight = 1;
+    uint32_t reallocationCount = 0;
+};
+
+#endif  // DYNAMIC_RESOLUTION_H
@@ -0,0 +1,114 @@
+#ifndef FRAME_READBACK_H
+#define FRAME_READBACK_H
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "gl_state.h"
+#include "image.h"
+
+// Asynchronous glReadPixels through a ring of pixel pack buffers. A read only
+// queues a copy into a PBO; the pixels are mapped a few frames later, once the
+// fence says the GPU wrote them, so capture does not drain the pipeline.
+// Frames come out in the order they were requested.
+class FrameReadback {
+public:
+    explicit FrameReadback(int depth = 3) : slots(depth) {
+        for (Slot& slot : slots) glGenBuffers(1, &slot.buffer);
+    }
+
+    ~FrameReadback() {
+        for (Slot& slot : slots) {
+            if (slot.fence) glDeleteSync(slot.fence);
+            glState().deleteBuffer(slot.buffer);
+        }
+    }
+
+    FrameReadback(const FrameReadback&) = delete;
+    FrameReadback& operator=(const FrameReadback&) = delete;
+
+    // Queue a copy of the bound read framebuffer. If every slot is still in
+    // flight the oldest is finished first and handed to onReady(frame, image).
+    template <typename Fn>
+    void request(int width, int height, uint64_t frame, Fn&& onReady) {
+        Slot& slot = slots[(head + pending) % slots.size()];
+        if (pending == slots.size()) {
+            ++stallCount;
+            deliverOldest(onReady);
+        }
+
+        size_t bytes = static_cast<size_t>(width) * height * 4;
+        glState().bindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        if (slot.capacity < bytes) {
+            glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+            slot.capacity = bytes;
+            glState().countIssued();
+        }
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glState().bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        glState().countIssued(2);
+
+        slot.width = width;
+        slot.height = height;
+        slot.frame = frame;
+        ++pending;
+    }
+
+    // Hand over every finished frame; with 'wait' also block for the ones still in flight
+    template <typename Fn>
+    void collect(Fn&& onReady, bool wait = false) {
+        while (pending > 0) {
+            Slot& slot = slots[head];
+            if (!wait) {
+                GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+                glState().countIssued();
+                if (status == GL_TIMEOUT_EXPIRED) return;
+            }
+            deliverOldest(onReady);
+        }
+    }
+
+    // Requests that had to wait for an older frame because the ring was full
+    uint32_t stalls() const { return stallCount; }
+
+private:
+    struct Slot {
+        GLuint buffer = 0;
+        GLsync fence = nullptr;
+        size_t capacity = 0;
+        int width = 0, height = 0;
+        uint64_t frame = 0;
+    };
+
+    std::vector<Slot> slots;
+    size_t head = 0;     // Oldest in-flight slot
+    size_t pending = 0;  // Slots in flight
+    uint32_t stallCount = 0;
+    Image image;         // Reused between frames
+
+    template <typename Fn>
+    void deliverOldest(Fn& onReady) {
+        Slot& slot = slots[head];
+        glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+
+        if (image.width != slot.width || image.height != slot.height) image = Image(slot.width, slot.height);
+        glState().bindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, image.pixels.size(), GL_MAP_READ_BIT);
+        if (pixels) {
+            std::memcpy(image.pixels.data(), pixels, image.pixels.size());
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glState().bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        glState().countIssued(4);
+
+        head = (head + 1) % slots.size();
+        --pending;
+        if (pixels) onReady(slot.frame, static_cast<const Image&>(image));
+    }
+};
+
+#endif  // FRAME_READBACK_H
@@ -0,0 +1,86 @@
+#ifndef GL_BACKEND_H
+#define GL_BACKEND_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include "gl_state.h"
+#include "image.h"
+#include "render_backend.h"
+#include "render_builder.h"
+#include "render_queue.h"
+#include "shader.h"
+#include "sprite_batch.h"
+#include "stream_buffer.h"
+#include "texture_upload.h"
+
+// RenderBackend on the current GL context: the sprite program, camera UBO,
+// vertex stream and batcher the game loop used to own directly
+class GLRenderBackend : public RenderBackend {
+public:
+    Shader spriteProgram;
+    CameraUniformBuffer cameraBuffer;
+    StreamBuffer vertexStream;
+    SpriteBatcher batcher;
+
+    explicit GLRenderBackend(ParallelRenderBuilder* renderBuilder = nullptr)
+        : spriteProgram(SPRITE_VERTEX_SHADER, SPRITE_FRAGMENT_SHADER),
+          vertexStream(GL_ARRAY_BUFFER, 1 << 20),
+          batcher(vertexStream),
+          builder(renderBuilder) {
+        spriteId = batcher.addShader(spriteProgram);
+    }
+
+    // Same sampler setup as MathUtils::loadTexture
+    uint32_t createTexture(const Image& image) override {
+        GLuint texture;
+        glGenTextures(1, &texture);
+        glState().bindTexture(0, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, image.width, image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                     image.pixels.data());
+        glGenerateMipmap(GL_TEXTURE_2D);
+        return texture;
+    }
+
+    // All stored levels go up directly; no decode, no glGenerateMipmap
+    uint32_t createCookedTexture(const TextureContainer& container) override {
+        return uploadTextureContainer(container);
+    }
+
+    void destroyTexture(uint32_t texture) override {
+        glState().deleteTexture(texture);
+    }
+
+    void setSpriteMeshes(const SpriteMeshTable* meshes) override { batcher.meshes = meshes; }
+
+    uint8_t spriteShader() const override { return spriteId; }
+
+    void beginFrame(int width, int height, const glm::vec4& clearColor) override {
+        glState().viewport(0, 0, width, height);
+        glClearColor(clearColor.r, clearColor.g, clearColor.b, clearColor.a);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glState().countIssued(2);
+    }
+
+    void setCamera(const glm::mat4& projection, const glm::mat4& view) override {
+        cameraBuffer.update(projection, view);
+    }
+
+    void draw(const RenderQueue& sortedQueue) override {
+        batcher.draw(sortedQueue, builder);
+    }
+
+    void endFrame() override {
+        vertexStream.endFrame();
+    }
+
+private:
+    ParallelRenderBuilder* builder;
+    uint8_t spriteId = 0;
+};
+
+#endif  // GL_BACKEND_H
@@ -0,0 +1,232 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <cstdio>
+
+// Per-frame GL call counters: what reached the driver and what the cache dropped
+struct GLCallStats {
+    uint32_t issued = 0;
+    uint32_t skipped = 0;
+    uint32_t drawCalls = 0;
+};
+
+// Shadow copy of the bindings we touch most. Every bind goes through here so a
+// call that would not change anything never reaches the driver. Only valid for
+// one context, and only if nobody binds behind its back.
+class GLStateCache {
+public:
+    static constexpr int MAX_TEXTURE_UNITS = 16;
+
+    GLStateCache() { invalidate(); }
+
+    // Forget everything, e.g. after third-party code touched GL directly
+    void invalidate() {
+        program = vertexArray = UNKNOWN;
+        activeUnit = UNKNOWN;
+        for (int i = 0; i < MAX_TEXTURE_UNITS; ++i) {
+            textures2D[i] = UNKNOWN;
+            texturesBuffer[i] = UNKNOWN;
+        }
+        for (GLuint& buffer : buffers) buffer = UNKNOWN;
+        blendEnabled = -1;
+        blendSrc = blendDst = UNKNOWN;
+        drawFramebuffer = readFramebuffer = UNKNOWN;
+        viewportRect[0] = viewportRect[1] = viewportRect[2] = viewportRect[3] = -1;
+    }
+
+    void useProgram(GLuint id) {
+        if (program == id) { ++current.skipped; return; }
+        glUseProgram(id);
+        program = id;
+        ++current.issued;
+    }
+
+    void bindVertexArray(GLuint id) {
+        if (vertexArray == id) { ++current.skipped; return; }
+        glBindVertexArray(id);
+        vertexArray = id;
+        buffers[slotFor(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;  // Element binding is VAO state
+        ++current.issued;
+    }
+
+    void activeTexture(GLuint unit) {
+        if (activeUnit == unit) { ++current.skipped; return; }
+        glActiveTexture(GL_TEXTURE0 + unit);
+        activeUnit = unit;
+        ++current.issued;
+    }
+
+    // Bind a texture to a unit; GL_TEXTURE_2D and GL_TEXTURE_BUFFER are tracked
+    void bindTexture(GLuint unit, GLuint id, GLenum target = GL_TEXTURE_2D) {
+        GLuint& bound = target == GL_TEXTURE_BUFFER ? texturesBuffer[unit] : textures2D[unit];
+        if (bound == id) { ++current.skipped; return; }
+        activeTexture(unit);
+        glBindTexture(target, id);
+        bound = id;
+        ++current.issued;
+    }
+
+    void bindBuffer(GLenum target, GLuint id) {
+        int slot = slotFor(target);
+        if (slot < 0) {
+            glBindBuffer(target, id);
+            ++current.issued;
+            return;
+        }
+        if (buffers[slot] == id) { ++current.skipped; return; }
+        glBindBuffer(target, id);
+        buffers[slot] = id;
+        ++current.issued;
+    }
+
+    // glBindBufferBase also replaces the generic binding of that target
+    void bindBufferBase(GLenum target, GLuint index, GLuint id) {
+        glBindBufferBase(target, index, id);
+        int slot = slotFor(target);
+        if (slot >= 0) buffers[slot] = id;
+        ++current.issued;
+    }
+
+    // GL_FRAMEBUFFER binds both the draw and the read framebuffer
+    void bindFramebuffer(GLenum target, GLuint id) {
+        bool draw = target != GL_READ_FRAMEBUFFER, read = target != GL_DRAW_FRAMEBUFFER;
+        if ((!draw || drawFramebuffer == id) && (!read || readFramebuffer == id)) { ++current.skipped; return; }
+        glBindFramebuffer(target, id);
+        if (draw) drawFramebuffer = id;
+        if (read) readFramebuffer = id;
+        ++current.issued;
+    }
+
+    void viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+        if (viewportRect[0] == x && viewportRect[1] == y && viewportRect[2] == width && viewportRect[3] == height) {
+            ++current.skipped;
+            return;
+        }
+        glViewport(x, y, width, height);
+        viewportRect[0] = x;
+        viewportRect[1] = y;
+        viewportRect[2] = width;
+        viewportRect[3] = height;
+        ++current.issued;
+    }
+
+    void setBlend(bool enabled) {
+        if (blendEnabled == static_cast<int>(enabled)) { ++current.skipped; return; }
+        if (enabled) glEnable(GL_BLEND);
+        else glDisable(GL_BLEND);
+        blendEnabled = enabled;
+        ++current.issued;
+    }
+
+    void blendFunc(GLenum src, GLenum dst) {
+        if (blendSrc == src && blendDst == dst) { ++current.skipped; return; }
+        glBlendFunc(src, dst);
+        blendSrc = src;
+        blendDst = dst;
+        ++current.issued;
+    }
+
+    void drawElements(GLenum mode, GLsizei count, GLenum type, const void* indices) {
+        glDrawElements(mode, count, type, indices);
+        ++current.issued;
+        ++current.drawCalls;
+    }
+
+    void drawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type, const void* indices, GLint baseVertex) {
+        glDrawElementsBaseVertex(mode, count, type, const_cast<void*>(indices), baseVertex);
+        ++current.issued;
+        ++current.drawCalls;
+    }
+
+    // Deleted names get recycled by the driver, so drop them from the cache
+    void deleteTexture(GLuint id) {
+        for (int i = 0; i < MAX_TEXTURE_UNITS; ++i) {
+            if (textures2D[i] == id) textures2D[i] = 0;
+            if (texturesBuffer[i] == id) texturesBuffer[i] = 0;
+        }
+        glDeleteTextures(1, &id);
+    }
+
+    void deleteBuffer(GLuint id) {
+        for (GLuint& buffer : buffers) {
+            if (buffer == id) buffer = 0;
+        }
+        glDeleteBuffers(1, &id);
+    }
+
+    void deleteFramebuffer(GLuint id) {
+        if (drawFramebuffer == id) drawFramebuffer = 0;
+        if (readFramebuffer == id) readFramebuffer = 0;
+        glDeleteFramebuffers(1, &id);
+    }
+
+    void deleteProgram(GLuint id) {
+        if (program == id) program = UNKNOWN;
+        glDeleteProgram(id);
+    }
+
+    void deleteVertexArray(GLuint id) {
+        if (vertexArray == id) vertexArray = UNKNOWN;
+        glDeleteVertexArrays(1, &id);
+    }
+
+    // Count a call made outside the cache so the totals stay honest
+    void countIssued(uint32_t calls = 1) { current.issued += calls; }
+    void countDrawCall() { ++current.issued; ++current.drawCalls; }
+
+    // Close the frame: last frame's counters become readable and the running ones reset
+    void endFrame() {
+        lastFrame = current;
+        current = GLCallStats();
+    }
+
+    const GLCallStats& lastFrameStats() const { return lastFrame; }
+
+    // One-line summary for the window title or the log
+    void formatStats(char* buffer, size_t size) const {
+        uint32_t total = lastFrame.issued + lastFrame.skipped;
+        std::snprintf(buffer, size, "GL calls %u/%u (%u skipped), draws %u",
+                      lastFrame.issued, total, lastFrame.skipped, lastFrame.drawCalls);
+    }
+
+private:
+    static constexpr GLuint UNKNOWN = ~0u;
+    static constexpr int BUFFER_SLOTS = 7;
+
+    GLuint program = UNKNOWN;
+    GLuint vertexArray = UNKNOWN;
+    GLuint activeUnit = UNKNOWN;
+    GLuint textures2D[MAX_TEXTURE_UNITS] = {};
+    GLuint texturesBuffer[MAX_TEXTURE_UNITS] = {};
+    GLuint buffers[BUFFER_SLOTS] = {};
+    int blendEnabled = -1;
+    GLenum blendSrc = UNKNOWN, blendDst = UNKNOWN;
+    GLuint drawFramebuffer = UNKNOWN, readFramebuffer = UNKNOWN;
+    GLint viewportRect[4] = { -1, -1, -1, -1 };
+
+    GLCallStats current;
+    GLCallStats lastFrame;
+
+    static int slotFor(GLenum target) {
+        switch (target) {
+        case GL_ARRAY_BUFFER: return 0;
+        case GL_ELEMENT_ARRAY_BUFFER: return 1;
+        case GL_UNIFORM_BUFFER: return 2;
+        case GL_PIXEL_UNPACK_BUFFER: return 3;
+        case GL_PIXEL_PACK_BUFFER: return 4;
+        case GL_TEXTURE_BUFFER: return 5;
+        case GL_COPY_WRITE_BUFFER: return 6;
+        default: return -1;
+        }
+    }
+};
+
+// The cache for the one GL context this app uses
+inline GLStateCache& glState() {
+    static GLStateCache cache;
+    return cache;
+}
+
+#endif  // GL_STATE_H
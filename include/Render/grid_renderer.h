@@ -0,0 +1,104 @@
+#ifndef GRID_RENDERER_H
+#define GRID_RENDERER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "gl_state.h"
+#include "shader.h"
+
+// One quad over the grid's world rectangle, corners from gl_VertexID
+constexpr const char* GRID_VERTEX_SHADER = R"(
+    #version 330 core
+    out vec2 WorldPos;
+
+    layout (std140) uniform Camera {
+        mat4 projection;
+        mat4 view;
+    };
+
+    uniform vec2 gridMin;
+    uniform vec2 gridMax;
+    uniform float cellSize;
+
+    void main() {
+        // Overhang a quarter cell so the outer lines are not cut in half
+        vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+        WorldPos = mix(gridMin - 0.25 * cellSize, gridMax + 0.25 * cellSize, corner);
+        gl_Position = projection * view * vec4(WorldPos, 0.0, 1.0);
+    }
+)";
+
+// Distance to the nearest line in pixels comes from fwidth, so lines keep the
+// same width and stay anti-aliased at any zoom; the grid fades out once cells
+// get too small on screen to read
+constexpr const char* GRID_FRAGMENT_SHADER = R"(
+    #version 330 core
+    out vec4 FragColor;
+    in vec2 WorldPos;
+
+    uniform vec2 gridMin;
+    uniform float cellSize;
+    uniform float lineWidth;
+    uniform vec2 fadeRange;
+    uniform vec4 lineColor;
+
+    void main() {
+        vec2 cell = (WorldPos - gridMin) / cellSize;
+        vec2 pixelsPerCell = 1.0 / fwidth(cell);
+        vec2 distance = abs(fract(cell + 0.5) - 0.5) * pixelsPerCell;
+        float line = min(distance.x, distance.y);
+        float coverage = 1.0 - clamp(line - 0.5 * lineWidth + 0.5, 0.0, 1.0);
+        float fade = smoothstep(fadeRange.x, fadeRange.y, min(pixelsPerCell.x, pixelsPerCell.y));
+        FragColor = vec4(lineColor.rgb, lineColor.a * coverage * fade);
+    }
+)";
+
+// Editor grid in a single draw whatever the map size or zoom
+class GridRenderer {
+public:
+    glm::vec4 lineColor = glm::vec4(0.8f, 0.8f, 0.8f, 0.6f);
+    float lineWidth = 1.0f;                         // Pixels
+    glm::vec2 fadeRange = glm::vec2(4.0f, 12.0f);  // Cell size in pixels: invisible below x, full above y
+
+    GridRenderer() : shader(GRID_VERTEX_SHADER, GRID_FRAGMENT_SHADER) {
+        glGenVertexArrays(1, &vao);  // Core profile needs one bound, even without attributes
+        gridMinLocation = shader.uniform("gridMin");
+        gridMaxLocation = shader.uniform("gridMax");
+        cellSizeLocation = shader.uniform("cellSize");
+        lineWidthLocation = shader.uniform("lineWidth");
+        fadeRangeLocation = shader.uniform("fadeRange");
+        lineColorLocation = shader.uniform("lineColor");
+    }
+
+    ~GridRenderer() { glState().deleteVertexArray(vao); }
+
+    GridRenderer(const GridRenderer&) = delete;
+    GridRenderer& operator=(const GridRenderer&) = delete;
+
+    // Lines every cellSize world units across [origin, origin + cells * cellSize];
+    // uses the Camera block, so call after the camera buffer is updated
+    void draw(const glm::vec2& origin, int columns, int rows, float cellSize) {
+        shader.use();
+        Shader::setVec2(gridMinLocation, origin);
+        Shader::setVec2(gridMaxLocation, origin + glm::vec2(columns, rows) * cellSize);
+        Shader::setFloat(cellSizeLocation, cellSize);
+        Shader::setFloat(lineWidthLocation, lineWidth);
+        Shader::setVec2(fadeRangeLocation, fadeRange);
+        Shader::setVec4(lineColorLocation, lineColor);
+        glState().countIssued(6);
+
+        glState().bindVertexArray(vao);
+        glState().setBlend(true);
+        glState().blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        glState().countDrawCall();
+    }
+
+private:
+    Shader shader;
+    GLuint vao = 0;
+    GLint gridMinLocation, gridMaxLocation, cellSizeLocation;
+    GLint lineWidthLocation, fadeRangeLocation, lineColorLocation;
+};
+
+#endif  // GRID_RENDERER_H
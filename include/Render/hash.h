@@ -0,0 +1,37 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// 64-bit FNV-1a over words in four independent lanes, folded together at the end;
+// several times faster than bytewise over megabytes of pixels. For keys and
+// integrity checks, not for anything adversarial.
+inline uint64_t hashWords(const uint8_t* data, size_t size, uint64_t hash = 0xcbf29ce484222325ull) {
+    const uint64_t prime = 0x100000001b3ull;
+    auto mix = [prime](uint64_t state, uint64_t word) {
+        state = (state ^ word) * prime;
+        return state ^ (state >> 32);
+    };
+    size_t i = 0;
+    if (size >= 32) {
+        uint64_t lanes[4] = { hash, hash ^ 1, hash ^ 2, hash ^ 3 };
+        for (; i + 32 <= size; i += 32) {
+            uint64_t words[4];
+            std::memcpy(words, data + i, 32);
+            for (int lane = 0; lane < 4; ++lane) lanes[lane] = mix(lanes[lane], words[lane]);
+        }
+        hash = lanes[0];
+        for (int lane = 1; lane < 4; ++lane) hash = mix(hash, lanes[lane]);
+    }
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        hash = mix(hash, word);
+    }
+    for (; i < size; ++i) hash = (hash ^ data[i]) * prime;
+    return hash;
+}
+
+#endif  // HASH_H
@@ -0,0 +1,247 @@
+#ifndef IMAGE_H
+#define IMAGE_H
+
+// math_utils.h may already have pulled in stb_image with its implementation
+#ifndef STBI_INCLUDE_STB_IMAGE_H
+#include <stb_image.h>
+#endif
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// CPU-side RGBA8 image, rows stored bottom-up like the GL textures we upload
+struct Image {
+    int width = 0;
+    int height = 0;
+    std::vector<unsigned char> pixels;
+
+    Image() = default;
+    Image(int w, int h) : width(w), height(h), pixels(static_cast<size_t>(w) * h * 4, 0) {}
+
+    bool empty() const { return width == 0 || height == 0; }
+
+    unsigned char* pixel(int x, int y) { return &pixels[(static_cast<size_t>(y) * width + x) * 4]; }
+    const unsigned char* pixel(int x, int y) const { return &pixels[(static_cast<size_t>(y) * width + x) * 4]; }
+};
+
+// Decode an image file into RGBA8, flipped vertically to match loadTexture
+inline bool loadImage(const char* path, Image& out) {
+    int width, height, nrChannels;
+    stbi_set_flip_vertically_on_load(true);
+    unsigned char* data = stbi_load(path, &width, &height, &nrChannels, 4);
+    if (!data) {
+        std::cerr << stbi_failure_reason() << path << std::endl;
+        return false;
+    }
+    out.width = width;
+    out.height = height;
+    out.pixels.assign(data, data + static_cast<size_t>(width) * height * 4);
+    stbi_image_free(data);
+    return true;
+}
+
+// Read a whole file into 'out'. Sources are read rather than mapped, since an
+// editor rewriting one in place would fault a mapping that is still being read.
+inline bool readFile(const char* path, std::vector<uint8_t>& out) {
+    FILE* file = std::fopen(path, "rb");
+    if (!file) return false;
+    bool ok = std::fseek(file, 0, SEEK_END) == 0;
+    long size = ok ? std::ftell(file) : -1;
+    ok = size >= 0 && std::fseek(file, 0, SEEK_SET) == 0;
+    if (ok) {
+        out.resize(static_cast<size_t>(size));
+        ok = std::fread(out.data(), 1, out.size(), file) == out.size();
+    }
+    std::fclose(file);
+    return ok;
+}
+
+// loadImage for any thread, from the file's bytes already in memory: stb's flip
+// flag is set for the calling thread only, then put back to the bottom-up rows
+// every other decode expects. 'path' only names the file in errors.
+inline bool loadImageThreadSafe(const char* path, const std::vector<uint8_t>& bytes, Image& out, bool flip = true) {
+    stbi_set_flip_vertically_on_load_thread(flip ? 1 : 0);
+    int width, height, channels;
+    unsigned char* data = stbi_load_from_memory(bytes.data(), static_cast<int>(bytes.size()), &width, &height, &channels, 4);
+    stbi_set_flip_vertically_on_load_thread(1);
+    if (!data) {
+        std::cerr << stbi_failure_reason() << path << std::endl;
+        return false;
+    }
+    out.width = width;
+    out.height = height;
+    out.pixels.assign(data, data + static_cast<size_t>(width) * height * 4);
+    stbi_image_free(data);
+    return true;
+}
+
+// loadImage for any thread
+inline bool loadImageThreadSafe(const char* path, Image& out, bool flip = true) {
+    std::vector<uint8_t> bytes;
+    if (!readFile(path, bytes)) {
+        std::cerr << "Failed to read image: " << path << std::endl;
+        return false;
+    }
+    return loadImageThreadSafe(path, bytes, out, flip);
+}
+
+// Write an uncompressed 32-bit TGA (bottom-up origin, which stb_image reads back)
+inline bool writeTGA(const char* path, const Image& image) {
+    FILE* file = std::fopen(path, "wb");
+    if (!file) {
+        std::cerr << "Failed to open file for saving: " << path << std::endl;
+        return false;
+    }
+
+    unsigned char header[18] = {};
+    header[2] = 2;  // Uncompressed true-color
+    header[12] = image.width & 0xFF;
+    header[13] = (image.width >> 8) & 0xFF;
+    header[14] = image.height & 0xFF;
+    header[15] = (image.height >> 8) & 0xFF;
+    header[16] = 32;
+    header[17] = 8;  // 8 alpha bits, bottom-left origin
+    std::fwrite(header, 1, sizeof(header), file);
+
+    // TGA stores BGRA
+    std::vector<unsigned char> row(static_cast<size_t>(image.width) * 4);
+    for (int y = 0; y < image.height; ++y) {
+        const unsigned char* src = image.pixel(0, y);
+        for (int x = 0; x < image.width; ++x) {
+            row[x * 4 + 0] = src[x * 4 + 2];
+            row[x * 4 + 1] = src[x * 4 + 1];
+            row[x * 4 + 2] = src[x * 4 + 0];
+            row[x * 4 + 3] = src[x * 4 + 3];
+        }
+        std::fwrite(row.data(), 1, row.size(), file);
+    }
+
+    bool ok = std::ferror(file) == 0;
+    std::fclose(file);
+    return ok;
+}
+
+namespace PNG {
+    inline uint32_t crc32(uint32_t crc, const unsigned char* data, size_t size) {
+        // Function-local static: built once, thread-safe for concurrent writers
+        static const std::array<uint32_t, 256> table = [] {
+            std::array<uint32_t, 256> entries{};
+            for (uint32_t n = 0; n < 256; ++n) {
+                uint32_t c = n;
+                for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                entries[n] = c;
+            }
+            return entries;
+        }();
+        crc = ~crc;
+        for (size_t i = 0; i < size; ++i) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    inline void putU32(std::vector<unsigned char>& out, uint32_t value) {
+        out.push_back(value >> 24);
+        out.push_back((value >> 16) & 0xFF);
+        out.push_back((value >> 8) & 0xFF);
+        out.push_back(value & 0xFF);
+    }
+
+    inline void writeChunk(FILE* file, const char* type, const std::vector<unsigned char>& data) {
+        std::vector<unsigned char> chunk;
+        chunk.reserve(data.size() + 12);
+        putU32(chunk, static_cast<uint32_t>(data.size()));
+        chunk.insert(chunk.end(), type, type + 4);
+        chunk.insert(chunk.end(), data.begin(), data.end());
+        putU32(chunk, crc32(0, chunk.data() + 4, data.size() + 4));
+        std::fwrite(chunk.data(), 1, chunk.size(), file);
+    }
+}
+
+// Write an RGBA8 PNG. Deflate runs in stored (uncompressed) blocks: files are
+// bigger, but capture never waits on compression and any viewer reads them.
+inline bool writePNG(const char* path, const Image& image) {
+    FILE* file = std::fopen(path, "wb");
+    if (!file) {
+        std::cerr << "Failed to open file for saving: " << path << std::endl;
+        return false;
+    }
+
+    static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    std::fwrite(signature, 1, sizeof(signature), file);
+
+    std::vector<unsigned char> header;
+    PNG::putU32(header, image.width);
+    PNG::putU32(header, image.height);
+    header.insert(header.end(), { 8, 6, 0, 0, 0 });  // 8-bit RGBA, no interlace
+    PNG::writeChunk(file, "IHDR", header);
+
+    // Scanlines top-down, each with filter byte 0, wrapped in a zlib stream
+    size_t rowBytes = static_cast<size_t>(image.width) * 4 + 1;
+    std::vector<unsigned char> raw(rowBytes * image.height);
+    for (int y = 0; y < image.height; ++y) {
+        unsigned char* row = &raw[rowBytes * y];
+        row[0] = 0;
+        std::memcpy(row + 1, image.pixel(0, image.height - 1 - y), rowBytes - 1);
+    }
+
+    std::vector<unsigned char> data = { 0x78, 0x01 };
+    data.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+    uint32_t a = 1, b = 0;
+    size_t offset = 0;
+    do {
+        size_t length = std::min<size_t>(65535, raw.size() - offset);
+        data.push_back(offset + length == raw.size() ? 1 : 0);  // BFINAL on the last block
+        data.push_back(length & 0xFF);
+        data.push_back(length >> 8);
+        data.push_back(~length & 0xFF);
+        data.push_back((~length >> 8) & 0xFF);
+        data.insert(data.end(), raw.begin() + offset, raw.begin() + offset + length);
+        offset += length;
+    } while (offset < raw.size());
+
+    // Adler-32, reducing every 5552 bytes (zlib's bound before 32-bit overflow)
+    for (size_t start = 0; start < raw.size(); start += 5552) {
+        size_t end = std::min(raw.size(), start + 5552);
+        for (size_t i = start; i < end; ++i) {
+            a += raw[i];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    PNG::putU32(data, (b << 16) | a);
+    PNG::writeChunk(file, "IDAT", data);
+    PNG::writeChunk(file, "IEND", {});
+
+    bool ok = std::ferror(file) == 0;
+    std::fclose(file);
+    return ok;
+}
+
+// Per-pixel comparison for golden-image tests
+struct ImageDiff {
+    size_t differingPixels = 0;  // Pixels with any channel off by more than the tolerance
+    int maxDelta = 0;            // Largest channel difference seen
+    bool sizeMismatch = false;
+};
+
+inline ImageDiff compareImages(const Image& a, const Image& b, int tolerance) {
+    ImageDiff diff;
+    if (a.width != b.width || a.height != b.height) {
+        diff.sizeMismatch = true;
+        return diff;
+    }
+    for (size_t i = 0; i < a.pixels.size(); i += 4) {
+        int worst = 0;
+        for (int c = 0; c < 4; ++c) worst = std::max(worst, std::abs(int(a.pixels[i + c]) - int(b.pixels[i + c])));
+        diff.maxDelta = std::max(diff.maxDelta, worst);
+        if (worst > tolerance) ++diff.differingPixels;
+    }
+    return diff;
+}
+
+#endif  // IMAGE_H
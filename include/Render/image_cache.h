@@ -0,0 +1,266 @@
+#ifndef IMAGE_CACHE_H
+#define IMAGE_CACHE_H
+
+// math_utils.h may already have pulled in stb_image with its implementation
+#ifndef STBI_INCLUDE_STB_IMAGE_H
+#include <stb_image.h>
+#endif
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "hash.h"
+#include "image.h"
+#include "texture_container.h"
+#include "texture_cook.h"
+
+// Decoder settings that change the pixels, and so are part of the cache key
+struct ImageDecodeOptions {
+    bool flipVertically = true;  // What stbi_set_flip_vertically_on_load(true) gives loadImage
+    bool withMips = true;        // Store the mip chain buildMipChain makes as well
+};
+
+// Counters for ImageCache
+struct ImageCacheStats {
+    std::atomic<size_t> hits{ 0 };
+    std::atomic<size_t> misses{ 0 };
+    std::atomic<size_t> rebuilt{ 0 };  // Entries that failed validation and were decoded again
+    std::atomic<size_t> pruned{ 0 };   // Entries deleted as superseded or past the size budget
+};
+
+// Decoded images kept on disk between runs, so only the first launch pays for
+// JPEG and PNG decoding. Entries are RGBA8 texture containers named after a
+// hash of the source file's bytes and the decode options: an edited source
+// gets a new key, so nothing is ever served stale, copies of one image share
+// an entry, and moving the project keeps every entry. A hit reads and hashes
+// the compressed source, then maps the entry and checks only its header and
+// level table; the level checksum is checked when an entry is written, since
+// checking it on every hit would fault in the whole mapping.
+// An index file maps each source path to the key it last decoded to. When a
+// path moves to a new key, the old entry is deleted unless another path still
+// uses it; after each write the least recently used entries go as well, until
+// the directory is within maxBytes.
+// Safe to call from several threads: entries and the index are written to a
+// temporary file and renamed into place. Processes sharing the directory may
+// drop each other's index lines, which only leaves those entries to the budget.
+class ImageCache {
+public:
+    ImageCacheStats stats;
+    size_t maxBytes = size_t(1) << 30;  // Directory size kept after each write
+
+    explicit ImageCache(std::string cacheDirectory = ".cache/images") : directory(std::move(cacheDirectory)) {}
+
+    // Map the decoded levels of 'path', decoding and storing them first when there
+    // is no valid entry. False when the source cannot be read or the cache cannot
+    // be written, so callers keep their own decode as a fallback.
+    bool load(const char* path, const ImageDecodeOptions& options, TextureContainer& out) {
+        if (!enabled) return false;
+        std::vector<uint8_t> source;
+        if (!readFile(path, source)) return false;
+        uint64_t key = hashWords(source.data(), source.size(), optionBits(options));
+        std::string entry = entryPath(key);
+
+        std::error_code error;
+        if (std::filesystem::exists(entry, error)) {
+            if (out.open(entry.c_str()) && valid(out, options, false)) {
+                ++stats.hits;
+                // Recency for pruning; a failure only makes the entry look older
+                std::filesystem::last_write_time(entry, std::filesystem::file_time_type::clock::now(), error);
+                record(path, options, key);
+                return true;
+            }
+            ++stats.rebuilt;
+        } else {
+            ++stats.misses;
+        }
+
+        Image image;
+        out = TextureContainer();  // Unmap a damaged entry before it is replaced
+        if (!loadImageThreadSafe(path, source, image, options.flipVertically) || !store(entry, image, options)) return false;
+        record(path, options, key);
+        prune(entry);
+        return out.open(entry.c_str()) && valid(out, options, true);
+    }
+
+private:
+    std::string directory;
+    std::atomic<bool> enabled{ true };
+    std::mutex indexMutex;
+    bool indexLoaded = false;
+    std::unordered_map<std::string, uint64_t> sources;  // "<options> <path>" to the key it last decoded to
+
+    // Bumped whenever decoding or the mip filter changes what an entry holds
+    static constexpr uint64_t VERSION = 1;
+
+    static uint64_t optionBits(const ImageDecodeOptions& options) {
+        return 0xcbf29ce484222325ull ^ (VERSION << 8 | (options.flipVertically ? 1u : 0u) | (options.withMips ? 2u : 0u));
+    }
+
+    std::string entryPath(uint64_t key) const {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.tex", static_cast<unsigned long long>(key));
+        return (std::filesystem::path(directory) / name).string();
+    }
+
+    std::string indexPath() const { return (std::filesystem::path(directory) / "index").string(); }
+
+    // Note that 'path' under 'options' decodes to 'key' now. The entry it decoded
+    // to before is deleted unless another path still decodes to it. Paths are kept
+    // as given, so an index written from the project root survives moving the project.
+    void record(const char* path, const ImageDecodeOptions& options, uint64_t key) {
+        std::string source = std::to_string((options.flipVertically ? 1 : 0) | (options.withMips ? 2 : 0)) + " " +
+                             std::filesystem::path(path).lexically_normal().generic_string();
+        std::lock_guard<std::mutex> lock(indexMutex);
+        if (!indexLoaded) {
+            readIndex();
+            indexLoaded = true;
+        }
+        auto it = sources.find(source);
+        if (it != sources.end() && it->second == key) return;
+        bool superseded = it != sources.end();
+        uint64_t old = superseded ? it->second : 0;
+        sources[source] = key;
+        writeIndex();
+        if (!superseded) return;
+        for (const auto& other : sources) {
+            if (other.second == old) return;
+        }
+        std::error_code error;
+        if (std::filesystem::remove(entryPath(old), error)) ++stats.pruned;
+    }
+
+    // One "<key> <options> <path>" line per source
+    void readIndex() {
+        std::ifstream in(indexPath());
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.size() < 18 || line[16] != ' ') continue;
+            uint64_t key = std::strtoull(line.substr(0, 16).c_str(), nullptr, 16);
+            sources[line.substr(17)] = key;
+        }
+    }
+
+    void writeIndex() {
+        std::string temporary = indexPath() + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+        {
+            std::ofstream out(temporary);
+            char key[24];
+            for (const auto& source : sources) {
+                std::snprintf(key, sizeof(key), "%016llx ", static_cast<unsigned long long>(source.second));
+                out << key << source.first << "\n";
+            }
+            if (!out) return;
+        }
+        std::error_code error;
+        std::filesystem::rename(temporary, indexPath(), error);
+        if (error) std::filesystem::remove(temporary, error);
+    }
+
+    // Delete the least recently used entries until the directory fits maxBytes.
+    // Another thread may have one of them mapped; POSIX keeps the data until it is
+    // unmapped, and elsewhere the remove fails and is retried after the next write.
+    void prune(const std::string& keep) {
+        struct Candidate {
+            std::filesystem::path path;
+            std::filesystem::file_time_type used;
+            uintmax_t size;
+        };
+        std::vector<Candidate> candidates;
+        uintmax_t total = 0;
+        std::error_code error;
+        for (std::filesystem::directory_iterator it(directory, error), end; !error && it != end; it.increment(error)) {
+            const std::filesystem::path& file = it->path();
+            if (file.extension() != ".tex") continue;
+            std::error_code statError;
+            uintmax_t size = it->file_size(statError);
+            if (statError) continue;
+            total += size;
+            if (file != std::filesystem::path(keep)) candidates.push_back({ file, it->last_write_time(statError), size });
+        }
+        if (total <= maxBytes) return;
+
+        std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.used < b.used; });
+        std::vector<uint64_t> removed;
+        for (const Candidate& candidate : candidates) {
+            if (total <= maxBytes) break;
+            if (std::filesystem::remove(candidate.path, error)) {
+                total -= candidate.size;
+                ++stats.pruned;
+                removed.push_back(std::strtoull(candidate.path.stem().string().c_str(), nullptr, 16));
+            }
+        }
+
+        // Index lines for deleted entries would only grow the index
+        std::lock_guard<std::mutex> lock(indexMutex);
+        size_t before = sources.size();
+        for (auto it = sources.begin(); it != sources.end();) {
+            if (std::find(removed.begin(), removed.end(), it->second) != removed.end()) it = sources.erase(it);
+            else ++it;
+        }
+        if (sources.size() != before) writeIndex();
+    }
+
+    // The header and level table match what 'options' would have built; with
+    // 'contents', the level data matches the checksum too
+    static bool valid(const TextureContainer& container, const ImageDecodeOptions& options, bool contents) {
+        if (container.format() != TextureFormat::RGBA8) return false;
+        // The chain buildMipChain makes: down to 1x1, or as many levels as a container holds
+        uint32_t levelCount = 1, width = container.width(), height = container.height();
+        while (options.withMips && (width > 1 || height > 1) && levelCount < TEXTURE_MAX_LEVELS) {
+            width = std::max(1u, width / 2);
+            height = std::max(1u, height / 2);
+            ++levelCount;
+        }
+        if (container.levelCount() != levelCount) return false;
+        if (!contents) return true;
+
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (uint32_t i = 0; i < container.levelCount(); ++i) hash = hashWords(container.level(i).data, container.level(i).size, hash);
+        return hash == container.checksum();
+    }
+
+    bool store(const std::string& entry, const Image& image, const ImageDecodeOptions& options) {
+        std::vector<std::vector<uint8_t>> levelData;
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (Image& level : buildMipChain(image, options.withMips)) {
+            hash = hashWords(level.pixels.data(), level.pixels.size(), hash);
+            levelData.push_back(std::move(level.pixels));
+        }
+
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        std::string temporary = entry + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+        if (!writeTextureContainer(temporary.c_str(), TextureFormat::RGBA8, static_cast<uint32_t>(image.width),
+                                   static_cast<uint32_t>(image.height), levelData, hash)) {
+            std::cerr << "Image cache disabled: cannot write to " << directory << std::endl;
+            enabled = false;
+            return false;
+        }
+        std::filesystem::rename(temporary, entry, error);
+        if (error) {
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+        return true;
+    }
+};
+
+// Shared by the texture loaders
+inline ImageCache& imageCache() {
+    static ImageCache cache;
+    return cache;
+}
+
+#endif  // IMAGE_CACHE_H
@@ -0,0 +1,364 @@
+#ifndef IMAGE_KERNELS_H
+#define IMAGE_KERNELS_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "thread_pool.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define IMAGE_KERNELS_SSE2 1
+#endif
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+
+// CPU resampling for RGBA8 images: mip generation and resizing for the cooker,
+// the software backend and tools that run without a GL context. Every kernel
+// writes into a buffer the caller provides and can split its rows across a
+// ThreadPool (from the thread that owns the pool, as with any parallelFor).
+// sRGB variants filter colour in linear light; alpha is always linear.
+
+namespace SRGB {
+    inline const float* toLinearTable() {
+        static const std::array<float, 256> table = [] {
+            std::array<float, 256> values;
+            for (int i = 0; i < 256; ++i) {
+                float c = i / 255.0f;
+                values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+            return values;
+        }();
+        return table.data();
+    }
+
+    // Encode indexed by linear value * (ENCODE_STEPS - 1); fine enough that no 8-bit code is skipped
+    constexpr int ENCODE_STEPS = 1 << 14;
+    inline const uint8_t* fromLinearTable() {
+        static const std::vector<uint8_t> table = [] {
+            std::vector<uint8_t> values(ENCODE_STEPS);
+            for (int i = 0; i < ENCODE_STEPS; ++i) {
+                float c = static_cast<float>(i) / (ENCODE_STEPS - 1);
+                float encoded = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+                values[i] = static_cast<uint8_t>(std::min(255.0f, encoded * 255.0f + 0.5f));
+            }
+            return values;
+        }();
+        return table.data();
+    }
+
+    inline float toLinear(uint8_t value) { return toLinearTable()[value]; }
+
+    inline uint8_t fromLinear(float value) {
+        value = std::min(std::max(value, 0.0f), 1.0f);
+        return fromLinearTable()[static_cast<int>(value * (ENCODE_STEPS - 1) + 0.5f)];
+    }
+}
+
+// Run fn(begin, end, threadIndex) over rows, on the pool when there is one.
+// threadIndex is below pool->threadCount(), and 0 without a pool.
+template <typename Fn>
+inline void forEachRowRange(int rows, int grain, ThreadPool* pool, Fn&& fn) {
+    if (pool) pool->parallelFor(static_cast<size_t>(rows), static_cast<size_t>(grain), [&](size_t begin, size_t end, unsigned thread) {
+        fn(static_cast<int>(begin), static_cast<int>(end), thread);
+    });
+    else fn(0, rows, 0u);
+}
+
+// Half size by averaging 2x2 texels into 'destination', which holds
+// max(1, width / 2) x max(1, height / 2) texels. An odd last row or column is
+// dropped; sources one texel wide or high are clamped at the edge. Without
+// sRGB the result is the exact rounded mean.
+inline void downsampleBox2x(const uint8_t* source, int width, int height, uint8_t* destination, bool srgb = false,
+                            ThreadPool* pool = nullptr) {
+    int outWidth = std::max(1, width / 2), outHeight = std::max(1, height / 2);
+    const float* toLinear = srgb ? SRGB::toLinearTable() : nullptr;
+
+    forEachRowRange(outHeight, 16, pool, [&](int rowBegin, int rowEnd, unsigned) {
+        for (int y = rowBegin; y < rowEnd; ++y) {
+            const uint8_t* row0 = source + static_cast<size_t>(std::min(y * 2, height - 1)) * width * 4;
+            const uint8_t* row1 = source + static_cast<size_t>(std::min(y * 2 + 1, height - 1)) * width * 4;
+            uint8_t* out = destination + static_cast<size_t>(y) * outWidth * 4;
+            int x = 0;
+
+            if (srgb) {
+                // Table lookups on both sides; no lanes to fill
+                for (; x < outWidth; ++x) {
+                    const uint8_t* a = row0 + std::min(x * 2, width - 1) * 4;
+                    const uint8_t* b = row0 + std::min(x * 2 + 1, width - 1) * 4;
+                    const uint8_t* c = row1 + std::min(x * 2, width - 1) * 4;
+                    const uint8_t* d = row1 + std::min(x * 2 + 1, width - 1) * 4;
+                    for (int channel = 0; channel < 3; ++channel) {
+                        float sum = toLinear[a[channel]] + toLinear[b[channel]] + toLinear[c[channel]] + toLinear[d[channel]];
+                        out[x * 4 + channel] = SRGB::fromLinear(sum * 0.25f);
+                    }
+                    out[x * 4 + 3] = static_cast<uint8_t>((a[3] + b[3] + c[3] + d[3] + 2) >> 2);
+                }
+                continue;
+            }
+
+#ifdef IMAGE_KERNELS_SSE2
+            // Two output texels per step from four texels of each row, summed in 16 bits
+            if (width >= 2) {
+                const __m128i zero = _mm_setzero_si128(), two = _mm_set1_epi16(2);
+                for (; x + 2 <= outWidth; x += 2) {
+                    __m128i top = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8));
+                    __m128i bottom = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8));
+                    __m128i left = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+                    __m128i right = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+                    __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(left, right), _mm_unpackhi_epi64(left, right));
+                    __m128i mean = _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+                    _mm_storel_epi64(reinterpret_cast<__m128i*>(out + x * 4), _mm_packus_epi16(mean, mean));
+                }
+            }
+#endif
+            for (; x < outWidth; ++x) {
+                const uint8_t* a = row0 + std::min(x * 2, width - 1) * 4;
+                const uint8_t* b = row0 + std::min(x * 2 + 1, width - 1) * 4;
+                const uint8_t* c = row1 + std::min(x * 2, width - 1) * 4;
+                const uint8_t* d = row1 + std::min(x * 2 + 1, width - 1) * 4;
+                for (int channel = 0; channel < 4; ++channel) {
+                    out[x * 4 + channel] = static_cast<uint8_t>((a[channel] + b[channel] + c[channel] + d[channel] + 2) >> 2);
+                }
+            }
+        }
+    });
+}
+
+enum class ResampleFilter {
+    Box,
+    Triangle,
+    Lanczos3,
+    Kaiser,  // Kaiser-windowed sinc (width 3, alpha 4): sharper than a box without Lanczos' ringing
+};
+
+namespace Resample {
+    inline float support(ResampleFilter filter) {
+        switch (filter) {
+        case ResampleFilter::Box: return 0.5f;
+        case ResampleFilter::Triangle: return 1.0f;
+        default: return 3.0f;
+        }
+    }
+
+    inline float sinc(float x) {
+        if (std::fabs(x) < 1e-5f) return 1.0f;
+        float angle = 3.14159265f * x;
+        return std::sin(angle) / angle;
+    }
+
+    // Modified Bessel function of the first kind, order 0, by its power series
+    inline float bessel0(float x) {
+        float sum = 1.0f, term = 1.0f, halfX = x * 0.5f;
+        for (int k = 1; k < 32 && term > sum * 1e-8f; ++k) {
+            term *= (halfX / k) * (halfX / k);
+            sum += term;
+        }
+        return sum;
+    }
+
+    inline float evaluate(ResampleFilter filter, float x) {
+        x = std::fabs(x);
+        switch (filter) {
+        case ResampleFilter::Box: return x <= 0.5f ? 1.0f : 0.0f;
+        case ResampleFilter::Triangle: return std::max(0.0f, 1.0f - x);
+        case ResampleFilter::Lanczos3: return x < 3.0f ? sinc(x) * sinc(x / 3.0f) : 0.0f;
+        case ResampleFilter::Kaiser: {
+            if (x >= 3.0f) return 0.0f;
+            const float alpha = 4.0f;
+            float t = x / 3.0f;
+            return sinc(x) * bessel0(alpha * std::sqrt(1.0f - t * t)) / bessel0(alpha);
+        }
+        }
+        return 0.0f;
+    }
+
+    // Normalised taps for every output coordinate along one axis. Taps that fall
+    // outside the source are folded onto the edge texel, so each output reads one
+    // contiguous run of source texels.
+    struct Axis {
+        std::vector<int> first;
+        std::vector<int> count;
+        std::vector<float> weights;  // maxTaps per output
+        std::vector<float> folded;   // One output's taps while they are built
+        int maxTaps = 0;
+
+        void build(int sourceSize, int outputSize, ResampleFilter filter) {
+            float scale = static_cast<float>(outputSize) / sourceSize;
+            float filterScale = std::min(scale, 1.0f);  // Widen the filter when minifying
+            float radius = support(filter) / filterScale;
+            maxTaps = static_cast<int>(std::ceil(radius * 2.0f)) + 2;
+            first.assign(outputSize, 0);
+            count.assign(outputSize, 0);
+            weights.assign(static_cast<size_t>(outputSize) * maxTaps, 0.0f);
+
+            std::vector<float>& taps = folded;
+            for (int i = 0; i < outputSize; ++i) {
+                float center = (i + 0.5f) / scale - 0.5f;
+                int left = static_cast<int>(std::ceil(center - radius)), right = static_cast<int>(std::floor(center + radius));
+                int begin = std::min(std::max(left, 0), sourceSize - 1), end = std::min(std::max(right, 0), sourceSize - 1);
+                taps.assign(end - begin + 1, 0.0f);
+                float total = 0.0f;
+                for (int j = left; j <= right; ++j) {
+                    float weight = evaluate(filter, (j - center) * filterScale);
+                    taps[std::min(std::max(j, 0), sourceSize - 1) - begin] += weight;
+                    total += weight;
+                }
+                if (total == 0.0f) {  // A box narrower than the texel spacing: take the nearest texel
+                    std::fill(taps.begin(), taps.end(), 0.0f);
+                    taps[std::min(std::max(static_cast<int>(std::lround(center)), begin), end) - begin] = total = 1.0f;
+                }
+                // Trim zero taps at the ends so the inner loops skip them
+                int trimFront = 0, trimBack = static_cast<int>(taps.size());
+                while (trimFront < trimBack - 1 && taps[trimFront] == 0.0f) ++trimFront;
+                while (trimBack - 1 > trimFront && taps[trimBack - 1] == 0.0f) --trimBack;
+                first[i] = begin + trimFront;
+                count[i] = trimBack - trimFront;
+                for (int t = 0; t < count[i]; ++t) weights[static_cast<size_t>(i) * maxTaps + t] = taps[trimFront + t] / total;
+            }
+        }
+
+        const float* taps(int i) const { return &weights[static_cast<size_t>(i) * maxTaps]; }
+    };
+}
+
+// Axis tables, the horizontally filtered rows and a row buffer per thread.
+// Pass the same one to repeated resizes and, once it has grown to the largest
+// size used, they allocate nothing.
+struct ResizeScratch {
+    Resample::Axis horizontal, vertical;
+    std::vector<float> rows;
+    std::vector<std::vector<float>> threadRows;  // A source row as floats, then an output row's sums
+};
+
+// Resample 'source' to outWidth x outHeight into 'destination', horizontally
+// into float rows and then vertically. Texels are filtered as RGBA float lanes
+// with SSE (eight floats at a time with AVX in the vertical pass). Without a
+// scratch the buffers are allocated for this call alone.
+inline void resizeImage(const uint8_t* source, int width, int height, uint8_t* destination, int outWidth, int outHeight,
+                        ResampleFilter filter = ResampleFilter::Lanczos3, bool srgb = false, ThreadPool* pool = nullptr,
+                        ResizeScratch* scratch = nullptr) {
+    ResizeScratch local;
+    ResizeScratch& work = scratch ? *scratch : local;
+    work.horizontal.build(width, outWidth, filter);
+    work.vertical.build(height, outHeight, filter);
+    work.rows.resize(static_cast<size_t>(outWidth) * height * 4);
+    work.threadRows.resize(std::max<size_t>(work.threadRows.size(), pool ? pool->threadCount() : 1));
+    for (std::vector<float>& row : work.threadRows) row.resize(static_cast<size_t>(std::max(width, outWidth)) * 4);
+    const float* toLinear = SRGB::toLinearTable();
+    const float inverse255 = 1.0f / 255.0f;
+
+    // Horizontal: each source row to float once, then outWidth weighted sums of RGBA lanes
+    forEachRowRange(height, 8, pool, [&](int rowBegin, int rowEnd, unsigned thread) {
+        std::vector<float>& expanded = work.threadRows[thread];
+        for (int y = rowBegin; y < rowEnd; ++y) {
+            const uint8_t* in = source + static_cast<size_t>(y) * width * 4;
+            int i = 0;
+            if (srgb) {
+                for (; i < width * 4; ++i) expanded[i] = (i & 3) != 3 ? toLinear[in[i]] : in[i] * inverse255;
+            }
+#ifdef IMAGE_KERNELS_SSE2
+            const __m128i zero = _mm_setzero_si128();
+            const __m128 scale = _mm_set1_ps(inverse255);
+            for (; i + 16 <= width * 4; i += 16) {
+                __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+                __m128i low = _mm_unpacklo_epi8(bytes, zero), high = _mm_unpackhi_epi8(bytes, zero);
+                _mm_storeu_ps(&expanded[i], _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero)), scale));
+                _mm_storeu_ps(&expanded[i + 4], _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero)), scale));
+                _mm_storeu_ps(&expanded[i + 8], _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero)), scale));
+                _mm_storeu_ps(&expanded[i + 12], _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero)), scale));
+            }
+#endif
+            for (; i < width * 4; ++i) expanded[i] = in[i] * inverse255;
+
+            float* out = &work.rows[static_cast<size_t>(y) * outWidth * 4];
+            for (int x = 0; x < outWidth; ++x) {
+                const float* texel = &expanded[static_cast<size_t>(work.horizontal.first[x]) * 4];
+                const float* weights = work.horizontal.taps(x);
+                int taps = work.horizontal.count[x];
+#ifdef IMAGE_KERNELS_SSE2
+                // Two accumulators so consecutive taps do not wait on each other's add
+                __m128 even = _mm_setzero_ps(), odd = _mm_setzero_ps();
+                int t = 0;
+                for (; t + 2 <= taps; t += 2) {
+                    even = _mm_add_ps(even, _mm_mul_ps(_mm_loadu_ps(texel + t * 4), _mm_set1_ps(weights[t])));
+                    odd = _mm_add_ps(odd, _mm_mul_ps(_mm_loadu_ps(texel + t * 4 + 4), _mm_set1_ps(weights[t + 1])));
+                }
+                if (t < taps) even = _mm_add_ps(even, _mm_mul_ps(_mm_loadu_ps(texel + t * 4), _mm_set1_ps(weights[t])));
+                _mm_storeu_ps(out + x * 4, _mm_add_ps(even, odd));
+#else
+                float sum[4] = {};
+                for (int t = 0; t < taps; ++t) {
+                    for (int channel = 0; channel < 4; ++channel) sum[channel] += texel[t * 4 + channel] * weights[t];
+                }
+                std::copy(sum, sum + 4, out + x * 4);
+#endif
+            }
+        }
+    });
+
+    // Vertical: weighted sums of whole filtered rows, then back to 8 bits
+    forEachRowRange(outHeight, 8, pool, [&](int rowBegin, int rowEnd, unsigned thread) {
+        const int lanes = outWidth * 4;
+        std::vector<float>& sum = work.threadRows[thread];
+        for (int y = rowBegin; y < rowEnd; ++y) {
+            std::fill(sum.begin(), sum.begin() + lanes, 0.0f);
+            const float* weights = work.vertical.taps(y);
+            for (int t = 0; t < work.vertical.count[y]; ++t) {
+                const float* row = &work.rows[static_cast<size_t>(work.vertical.first[y] + t) * lanes];
+                float weight = weights[t];
+                int i = 0;
+#ifdef __AVX__
+                __m256 weight8 = _mm256_set1_ps(weight);
+                for (; i + 8 <= lanes; i += 8) {
+                    _mm256_storeu_ps(&sum[i], _mm256_add_ps(_mm256_loadu_ps(&sum[i]), _mm256_mul_ps(_mm256_loadu_ps(row + i), weight8)));
+                }
+#endif
+#ifdef IMAGE_KERNELS_SSE2
+                __m128 weight4 = _mm_set1_ps(weight);
+                for (; i + 4 <= lanes; i += 4) {
+                    _mm_storeu_ps(&sum[i], _mm_add_ps(_mm_loadu_ps(&sum[i]), _mm_mul_ps(_mm_loadu_ps(row + i), weight4)));
+                }
+#endif
+                for (; i < lanes; ++i) sum[i] += row[i] * weight;
+            }
+
+            uint8_t* out = destination + static_cast<size_t>(y) * outWidth * 4;
+            int i = 0;
+            if (srgb) {
+                for (; i < lanes; ++i) {
+                    out[i] = (i & 3) == 3 ? static_cast<uint8_t>(std::min(std::max(sum[i], 0.0f), 1.0f) * 255.0f + 0.5f)
+                                          : SRGB::fromLinear(sum[i]);
+                }
+                continue;
+            }
+#ifdef IMAGE_KERNELS_SSE2
+            // Saturating packs do the clamping
+            const __m128 scale = _mm_set1_ps(255.0f), half = _mm_set1_ps(0.5f), zero = _mm_setzero_ps();
+            for (; i + 16 <= lanes; i += 16) {
+                __m128i a = _mm_cvttps_epi32(_mm_add_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(&sum[i]), scale), zero), half));
+                __m128i b = _mm_cvttps_epi32(_mm_add_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(&sum[i + 4]), scale), zero), half));
+                __m128i c = _mm_cvttps_epi32(_mm_add_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(&sum[i + 8]), scale), zero), half));
+                __m128i d = _mm_cvttps_epi32(_mm_add_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(&sum[i + 12]), scale), zero), half));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+            }
+#endif
+            for (; i < lanes; ++i) out[i] = static_cast<uint8_t>(std::min(std::max(sum[i], 0.0f), 1.0f) * 255.0f + 0.5f);
+        }
+    });
+}
+
+// Next mip level with any filter: the exact box kernel for Box, a resample otherwise
+inline void downsampleLevel(const uint8_t* source, int width, int height, uint8_t* destination, ResampleFilter filter,
+                            bool srgb = false, ThreadPool* pool = nullptr, ResizeScratch* scratch = nullptr) {
+    if (filter == ResampleFilter::Box) {
+        downsampleBox2x(source, width, height, destination, srgb, pool);
+        return;
+    }
+    resizeImage(source, width, height, destination, std::max(1, width / 2), std::max(1, height / 2), filter, srgb, pool, scratch);
+}
+
+#endif  // IMAGE_KERNELS_H
@@ -0,0 +1,175 @@
+#ifndef LIGHT_BINNING_H
+#define LIGHT_BINNING_H
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "light_visibility.h"
+#include "thread_pool.h"
+
+// Counters for the last LightTileBinner::bin
+struct LightBinStats {
+    size_t visibleLights = 0;
+    size_t indices = 0;        // Light references over all tiles
+    uint32_t maxPerTile = 0;
+};
+
+// Screen-space tiles, each with the list of lights whose circle reaches it,
+// so a shading pass only evaluates the lights that can touch a pixel.
+// The result is packed for a single buffer texture: tileCount + 1 offsets,
+// then the light indices; tile t uses indices [offsets[t], offsets[t + 1]).
+// Binning runs in horizontal bands of tiles on the pool; each band counts,
+// then fills, its own lists, and the bands are stitched together at the end.
+class LightTileBinner {
+public:
+    int tileSize = 16;  // Pixels
+
+    void bin(const PointLight* lights, size_t count, const glm::mat4& viewProjection, int width, int height,
+             ThreadPool* pool = nullptr) {
+        stats = LightBinStats();
+        tilesX = (width + tileSize - 1) / tileSize;
+        tilesY = (height + tileSize - 1) / tileSize;
+        size_t tileCount = static_cast<size_t>(tilesX) * tilesY;
+
+        // Screen footprint of every light; orthographic, so a circle stays an axis-aligned ellipse
+        glm::vec2 pixelsPerUnit = 0.5f * glm::vec2(width, height) *
+                                  glm::vec2(glm::length(glm::vec2(viewProjection[0])), glm::length(glm::vec2(viewProjection[1])));
+        footprints.resize(count);
+        auto project = [&](size_t begin, size_t end, unsigned) {
+            for (size_t i = begin; i < end; ++i) {
+                glm::vec4 clip = viewProjection * glm::vec4(lights[i].position, 0.0f, 1.0f);
+                Footprint& footprint = footprints[i];
+                footprint.center = (glm::vec2(clip) * 0.5f + 0.5f) * glm::vec2(width, height);
+                footprint.radius = lights[i].radius * pixelsPerUnit;
+                glm::vec2 low = glm::floor((footprint.center - footprint.radius) / static_cast<float>(tileSize));
+                glm::vec2 high = glm::floor((footprint.center + footprint.radius) / static_cast<float>(tileSize));
+                footprint.low = glm::ivec2(glm::max(low, glm::vec2(0.0f)));
+                footprint.high = glm::ivec2(glm::min(high, glm::vec2(tilesX - 1, tilesY - 1)));
+            }
+        };
+        run(pool, count, 256, project);
+
+        visible.clear();
+        for (uint32_t i = 0; i < count; ++i) {
+            if (footprints[i].low.x <= footprints[i].high.x && footprints[i].low.y <= footprints[i].high.y) visible.push_back(i);
+        }
+        stats.visibleLights = visible.size();
+
+        // Bands of rows, a few per thread so uneven light density still balances
+        unsigned threads = pool ? pool->threadCount() : 1;
+        int rowsPerBand = std::max(1, tilesY / static_cast<int>(threads * 4));
+        size_t bandCount = (tilesY + rowsPerBand - 1) / rowsPerBand;
+        if (bands.size() < bandCount) bands.resize(bandCount);
+        run(pool, bandCount, 1, [&](size_t begin, size_t end, unsigned) {
+            for (size_t band = begin; band < end; ++band) {
+                int firstRow = static_cast<int>(band) * rowsPerBand;
+                binBand(bands[band], firstRow, std::min(tilesY, firstRow + rowsPerBand));
+            }
+        });
+
+        // Stitch: every band's offsets are shifted by the indices before it
+        size_t total = 0;
+        for (size_t band = 0; band < bandCount; ++band) {
+            bands[band].base = total;
+            total += bands[band].indices.size();
+        }
+        packedData.resize(tileCount + 1 + total);
+        packedData[tileCount] = static_cast<uint32_t>(total);
+        run(pool, bandCount, 1, [&](size_t begin, size_t end, unsigned) {
+            for (size_t band = begin; band < end; ++band) {
+                const Band& local = bands[band];
+                size_t firstTile = static_cast<size_t>(band) * rowsPerBand * tilesX;
+                for (size_t t = 0; t + 1 < local.offsets.size(); ++t) {
+                    packedData[firstTile + t] = static_cast<uint32_t>(local.base + local.offsets[t]);
+                }
+                std::copy(local.indices.begin(), local.indices.end(), packedData.begin() + tileCount + 1 + local.base);
+            }
+        });
+
+        stats.indices = total;
+        for (size_t band = 0; band < bandCount; ++band) stats.maxPerTile = std::max(stats.maxPerTile, bands[band].maxPerTile);
+    }
+
+    int tileColumns() const { return tilesX; }
+    int tileRows() const { return tilesY; }
+    size_t tileCount() const { return static_cast<size_t>(tilesX) * tilesY; }
+
+    // Offsets then indices, ready to upload
+    const std::vector<uint32_t>& packed() const { return packedData; }
+    uint32_t lightsInTile(int x, int y) const {
+        size_t tile = static_cast<size_t>(y) * tilesX + x;
+        return packedData[tile + 1] - packedData[tile];
+    }
+    const LightBinStats& lastStats() const { return stats; }
+
+private:
+    struct Footprint {
+        glm::vec2 center, radius;   // Pixels
+        glm::ivec2 low, high;       // Tile range, empty when off screen
+    };
+    struct Band {
+        std::vector<uint32_t> offsets;  // Local, one past the band's tiles
+        std::vector<uint32_t> indices;
+        std::vector<uint32_t> cursor;   // Fill position per tile
+        size_t base = 0;
+        uint32_t maxPerTile = 0;
+    };
+
+    int tilesX = 0, tilesY = 0;
+    std::vector<Footprint> footprints;
+    std::vector<uint32_t> visible;
+    std::vector<Band> bands;
+    std::vector<uint32_t> packedData;
+    LightBinStats stats;
+
+    template <typename Fn>
+    static void run(ThreadPool* pool, size_t count, size_t grain, Fn&& fn) {
+        if (pool) pool->parallelFor(count, grain, fn);
+        else fn(size_t(0), count, 0u);
+    }
+
+    // Ellipse against the tile rectangle: nearest point of the tile inside the footprint
+    bool touches(const Footprint& footprint, int x, int y) const {
+        glm::vec2 low = glm::vec2(x, y) * static_cast<float>(tileSize);
+        glm::vec2 nearest = glm::clamp(footprint.center, low, low + static_cast<float>(tileSize));
+        glm::vec2 d = (nearest - footprint.center) / footprint.radius;
+        return glm::dot(d, d) <= 1.0f;
+    }
+
+    void binBand(Band& band, int firstRow, int endRow) {
+        size_t tiles = static_cast<size_t>(endRow - firstRow) * tilesX;
+        band.offsets.assign(tiles + 1, 0);
+        band.maxPerTile = 0;
+
+        // Count into offsets[t + 1], prefix sum, then fill; lights stay in index order per tile
+        for (uint32_t light : visible) {
+            const Footprint& footprint = footprints[light];
+            int rowBegin = std::max(firstRow, footprint.low.y), rowEnd = std::min(endRow - 1, footprint.high.y);
+            for (int y = rowBegin; y <= rowEnd; ++y) {
+                uint32_t* row = &band.offsets[static_cast<size_t>(y - firstRow) * tilesX + 1];
+                for (int x = footprint.low.x; x <= footprint.high.x; ++x) row[x] += touches(footprint, x, y);
+            }
+        }
+        for (size_t t = 0; t < tiles; ++t) {
+            band.maxPerTile = std::max(band.maxPerTile, band.offsets[t + 1]);
+            band.offsets[t + 1] += band.offsets[t];
+        }
+        band.indices.resize(band.offsets[tiles]);
+
+        band.cursor.assign(band.offsets.begin(), band.offsets.end() - 1);
+        for (uint32_t light : visible) {
+            const Footprint& footprint = footprints[light];
+            int rowBegin = std::max(firstRow, footprint.low.y), rowEnd = std::min(endRow - 1, footprint.high.y);
+            for (int y = rowBegin; y <= rowEnd; ++y) {
+                size_t rowStart = static_cast<size_t>(y - firstRow) * tilesX;
+                for (int x = footprint.low.x; x <= footprint.high.x; ++x) {
+                    if (touches(footprint, x, y)) band.indices[band.cursor[rowStart + x]++] = light;
+                }
+            }
+        }
+    }
+};
+
+#endif  // LIGHT_BINNING_H
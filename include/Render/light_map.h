@@ -0,0 +1,190 @@
+#ifndef LIGHT_MAP_H
+#define LIGHT_MAP_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "gl_state.h"
+#include "light_visibility.h"
+#include "render_queue.h"
+#include "render_target.h"
+#include "shader.h"
+
+// Each light's visibility fan, with the light's centre carried along for the falloff
+constexpr const char* LIGHT_VERTEX_SHADER = R"(
+    #version 330 core
+    layout (location = 0) in vec2 aPos;
+    layout (location = 1) in vec3 aLight;   // centre x, y, radius
+    layout (location = 2) in vec4 aColor;
+    out vec2 WorldPos;
+    flat out vec3 Light;
+    flat out vec4 Color;
+
+    layout (std140) uniform Camera {
+        mat4 projection;
+        mat4 view;
+    };
+
+    void main() {
+        WorldPos = aPos;
+        Light = aLight;
+        Color = aColor;
+        gl_Position = projection * view * vec4(aPos, 0.0, 1.0);
+    }
+)";
+
+constexpr const char* LIGHT_FRAGMENT_SHADER = R"(
+    #version 330 core
+    out vec4 FragColor;
+    in vec2 WorldPos;
+    flat in vec3 Light;
+    flat in vec4 Color;
+
+    void main() {
+        float falloff = max(1.0 - length(WorldPos - Light.xy) / Light.z, 0.0);
+        FragColor = vec4(Color.rgb * Color.a * falloff * falloff, 1.0);
+    }
+)";
+
+// Multiplies the scene by the light map, which may be smaller than the scene
+constexpr const char* LIGHT_COMPOSITE_VERTEX_SHADER = R"(
+    #version 330 core
+    out vec2 TexCoord;
+    void main() {
+        vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+        TexCoord = corner * 2.0;
+        gl_Position = vec4(corner * 4.0 - 1.0, 0.0, 1.0);
+    }
+)";
+
+constexpr const char* LIGHT_COMPOSITE_FRAGMENT_SHADER = R"(
+    #version 330 core
+    out vec4 FragColor;
+    in vec2 TexCoord;
+    uniform sampler2D lightMap;
+
+    void main() {
+        FragColor = texture(lightMap, TexCoord);
+    }
+)";
+
+// Vertex of a light fan triangle
+struct LightVertex {
+    float x, y;
+    float centerX, centerY, radius;
+    uint32_t color;
+};
+
+// Accumulates every light additively into an offscreen target, one draw for
+// all of them, and multiplies it over the scene. Fan vertices are rebuilt and
+// uploaded only when the visibility cache reports a change, so a frame where
+// nothing moved only replays the static buffer.
+class LightMap {
+public:
+    glm::vec3 ambient = glm::vec3(0.25f);
+    float resolutionScale = 0.5f;  // Light changes slowly across the screen; half resolution is plenty
+
+    LightMap()
+        : lightShader(LIGHT_VERTEX_SHADER, LIGHT_FRAGMENT_SHADER),
+          compositeShader(LIGHT_COMPOSITE_VERTEX_SHADER, LIGHT_COMPOSITE_FRAGMENT_SHADER) {
+        lightMapLocation = compositeShader.uniform("lightMap");
+        glGenVertexArrays(1, &vao);
+        glGenVertexArrays(1, &emptyVao);
+        glGenBuffers(1, &vbo);
+        glState().bindVertexArray(vao);
+        glState().bindBuffer(GL_ARRAY_BUFFER, vbo);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(LightVertex), (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(LightVertex), (void*)(2 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(LightVertex), (void*)(5 * sizeof(float)));
+    }
+
+    ~LightMap() {
+        glState().deleteVertexArray(vao);
+        glState().deleteVertexArray(emptyVao);
+        glState().deleteBuffer(vbo);
+    }
+
+    LightMap(const LightMap&) = delete;
+    LightMap& operator=(const LightMap&) = delete;
+
+    // Draw the lights for a view of width x height pixels into the light map.
+    // Uses the Camera block, so call after the camera buffer is updated.
+    // Leaves the light map bound as the framebuffer.
+    void render(const LightVisibilityCache& lights, int width, int height) {
+        target.resize(std::max(1, static_cast<int>(width * resolutionScale)),
+                      std::max(1, static_cast<int>(height * resolutionScale)));
+        target.bind();
+        glClearColor(ambient.r, ambient.g, ambient.b, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glState().countIssued(2);
+
+        if (lights.contentVersion() != uploadedVersion) upload(lights);
+        if (vertexCount == 0) return;
+
+        lightShader.use();
+        glState().bindVertexArray(vao);
+        glState().setBlend(true);
+        glState().blendFunc(GL_ONE, GL_ONE);
+        glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+        glState().countDrawCall();
+    }
+
+    // Multiply the bound framebuffer by the light map
+    void composite() {
+        compositeShader.use();
+        glState().bindTexture(0, target.colorTexture);
+        Shader::setInt(lightMapLocation, 0);
+        glState().countIssued();
+
+        glState().bindVertexArray(emptyVao);
+        glState().setBlend(true);
+        glState().blendFunc(GL_DST_COLOR, GL_ZERO);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glState().countDrawCall();
+    }
+
+    // Size of the light map after the last render(), for passes that add into it
+    int width() const { return target.width; }
+    int height() const { return target.height; }
+
+    // Vertex uploads so far; stays put while nothing moves
+    uint32_t uploads() const { return uploadCount; }
+
+private:
+    Shader lightShader;
+    Shader compositeShader;
+    RenderTarget target;
+    GLuint vao = 0, emptyVao = 0, vbo = 0;
+    GLint lightMapLocation;
+    std::vector<LightVertex> vertices;
+    GLsizei vertexCount = 0;
+    uint64_t uploadedVersion = ~0ull;
+    uint32_t uploadCount = 0;
+
+    void upload(const LightVisibilityCache& lights) {
+        vertices.clear();
+        for (uint32_t id = 0; id < lights.size(); ++id) {
+            const PointLight& light = lights.light(id);
+            const std::vector<glm::vec2>& fan = lights.polygon(id);
+            uint32_t color = packColor(light.color);
+            LightVertex center = { light.position.x, light.position.y, light.position.x, light.position.y, light.radius, color };
+            for (size_t i = 0; i + 1 < fan.size(); ++i) {
+                vertices.push_back(center);
+                vertices.push_back({ fan[i].x, fan[i].y, light.position.x, light.position.y, light.radius, color });
+                vertices.push_back({ fan[i + 1].x, fan[i + 1].y, light.position.x, light.position.y, light.radius, color });
+            }
+        }
+        vertexCount = static_cast<GLsizei>(vertices.size());
+        glState().bindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(LightVertex), vertices.data(), GL_DYNAMIC_DRAW);
+        glState().countIssued();
+        uploadedVersion = lights.contentVersion();
+        ++uploadCount;
+    }
+};
+
+#endif  // LIGHT_MAP_H
@@ -0,0 +1,412 @@
+#ifndef LIGHT_VISIBILITY_H
+#define LIGHT_VISIBILITY_H
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "thread_pool.h"
+
+// One wall outline edge. The open side is on the left of a -> b, so a light
+// that can see the edge's face sees it running counter-clockwise.
+struct WallSegment {
+    glm::vec2 a, b;
+};
+
+// Outline of the solid tiles as merged edges, bucketed in a coarse grid so a
+// light only looks at the edges near it. Runs of tiles along a row or column
+// collapse into one edge, so a straight wall costs two edges however long it is.
+// Plain CPU data: no GL, no Editor, built from any isWall(column, row).
+class WallEdges {
+public:
+    static constexpr int CELL_TILES = 8;  // Bucket size in tiles
+
+    template <typename IsWall>
+    void build(int width, int height, float size, IsWall&& isWall) {
+        gridWidth = width;
+        gridHeight = height;
+        tileSize = size;
+        solid.assign(static_cast<size_t>(width) * height, 0);
+        for (int i = 0; i < width; ++i) {
+            for (int j = 0; j < height; ++j) solid[static_cast<size_t>(j) * width + i] = isWall(i, j) ? 1 : 0;
+        }
+
+        edges.clear();
+        // Horizontal boundaries between row j - 1 and row j, including the map's top and bottom
+        for (int j = 0; j <= height; ++j) {
+            int runUp = -1, runDown = -1;
+            for (int i = 0; i <= width; ++i) {
+                bool below = i < width && isSolid(i, j - 1), above = i < width && isSolid(i, j);
+                bool faceUp = below && !above, faceDown = above && !below;
+                if (faceUp && runUp < 0) runUp = i;
+                if (!faceUp && runUp >= 0) { addEdge(glm::vec2(runUp, j), glm::vec2(i, j)); runUp = -1; }
+                if (faceDown && runDown < 0) runDown = i;
+                if (!faceDown && runDown >= 0) { addEdge(glm::vec2(i, j), glm::vec2(runDown, j)); runDown = -1; }
+            }
+        }
+        // Vertical boundaries between column i - 1 and column i
+        for (int i = 0; i <= width; ++i) {
+            int runRight = -1, runLeft = -1;
+            for (int j = 0; j <= height; ++j) {
+                bool left = j < height && isSolid(i - 1, j), right = j < height && isSolid(i, j);
+                bool faceRight = left && !right, faceLeft = right && !left;
+                if (faceRight && runRight < 0) runRight = j;
+                if (!faceRight && runRight >= 0) { addEdge(glm::vec2(i, j), glm::vec2(i, runRight)); runRight = -1; }
+                if (faceLeft && runLeft < 0) runLeft = j;
+                if (!faceLeft && runLeft >= 0) { addEdge(glm::vec2(i, runLeft), glm::vec2(i, j)); runLeft = -1; }
+            }
+        }
+        buildBuckets();
+    }
+
+    const std::vector<WallSegment>& segments() const { return edges; }
+
+    // Tiles outside the map count as open
+    bool isSolid(int column, int row) const {
+        if (column < 0 || row < 0 || column >= gridWidth || row >= gridHeight) return false;
+        return solid[static_cast<size_t>(row) * gridWidth + column] != 0;
+    }
+
+    bool isSolidAt(const glm::vec2& world) const {
+        return isSolid(static_cast<int>(std::floor(world.x / tileSize)), static_cast<int>(std::floor(world.y / tileSize)));
+    }
+
+    // Append the edges whose bounding box overlaps the world rectangle (minX, minY, maxX, maxY), each once
+    void query(const glm::vec4& bounds, std::vector<uint32_t>& out) const {
+        if (edges.empty()) return;
+        glm::ivec2 low = cellOf(glm::vec2(bounds.x, bounds.y)), high = cellOf(glm::vec2(bounds.z, bounds.w));
+        for (int cy = low.y; cy <= high.y; ++cy) {
+            for (int cx = low.x; cx <= high.x; ++cx) {
+                size_t cell = static_cast<size_t>(cy) * cellColumns + cx;
+                for (uint32_t k = cellStart[cell]; k < cellStart[cell + 1]; ++k) {
+                    uint32_t index = cellItems[k];
+                    const WallSegment& edge = edges[index];
+                    glm::vec2 edgeMin = glm::min(edge.a, edge.b), edgeMax = glm::max(edge.a, edge.b);
+                    if (edgeMax.x < bounds.x || edgeMin.x > bounds.z || edgeMax.y < bounds.y || edgeMin.y > bounds.w) continue;
+                    // An edge sits in every cell it crosses; report it from the first one the query visits
+                    glm::ivec2 first = glm::max(cellOf(edgeMin), low);
+                    if (first.x == cx && first.y == cy) out.push_back(index);
+                }
+            }
+        }
+    }
+
+private:
+    int gridWidth = 0, gridHeight = 0;
+    float tileSize = 1.0f;
+    std::vector<uint8_t> solid;
+    std::vector<WallSegment> edges;
+    int cellColumns = 0, cellRows = 0;
+    std::vector<uint32_t> cellStart;  // Edges of cell c are cellItems[cellStart[c], cellStart[c + 1])
+    std::vector<uint32_t> cellItems;
+
+    void addEdge(const glm::vec2& aTiles, const glm::vec2& bTiles) {
+        edges.push_back({ aTiles * tileSize, bTiles * tileSize });
+    }
+
+    glm::ivec2 cellOf(const glm::vec2& world) const {
+        glm::ivec2 cell(glm::floor(world / (tileSize * CELL_TILES)));
+        return glm::clamp(cell, glm::ivec2(0), glm::ivec2(cellColumns - 1, cellRows - 1));
+    }
+
+    void buildBuckets() {
+        cellColumns = gridWidth / CELL_TILES + 1;
+        cellRows = gridHeight / CELL_TILES + 1;
+        cellStart.assign(static_cast<size_t>(cellColumns) * cellRows + 1, 0);
+        for (int pass = 0; pass < 2; ++pass) {
+            for (uint32_t index = 0; index < edges.size(); ++index) {
+                glm::ivec2 low = cellOf(glm::min(edges[index].a, edges[index].b));
+                glm::ivec2 high = cellOf(glm::max(edges[index].a, edges[index].b));
+                for (int cy = low.y; cy <= high.y; ++cy) {
+                    for (int cx = low.x; cx <= high.x; ++cx) {
+                        size_t cell = static_cast<size_t>(cy) * cellColumns + cx;
+                        if (pass == 0) ++cellStart[cell + 1];
+                        else cellItems[cellStart[cell]++] = index;
+                    }
+                }
+            }
+            if (pass == 0) {
+                for (size_t cell = 1; cell < cellStart.size(); ++cell) cellStart[cell] += cellStart[cell - 1];
+                cellItems.resize(cellStart.back());
+            } else {
+                // Filling advanced every start to the next cell's; shift them back
+                for (size_t cell = cellStart.size() - 1; cell > 0; --cell) cellStart[cell] = cellStart[cell - 1];
+                cellStart[0] = 0;
+            }
+        }
+    }
+};
+
+// Working memory for one visibility computation, reused between lights on the same thread
+struct VisibilityScratch {
+    struct Piece {
+        glm::vec2 a, b;
+        float angleA, angleB;  // angleA < angleB, both in [-pi, pi]
+    };
+    struct Event {
+        float angle;
+        uint32_t piece;
+        bool begins;
+    };
+
+    std::vector<uint32_t> candidates;
+    std::vector<Piece> pieces;
+    std::vector<Event> events;
+    std::vector<uint32_t> active;
+};
+
+namespace Visibility {
+    constexpr float PI = 3.14159265358979f;
+
+    // Distance from 'center' along direction 'angle' to the line through the piece
+    inline float rayDistance(const VisibilityScratch::Piece& piece, const glm::vec2& center, float angle) {
+        glm::vec2 direction(std::cos(angle), std::sin(angle));
+        glm::vec2 edge = piece.b - piece.a, toStart = piece.a - center;
+        float denominator = direction.x * edge.y - direction.y * edge.x;
+        return (toStart.x * edge.y - toStart.y * edge.x) / denominator;
+    }
+
+    // Active piece closest along 'angle'. Pieces meeting at a shared corner tie
+    // there, so ties are settled just past the angle on the side the sweep is
+    // looking at (-1 before the event, +1 after).
+    inline int nearest(const VisibilityScratch& scratch, const glm::vec2& center, float angle, float side) {
+        int best = -1;
+        float bestDistance = 0.0f;
+        for (uint32_t index : scratch.active) {
+            float distance = rayDistance(scratch.pieces[index], center, angle);
+            if (best >= 0 && std::abs(distance - bestDistance) <= 1e-4f * bestDistance) {
+                float nudged = angle + side * 1e-3f;
+                if (rayDistance(scratch.pieces[index], center, nudged) >= rayDistance(scratch.pieces[best], center, nudged)) continue;
+            } else if (best >= 0 && distance >= bestDistance) {
+                continue;
+            }
+            best = static_cast<int>(index);
+            bestDistance = distance;
+        }
+        return best;
+    }
+
+    // Clip a -> b to the rectangle (Liang-Barsky); false if nothing is left
+    inline bool clipToBounds(glm::vec2& a, glm::vec2& b, const glm::vec4& bounds) {
+        glm::vec2 delta = b - a;
+        float enter = 0.0f, leave = 1.0f;
+        const float p[4] = { -delta.x, delta.x, -delta.y, delta.y };
+        const float q[4] = { a.x - bounds.x, bounds.z - a.x, a.y - bounds.y, bounds.w - a.y };
+        for (int i = 0; i < 4; ++i) {
+            if (p[i] == 0.0f) {
+                if (q[i] < 0.0f) return false;
+                continue;
+            }
+            float t = q[i] / p[i];
+            if (p[i] < 0.0f) enter = std::max(enter, t);
+            else leave = std::min(leave, t);
+        }
+        if (enter >= leave) return false;
+        glm::vec2 start = a;
+        a = start + delta * enter;
+        b = start + delta * leave;
+        return true;
+    }
+
+    inline void addPiece(VisibilityScratch& scratch, const glm::vec2& a, const glm::vec2& b, float angleA, float angleB) {
+        if (angleB <= angleA) return;  // Zero angular width, e.g. cut exactly at a corner
+        uint32_t index = static_cast<uint32_t>(scratch.pieces.size());
+        scratch.pieces.push_back({ a, b, angleA, angleB });
+        scratch.events.push_back({ angleA, index, true });
+        scratch.events.push_back({ angleB, index, false });
+    }
+
+    // Add a segment running counter-clockwise around 'center'. Segments crossing
+    // the -x axis are cut there, so every piece spans an increasing angle range.
+    inline void addSegment(VisibilityScratch& scratch, const glm::vec2& center, const glm::vec2& a, const glm::vec2& b) {
+        glm::vec2 da = a - center, db = b - center;
+        float angleA = std::atan2(da.y, da.x), angleB = std::atan2(db.y, db.x);
+        if (angleA == PI && da.y == 0.0f) angleA = -PI;  // Starting on the cut belongs to the lower side
+        if (angleA <= angleB) {
+            addPiece(scratch, a, b, angleA, angleB);
+            return;
+        }
+        float t = da.y / (da.y - db.y);
+        glm::vec2 cut = a + (b - a) * t;
+        addPiece(scratch, a, cut, angleA, PI);
+        addPiece(scratch, cut, b, -PI, angleB);
+    }
+}
+
+// Visibility polygon of a point light: 'out' receives the boundary counter-
+// clockwise from angle -pi, to be drawn as a fan around 'center'. Only wall
+// faces turned toward the light occlude, and the light's bounding square
+// closes the polygon. Angular sweep: endpoints are visited in angle order
+// and the nearest active edge only changes at those events, so the cost is
+// O(n log n + n * active) in the edges within the radius.
+// Returns the number of edges considered.
+inline size_t computeVisibility(const WallEdges& walls, const glm::vec2& center, float radius,
+                                VisibilityScratch& scratch, std::vector<glm::vec2>& out) {
+    out.clear();
+    if (walls.isSolidAt(center)) return 0;  // Buried in a wall: casts no light
+
+    glm::vec4 bounds(center - radius, center + radius);
+    scratch.candidates.clear();
+    scratch.pieces.clear();
+    scratch.events.clear();
+    scratch.active.clear();
+    walls.query(bounds, scratch.candidates);
+
+    const std::vector<WallSegment>& segments = walls.segments();
+    for (uint32_t index : scratch.candidates) {
+        const WallSegment& segment = segments[index];
+        glm::vec2 edge = segment.b - segment.a, toCenter = center - segment.a;
+        if (edge.x * toCenter.y - edge.y * toCenter.x <= 0.0f) continue;  // Back face or edge-on
+        // Clipped, so no edge crosses the square and the nearest edge only changes at endpoints
+        glm::vec2 a = segment.a, b = segment.b;
+        if (Visibility::clipToBounds(a, b, bounds)) Visibility::addSegment(scratch, center, a, b);
+    }
+    // Bounding square, counter-clockwise
+    glm::vec2 corners[4] = { glm::vec2(bounds.x, bounds.y), glm::vec2(bounds.z, bounds.y),
+                             glm::vec2(bounds.z, bounds.w), glm::vec2(bounds.x, bounds.w) };
+    for (int i = 0; i < 4; ++i) Visibility::addSegment(scratch, center, corners[i], corners[(i + 1) % 4]);
+
+    std::sort(scratch.events.begin(), scratch.events.end(), [](const VisibilityScratch::Event& x, const VisibilityScratch::Event& y) {
+        return x.angle < y.angle;
+    });
+
+    auto emit = [&](int piece, float angle) {
+        if (piece < 0) return;
+        glm::vec2 point = center + glm::vec2(std::cos(angle), std::sin(angle)) *
+                                       Visibility::rayDistance(scratch.pieces[piece], center, angle);
+        if (out.empty() || glm::any(glm::greaterThan(glm::abs(point - out.back()), glm::vec2(1e-3f)))) out.push_back(point);
+    };
+
+    for (size_t first = 0; first < scratch.events.size();) {
+        float angle = scratch.events[first].angle;
+        size_t last = first;
+        while (last < scratch.events.size() && scratch.events[last].angle == angle) ++last;
+
+        int before = Visibility::nearest(scratch, center, angle, -1.0f);
+        for (size_t e = first; e < last; ++e) {
+            const VisibilityScratch::Event& event = scratch.events[e];
+            if (event.begins) {
+                scratch.active.push_back(event.piece);
+            } else {
+                scratch.active.erase(std::find(scratch.active.begin(), scratch.active.end(), event.piece));
+            }
+        }
+        int after = Visibility::nearest(scratch, center, angle, 1.0f);
+        if (before != after) {
+            emit(before, angle);
+            emit(after, angle);
+        }
+        first = last;
+    }
+    return scratch.candidates.size();
+}
+
+// A light that walls block
+struct PointLight {
+    glm::vec2 position;
+    float radius;
+    glm::vec4 color;  // rgb, a = intensity
+};
+
+// Counters for the last LightVisibilityCache::update
+struct LightingStats {
+    size_t lights = 0;
+    size_t rebuilt = 0;         // Lights whose polygon was recomputed
+    size_t edgesConsidered = 0;
+    size_t polygonPoints = 0;   // Over the rebuilt lights
+};
+
+// Visibility polygon per light, recomputed only when the light moved or
+// changed radius, or an edit touched its square. Rebuilds run in parallel
+// across lights, one scratch per pool thread.
+class LightVisibilityCache {
+public:
+    uint32_t add(const PointLight& light) {
+        entries.push_back({ light, {}, true });
+        ++version;
+        return static_cast<uint32_t>(entries.size() - 1);
+    }
+
+    void set(uint32_t id, const PointLight& light) {
+        Entry& entry = entries[id];
+        if (entry.light.position != light.position || entry.light.radius != light.radius) entry.dirty = true;
+        if (entry.dirty || entry.light.color != light.color) ++version;
+        entry.light = light;
+    }
+
+    void clear() {
+        entries.clear();
+        ++version;
+    }
+
+    // Walls changed inside the world rectangle (minX, minY, maxX, maxY)
+    void invalidateRect(const glm::vec4& bounds) {
+        for (Entry& entry : entries) {
+            glm::vec2 position = entry.light.position;
+            float radius = entry.light.radius;
+            if (position.x + radius < bounds.x || position.x - radius > bounds.z ||
+                position.y + radius < bounds.y || position.y - radius > bounds.w) continue;
+            entry.dirty = true;
+            ++version;
+        }
+    }
+
+    void invalidateAll() {
+        for (Entry& entry : entries) entry.dirty = true;
+        ++version;
+    }
+
+    // Recompute the dirty polygons; on the pool when one is given
+    void update(const WallEdges& walls, ThreadPool* pool = nullptr) {
+        stats = LightingStats();
+        stats.lights = entries.size();
+        dirtyIds.clear();
+        for (uint32_t id = 0; id < entries.size(); ++id) {
+            if (entries[id].dirty) dirtyIds.push_back(id);
+        }
+        stats.rebuilt = dirtyIds.size();
+        if (dirtyIds.empty()) return;
+
+        unsigned threads = pool ? pool->threadCount() : 1;
+        if (scratch.size() < threads) scratch.resize(threads);
+        edgeCounts.assign(threads, 0);
+        auto rebuild = [&](size_t begin, size_t end, unsigned thread) {
+            for (size_t k = begin; k < end; ++k) {
+                Entry& entry = entries[dirtyIds[k]];
+                edgeCounts[thread] += computeVisibility(walls, entry.light.position, entry.light.radius,
+                                                        scratch[thread], entry.polygon);
+                entry.dirty = false;
+            }
+        };
+        if (pool) pool->parallelFor(dirtyIds.size(), 4, rebuild);
+        else rebuild(0, dirtyIds.size(), 0);
+
+        for (size_t count : edgeCounts) stats.edgesConsidered += count;
+        for (uint32_t id : dirtyIds) stats.polygonPoints += entries[id].polygon.size();
+    }
+
+    size_t size() const { return entries.size(); }
+    const PointLight& light(uint32_t id) const { return entries[id].light; }
+    const std::vector<glm::vec2>& polygon(uint32_t id) const { return entries[id].polygon; }
+
+    // Bumped whenever a polygon or a light's colour may have changed, so GPU copies know to refresh
+    uint64_t contentVersion() const { return version; }
+    const LightingStats& lastStats() const { return stats; }
+
+private:
+    struct Entry {
+        PointLight light;
+        std::vector<glm::vec2> polygon;
+        bool dirty;
+    };
+
+    std::vector<Entry> entries;
+    std::vector<uint32_t> dirtyIds;
+    std::vector<VisibilityScratch> scratch;
+    std::vector<size_t> edgeCounts;  // Per worker, summed into stats after the rebuild
+    LightingStats stats;
+    uint64_t version = 0;
+};
+
+#endif  // LIGHT_VISIBILITY_H
@@ -0,0 +1,100 @@
+#ifndef PARTICLE_RENDERER_H
+#define PARTICLE_RENDERER_H
+
+#include <glad/glad.h>
+#include "gl_state.h"
+#include "particle_system.h"
+#include "shader.h"
+#include "stream_buffer.h"
+
+// One instance per particle; the four corners of its quad come from gl_VertexID
+constexpr const char* PARTICLE_VERTEX_SHADER = R"(
+    #version 330 core
+    layout (location = 0) in vec3 aParticle;  // centre x, y, size
+    layout (location = 1) in vec4 aColor;
+    out vec2 Offset;
+    out vec4 Color;
+
+    layout (std140) uniform Camera {
+        mat4 projection;
+        mat4 view;
+    };
+
+    void main() {
+        Offset = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+        Color = aColor;
+        vec2 world = aParticle.xy + Offset * 0.5 * aParticle.z;
+        gl_Position = projection * view * vec4(world, 0.0, 1.0);
+    }
+)";
+
+// Round, soft-edged dot
+constexpr const char* PARTICLE_FRAGMENT_SHADER = R"(
+    #version 330 core
+    out vec4 FragColor;
+    in vec2 Offset;
+    in vec4 Color;
+
+    void main() {
+        float coverage = 1.0 - smoothstep(0.6, 1.0, length(Offset));
+        FragColor = vec4(Color.rgb, Color.a * coverage);
+    }
+)";
+
+// Draws a ParticleSystem as instanced quads: 16 bytes per particle go through
+// a stream buffer, written straight from the SoA arrays on the pool, and the
+// whole system is one draw call.
+class ParticleRenderer {
+public:
+    bool additive = false;  // Sparks and glows add up; dust and smoke blend
+
+    ParticleRenderer()
+        : shader(PARTICLE_VERTEX_SHADER, PARTICLE_FRAGMENT_SHADER),
+          instances(GL_ARRAY_BUFFER, 4 << 20) {
+        glGenVertexArrays(1, &vao);
+        glState().bindVertexArray(vao);
+        glEnableVertexAttribArray(0);
+        glVertexAttribDivisor(0, 1);
+        glEnableVertexAttribArray(1);
+        glVertexAttribDivisor(1, 1);
+    }
+
+    ~ParticleRenderer() { glState().deleteVertexArray(vao); }
+
+    ParticleRenderer(const ParticleRenderer&) = delete;
+    ParticleRenderer& operator=(const ParticleRenderer&) = delete;
+
+    // Uses the Camera block, so call after the camera buffer is updated
+    void draw(const ParticleSystem& particles, ThreadPool* pool = nullptr) {
+        size_t count = particles.count();
+        if (count == 0) return;
+
+        StreamAllocation allocation = instances.allocate(count * sizeof(ParticleInstance), sizeof(ParticleInstance));
+        particles.writeInstances(static_cast<ParticleInstance*>(allocation.data), pool);
+        instances.commit(allocation);
+
+        // Instanced attributes cannot take a base vertex, so point them at this frame's allocation
+        glState().bindVertexArray(vao);
+        glState().bindBuffer(GL_ARRAY_BUFFER, instances.buffer);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(ParticleInstance), (void*)allocation.offset);
+        glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ParticleInstance),
+                              (void*)(allocation.offset + 3 * sizeof(float)));
+        glState().countIssued(2);
+
+        shader.use();
+        glState().setBlend(true);
+        glState().blendFunc(GL_SRC_ALPHA, additive ? GL_ONE : GL_ONE_MINUS_SRC_ALPHA);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(count));
+        glState().countDrawCall();
+        instances.endFrame();
+    }
+
+    const StreamStats& streamStats() const { return instances.lastFrameStats(); }
+
+private:
+    Shader shader;
+    StreamBuffer instances;
+    GLuint vao = 0;
+};
+
+#endif  // PARTICLE_RENDERER_H
@@ -0,0 +1,296 @@
+#ifndef PARTICLE_SYSTEM_H
+#define PARTICLE_SYSTEM_H
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "thread_pool.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PARTICLES_SSE2 1
+#endif
+
+// Solid tiles, one bit each, row-major. Small enough to stay in cache while
+// a million particles test against it.
+class TileBitset {
+public:
+    template <typename IsWall>
+    void build(int columns, int rows, float size, IsWall&& isWall) {
+        width = columns;
+        height = rows;
+        tileSize = size;
+        inverseTileSize = 1.0f / size;
+        wordsPerRow = (columns + 63) / 64;
+        bits.assign(static_cast<size_t>(wordsPerRow) * rows, 0);
+        for (int j = 0; j < rows; ++j) {
+            for (int i = 0; i < columns; ++i) set(i, j, isWall(i, j));
+        }
+    }
+
+    void set(int column, int row, bool solid) {
+        uint64_t& word = bits[static_cast<size_t>(row) * wordsPerRow + column / 64];
+        uint64_t mask = uint64_t(1) << (column % 64);
+        word = solid ? word | mask : word & ~mask;
+    }
+
+    // Outside the map counts as open
+    bool test(int column, int row) const {
+        if (static_cast<unsigned>(column) >= static_cast<unsigned>(width) || static_cast<unsigned>(row) >= static_cast<unsigned>(height)) return false;
+        return (bits[static_cast<size_t>(row) * wordsPerRow + column / 64] >> (column % 64)) & 1;
+    }
+
+    bool testWorld(float x, float y) const {
+        return test(static_cast<int>(std::floor(x * inverseTileSize)), static_cast<int>(std::floor(y * inverseTileSize)));
+    }
+
+    float inverseSize() const { return inverseTileSize; }
+
+private:
+    int width = 0, height = 0, wordsPerRow = 0;
+    float tileSize = 1.0f, inverseTileSize = 1.0f;
+    std::vector<uint64_t> bits;
+};
+
+// How a batch of particles starts out; each value gets its jitter added uniformly
+struct ParticleEmitter {
+    glm::vec2 position;
+    float positionJitter = 0.0f;
+    glm::vec2 velocity = glm::vec2(0.0f);
+    float speedJitter = 0.0f;    // Random direction, up to this speed
+    float life = 1.0f;
+    float lifeJitter = 0.0f;
+    float size = 2.0f;
+    uint32_t color = 0xFFFFFFFFu;
+};
+
+// What the renderer reads per particle: centre, size and colour with the age fade applied
+struct ParticleInstance {
+    float x, y, size;
+    uint32_t color;
+};
+
+// Counters for the last ParticleSystem::update
+struct ParticleStats {
+    size_t alive = 0;
+    size_t died = 0;
+    size_t collisions = 0;
+};
+
+// Particles in structure-of-arrays form: each field is its own contiguous
+// array, so integration streams through memory four particles per SSE2 op.
+// Updates run in chunks on the pool; dead particles are collected per chunk
+// and removed afterwards by swapping the last live particle into each hole,
+// which costs the number of deaths, not the number of particles.
+class ParticleSystem {
+public:
+    glm::vec2 gravity = glm::vec2(0.0f, -300.0f);
+    float drag = 1.0f;           // Fraction of velocity lost per second (linearised per step)
+    float restitution = 0.4f;    // Speed kept when bouncing off a wall
+    const TileBitset* walls = nullptr;  // Collide against these when set
+
+    static constexpr size_t CHUNK = 16384;  // Particles per parallel job; a multiple of 4
+
+    explicit ParticleSystem(size_t maxParticles = 1 << 20) : capacity(maxParticles) {
+        for (std::vector<float>* field : { &x, &y, &vx, &vy, &life, &fade, &size }) field->resize(capacity);
+        color.resize(capacity);
+    }
+
+    // Spawn up to 'count' particles; returns how many fitted
+    size_t emit(const ParticleEmitter& emitter, size_t count) {
+        count = std::min(count, capacity - alive);
+        for (size_t n = 0; n < count; ++n) {
+            size_t i = alive + n;
+            float angle = random() * 6.2831853f, speed = random() * emitter.speedJitter;
+            x[i] = emitter.position.x + (random() * 2.0f - 1.0f) * emitter.positionJitter;
+            y[i] = emitter.position.y + (random() * 2.0f - 1.0f) * emitter.positionJitter;
+            vx[i] = emitter.velocity.x + std::cos(angle) * speed;
+            vy[i] = emitter.velocity.y + std::sin(angle) * speed;
+            life[i] = std::max(emitter.life + (random() * 2.0f - 1.0f) * emitter.lifeJitter, 1e-3f);
+            fade[i] = 1.0f / life[i];
+            size[i] = emitter.size;
+            color[i] = emitter.color;
+        }
+        alive += count;
+        return count;
+    }
+
+    void update(float dt, ThreadPool* pool = nullptr) {
+        stats = ParticleStats();
+        size_t chunks = (alive + CHUNK - 1) / CHUNK;
+        if (deadPerChunk.size() < chunks) deadPerChunk.resize(chunks);
+        collisionsPerChunk.assign(chunks, 0);
+
+        auto integrate = [&](size_t begin, size_t end, unsigned) {
+            for (size_t chunk = begin; chunk < end; ++chunk) {
+                size_t first = chunk * CHUNK;
+                integrateRange(first, std::min(alive, first + CHUNK), dt, deadPerChunk[chunk], collisionsPerChunk[chunk]);
+            }
+        };
+        if (pool) pool->parallelFor(chunks, 1, integrate);
+        else integrate(0, chunks, 0);
+
+        // Highest index first, so the particle swapped into a hole is always alive
+        for (size_t chunk = chunks; chunk-- > 0;) {
+            const std::vector<uint32_t>& dead = deadPerChunk[chunk];
+            for (size_t k = dead.size(); k-- > 0;) removeAt(dead[k]);
+            stats.died += dead.size();
+            stats.collisions += collisionsPerChunk[chunk];
+        }
+        stats.alive = alive;
+    }
+
+    // Fill 'out' with alive() instances; on the pool when one is given
+    void writeInstances(ParticleInstance* out, ThreadPool* pool = nullptr) const {
+        auto write = [&](size_t begin, size_t end, unsigned) {
+            size_t i = begin;
+#ifdef PARTICLES_SSE2
+            // Four particles per step, transposed from SoA into the instance layout
+            const __m128 one = _mm_set1_ps(1.0f);
+            const __m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+            for (; i + 4 <= end; i += 4) {
+                __m128i rgba = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&color[i]));
+                __m128 remaining = _mm_min_ps(_mm_mul_ps(_mm_loadu_ps(&life[i]), _mm_loadu_ps(&fade[i])), one);
+                __m128i alpha = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(rgba, 24)), remaining));
+                __m128i faded = _mm_or_si128(_mm_and_si128(rgba, rgbMask), _mm_slli_epi32(alpha, 24));
+
+                __m128 r0 = _mm_loadu_ps(&x[i]), r1 = _mm_loadu_ps(&y[i]), r2 = _mm_loadu_ps(&size[i]);
+                __m128 r3 = _mm_castsi128_ps(faded);
+                _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+                float* destination = reinterpret_cast<float*>(&out[i]);
+                _mm_storeu_ps(destination, r0);
+                _mm_storeu_ps(destination + 4, r1);
+                _mm_storeu_ps(destination + 8, r2);
+                _mm_storeu_ps(destination + 12, r3);
+            }
+#endif
+            for (; i < end; ++i) {
+                // Alpha fades out with the remaining life
+                uint32_t alpha = static_cast<uint32_t>((color[i] >> 24) * std::min(life[i] * fade[i], 1.0f));
+                out[i] = { x[i], y[i], size[i], (color[i] & 0x00FFFFFFu) | (alpha << 24) };
+            }
+        };
+        if (pool) pool->parallelFor(alive, CHUNK, write);
+        else write(0, alive, 0);
+    }
+
+    size_t count() const { return alive; }
+    size_t maxParticles() const { return capacity; }
+    void clear() { alive = 0; }
+    const ParticleStats& lastStats() const { return stats; }
+
+    const float* positionsX() const { return x.data(); }
+    const float* positionsY() const { return y.data(); }
+
+private:
+    size_t capacity;
+    size_t alive = 0;
+    std::vector<float> x, y, vx, vy, life, fade, size;  // fade = 1 / starting life
+    std::vector<uint32_t> color;
+    std::vector<std::vector<uint32_t>> deadPerChunk;
+    std::vector<size_t> collisionsPerChunk;
+    uint32_t seed = 0x9E3779B9u;
+    ParticleStats stats;
+
+    // xorshift32, in [0, 1)
+    float random() {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        return (seed >> 8) * (1.0f / 16777216.0f);
+    }
+
+    void removeAt(size_t i) {
+        size_t last = --alive;
+        x[i] = x[last];
+        y[i] = y[last];
+        vx[i] = vx[last];
+        vy[i] = vy[last];
+        life[i] = life[last];
+        fade[i] = fade[last];
+        size[i] = size[last];
+        color[i] = color[last];
+    }
+
+    // Undo the axis that moved into a solid tile and bounce along it
+    bool collide(size_t i, float oldX, float oldY) {
+        if (!walls->testWorld(x[i], y[i])) return false;
+        if (walls->testWorld(x[i], oldY)) {
+            x[i] = oldX;
+            vx[i] *= -restitution;
+        }
+        if (walls->testWorld(x[i], y[i])) {
+            y[i] = oldY;
+            vy[i] *= -restitution;
+        }
+        return true;
+    }
+
+#ifdef PARTICLES_SSE2
+    // floor() for SSE2: truncate, then step down where truncation rounded up
+    static __m128i floorToInt(__m128 value) {
+        __m128i truncated = _mm_cvttps_epi32(value);
+        __m128 roundedUp = _mm_cmplt_ps(value, _mm_cvtepi32_ps(truncated));
+        return _mm_add_epi32(truncated, _mm_castps_si128(roundedUp));
+    }
+#endif
+
+    void integrateOne(size_t i, float dt, float damping) {
+        vx[i] = vx[i] * damping + gravity.x * dt;
+        vy[i] = vy[i] * damping + gravity.y * dt;
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+        life[i] -= dt;
+    }
+
+    void integrateRange(size_t begin, size_t end, float dt, std::vector<uint32_t>& dead, size_t& collisions) {
+        dead.clear();
+        float damping = std::max(1.0f - drag * dt, 0.0f);
+        size_t i = begin;
+#ifdef PARTICLES_SSE2
+        const __m128 vdt = _mm_set1_ps(dt), vdamping = _mm_set1_ps(damping);
+        const __m128 gx = _mm_set1_ps(gravity.x * dt), gy = _mm_set1_ps(gravity.y * dt);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 inverseTile = _mm_set1_ps(walls ? walls->inverseSize() : 1.0f);
+        for (; i + 4 <= end; i += 4) {
+            __m128 px = _mm_loadu_ps(&x[i]), py = _mm_loadu_ps(&y[i]);
+            __m128 velX = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&vx[i]), vdamping), gx);
+            __m128 velY = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&vy[i]), vdamping), gy);
+            __m128 remaining = _mm_sub_ps(_mm_loadu_ps(&life[i]), vdt);
+            _mm_storeu_ps(&vx[i], velX);
+            _mm_storeu_ps(&vy[i], velY);
+            _mm_storeu_ps(&x[i], _mm_add_ps(px, _mm_mul_ps(velX, vdt)));
+            _mm_storeu_ps(&y[i], _mm_add_ps(py, _mm_mul_ps(velY, vdt)));
+            _mm_storeu_ps(&life[i], remaining);
+
+            if (walls) {
+                // Tile coordinates for all four at once; only lanes that hit a wall go scalar
+                alignas(16) int32_t column[4], row[4];
+                _mm_store_si128(reinterpret_cast<__m128i*>(column), floorToInt(_mm_mul_ps(_mm_loadu_ps(&x[i]), inverseTile)));
+                _mm_store_si128(reinterpret_cast<__m128i*>(row), floorToInt(_mm_mul_ps(_mm_loadu_ps(&y[i]), inverseTile)));
+                for (int lane = 0; lane < 4; ++lane) {
+                    if (!walls->test(column[lane], row[lane])) continue;
+                    alignas(16) float oldX[4], oldY[4];
+                    _mm_store_ps(oldX, px);
+                    _mm_store_ps(oldY, py);
+                    collisions += collide(i + lane, oldX[lane], oldY[lane]);
+                }
+            }
+            int expired = _mm_movemask_ps(_mm_cmple_ps(remaining, zero));
+            for (int lane = 0; expired != 0 && lane < 4; ++lane) {
+                if (expired & (1 << lane)) dead.push_back(static_cast<uint32_t>(i + lane));
+            }
+        }
+#endif
+        for (; i < end; ++i) {
+            float oldX = x[i], oldY = y[i];
+            integrateOne(i, dt, damping);
+            if (walls) collisions += collide(i, oldX, oldY);
+            if (life[i] <= 0.0f) dead.push_back(static_cast<uint32_t>(i));
+        }
+    }
+};
+
+#endif  // PARTICLE_SYSTEM_H
@@ -0,0 +1,322 @@
+#ifndef POST_PROCESS_H
+#define POST_PROCESS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include "gl_state.h"
+#include "render_target.h"
+#include "shader.h"
+
+// Full-screen triangle from gl_VertexID, as in the light composite
+constexpr const char* POST_VERTEX_SHADER = R"(
+    #version 330 core
+    out vec2 TexCoord;
+    void main() {
+        vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+        TexCoord = corner * 2.0;
+        gl_Position = vec4(corner * 4.0 - 1.0, 0.0, 1.0);
+    }
+)";
+
+// Bright parts of the scene at half resolution. Four bilinear taps one source
+// texel off the centre average a 4x4 block; the soft knee keeps colours just
+// under the threshold from popping in.
+constexpr const char* BLOOM_PREFILTER_FRAGMENT_SHADER = R"(
+    #version 330 core
+    out vec4 FragColor;
+    in vec2 TexCoord;
+    uniform sampler2D source;
+    uniform vec2 texelSize;
+    uniform vec2 threshold;  // Threshold, knee
+
+    void main() {
+        vec3 color = texture(source, TexCoord + vec2(-texelSize.x, -texelSize.y)).rgb
+                   + texture(source, TexCoord + vec2( texelSize.x, -texelSize.y)).rgb
+                   + texture(source, TexCoord + vec2(-texelSize.x,  texelSize.y)).rgb
+                   + texture(source, TexCoord + vec2( texelSize.x,  texelSize.y)).rgb;
+        color *= 0.25;
+        float brightness = max(color.r, max(color.g, color.b));
+        float soft = clamp(brightness - threshold.x + threshold.y, 0.0, 2.0 * threshold.y);
+        soft = soft * soft / (4.0 * threshold.y + 1e-5);
+        FragColor = vec4(color * (max(soft, brightness - threshold.x) / max(brightness, 1e-5)), 1.0);
+    }
+)";
+
+// Nine-tap Gaussian along 'direction' in five fetches, using bilinear filtering for the pairs
+constexpr const char* BLOOM_BLUR_FRAGMENT_SHADER = R"(
+    #version 330 core
+    out vec4 FragColor;
+    in vec2 TexCoord;
+    uniform sampler2D source;
+    uniform vec2 direction;  // One texel across or down
+
+    void main() {
+        vec3 color = texture(source, TexCoord).rgb * 0.2270270270;
+        color += (texture(source, TexCoord + direction * 1.3846153846).rgb + texture(source, TexCoord - direction * 1.3846153846).rgb) * 0.3162162162;
+        color += (texture(source, TexCoord + direction * 3.2307692308).rgb + texture(source, TexCoord - direction * 3.2307692308).rgb) * 0.0702702703;
+        FragColor = vec4(color, 1.0);
+    }
+)";
+
+// Per-pixel effect as pieces of the fused shader's main(). 'warp' moves 'uv'
+// before the source is read; 'shade' changes 'color', which was read at 'uv'.
+struct PostStage {
+    uint32_t bit;
+    const char* uniforms;
+    const char* warp;   // nullptr when the effect leaves pixels where they are
+    const char* shade;
+};
+
+namespace PostEffectBits {
+    constexpr uint32_t BLOOM = 1;
+    constexpr uint32_t GRADING = 2;
+    constexpr uint32_t VIGNETTE = 4;
+    constexpr uint32_t CRT = 8;
+}
+
+// In chain order; bloom's own passes run before the fused one and only its add is fused
+constexpr PostStage POST_STAGES[] = {
+    { PostEffectBits::BLOOM,
+      "uniform sampler2D bloomTexture;\n"
+      "uniform float bloomIntensity;\n",
+      nullptr,
+      "color += texture(bloomTexture, uv).rgb * bloomIntensity;\n" },
+    { PostEffectBits::GRADING,
+      "uniform vec3 gradingTint;\n"         // Tint times exposure
+      "uniform vec2 gradingContrast;\n",    // Contrast, saturation
+      nullptr,
+      "color *= gradingTint;\n"
+      "color = (color - 0.5) * gradingContrast.x + 0.5;\n"
+      "color = max(mix(vec3(dot(color, vec3(0.2126, 0.7152, 0.0722))), color, gradingContrast.y), 0.0);\n" },
+    { PostEffectBits::VIGNETTE,
+      "uniform vec3 vignette;\n",           // Intensity, radius, softness
+      nullptr,
+      "color *= 1.0 - vignette.x * smoothstep(vignette.y, vignette.y + vignette.z, length(uv - 0.5) * 1.4142136);\n" },
+    { PostEffectBits::CRT,
+      "uniform vec3 crt;\n",                // Curvature, scanline and mask strength
+      "vec2 centered = uv * 2.0 - 1.0;\n"
+      "uv = (centered + centered * centered.yx * centered.yx * crt.x) * 0.5 + 0.5;\n",
+      "vec2 inside = step(vec2(0.0), uv) * step(uv, vec2(1.0));\n"
+      "vec3 mask = vec3(1.0 - crt.z);\n"
+      "mask[int(mod(gl_FragCoord.x, 3.0))] = 1.0;\n"
+      "color *= mask * (1.0 - crt.y * mod(floor(gl_FragCoord.y), 2.0)) * (inside.x * inside.y);\n" },
+};
+
+struct ColorGrading {
+    bool enabled = false;
+    float exposure = 1.0f;
+    float contrast = 1.0f;
+    float saturation = 1.0f;
+    glm::vec3 tint = glm::vec3(1.0f);
+};
+
+struct Vignette {
+    bool enabled = false;
+    float intensity = 0.4f;
+    float radius = 0.6f;     // Distance from the centre where darkening starts; 1 is a corner
+    float softness = 0.5f;
+};
+
+struct Bloom {
+    bool enabled = false;
+    float threshold = 0.7f;
+    float knee = 0.2f;
+    float intensity = 0.8f;
+};
+
+struct CrtFilter {
+    bool enabled = false;
+    float curvature = 0.06f;
+    float scanlines = 0.25f;  // Darkening of every other output row
+    float mask = 0.2f;        // Darkening of the two other channels in each RGB column
+};
+
+struct PostProcessStats {
+    uint32_t passes = 0;        // Full-screen draws, bloom's included
+    uint32_t fusedEffects = 0;  // Effects sharing the final pass
+    size_t programs = 0;        // Fused variants compiled so far
+};
+
+// Optional screen effects over the finished world. Every per-pixel effect that
+// is enabled goes into one generated shader, compiled the first time that set
+// of effects is used, so grading, vignette, CRT and bloom's add cost a single
+// pass between them; that pass also does the upscale from the render
+// resolution. Only bloom's blur needs passes of its own, through targets from
+// the pool. CRT's curvature is the only warp and runs before the source is
+// read, which moves the effects before it along with the picture. With nothing
+// enabled active() is false and the caller draws straight to the window.
+class PostProcessChain {
+public:
+    ColorGrading grading;
+    Vignette vignette;
+    Bloom bloom;
+    CrtFilter crt;
+
+    explicit PostProcessChain(RenderTargetPool& pool)
+        : targets(pool),
+          prefilterShader(POST_VERTEX_SHADER, BLOOM_PREFILTER_FRAGMENT_SHADER),
+          blurShader(POST_VERTEX_SHADER, BLOOM_BLUR_FRAGMENT_SHADER) {
+        prefilterSource = prefilterShader.uniform("source");
+        prefilterTexelSize = prefilterShader.uniform("texelSize");
+        prefilterThreshold = prefilterShader.uniform("threshold");
+        blurSource = blurShader.uniform("source");
+        blurDirection = blurShader.uniform("direction");
+        glGenVertexArrays(1, &emptyVao);
+    }
+
+    ~PostProcessChain() { glState().deleteVertexArray(emptyVao); }
+
+    PostProcessChain(const PostProcessChain&) = delete;
+    PostProcessChain& operator=(const PostProcessChain&) = delete;
+
+    uint32_t enabledEffects() const {
+        return (bloom.enabled ? PostEffectBits::BLOOM : 0u) | (grading.enabled ? PostEffectBits::GRADING : 0u) |
+               (vignette.enabled ? PostEffectBits::VIGNETTE : 0u) | (crt.enabled ? PostEffectBits::CRT : 0u);
+    }
+    bool active() const { return enabledEffects() != 0; }
+
+    // Run the chain on 'source' (sourceWidth x sourceHeight) into 'destination',
+    // the window by default, and leave that bound at outputWidth x outputHeight
+    void apply(GLuint source, int sourceWidth, int sourceHeight, int outputWidth, int outputHeight,
+               GLuint destination = 0) {
+        uint32_t effects = enabledEffects();
+        stats = PostProcessStats();
+        glState().setBlend(false);
+        glState().bindVertexArray(emptyVao);
+
+        const RenderTarget* bloomTarget = effects & PostEffectBits::BLOOM ? blur(source, sourceWidth, sourceHeight) : nullptr;
+
+        const FusedProgram& fused = program(effects);
+        fused.shader.use();
+        glState().bindTexture(0, source);
+        Shader::setInt(fused.source, 0);
+        glState().countIssued();
+        if (bloomTarget) {
+            glState().bindTexture(1, bloomTarget->colorTexture);
+            Shader::setInt(fused.bloomTexture, 1);
+            Shader::setFloat(fused.bloomIntensity, bloom.intensity);
+            glState().countIssued(2);
+        }
+        if (effects & PostEffectBits::GRADING) {
+            glm::vec3 tint = grading.tint * grading.exposure;
+            glUniform3f(fused.gradingTint, tint.r, tint.g, tint.b);
+            Shader::setVec2(fused.gradingContrast, glm::vec2(grading.contrast, grading.saturation));
+            glState().countIssued(2);
+        }
+        if (effects & PostEffectBits::VIGNETTE) {
+            glUniform3f(fused.vignette, vignette.intensity, vignette.radius, vignette.softness);
+            glState().countIssued();
+        }
+        if (effects & PostEffectBits::CRT) {
+            glUniform3f(fused.crt, crt.curvature, crt.scanlines, crt.mask);
+            glState().countIssued();
+        }
+        glState().bindFramebuffer(GL_FRAMEBUFFER, destination);
+        glState().viewport(0, 0, outputWidth, outputHeight);
+        drawPass();
+        if (bloomTarget) targets.release(*bloomTarget);
+
+        for (const PostStage& stage : POST_STAGES) stats.fusedEffects += (effects & stage.bit) ? 1 : 0;
+        stats.programs = programs.size();
+    }
+
+    // The fused shader for a set of PostEffectBits
+    static std::string fragmentSource(uint32_t effects) {
+        std::string source =
+            "#version 330 core\n"
+            "out vec4 FragColor;\n"
+            "in vec2 TexCoord;\n"
+            "uniform sampler2D source;\n";
+        for (const PostStage& stage : POST_STAGES) {
+            if (effects & stage.bit) source += stage.uniforms;
+        }
+        source += "void main() {\nvec2 uv = TexCoord;\n";
+        // Later warps first: each one moves what the effects before it produced
+        for (size_t i = sizeof(POST_STAGES) / sizeof(POST_STAGES[0]); i-- > 0;) {
+            if ((effects & POST_STAGES[i].bit) && POST_STAGES[i].warp) source += POST_STAGES[i].warp;
+        }
+        source += "vec3 color = texture(source, uv).rgb;\n";
+        for (const PostStage& stage : POST_STAGES) {
+            if ((effects & stage.bit) && stage.shade) source += stage.shade;
+        }
+        source += "FragColor = vec4(color, 1.0);\n}\n";
+        return source;
+    }
+
+    const PostProcessStats& lastStats() const { return stats; }
+
+private:
+    struct FusedProgram {
+        Shader shader;
+        GLint source, bloomTexture, bloomIntensity, gradingTint, gradingContrast, vignette, crt;
+    };
+
+    RenderTargetPool& targets;
+    Shader prefilterShader;
+    Shader blurShader;
+    GLint prefilterSource, prefilterTexelSize, prefilterThreshold, blurSource, blurDirection;
+    GLuint emptyVao = 0;
+    std::unordered_map<uint32_t, FusedProgram> programs;
+    PostProcessStats stats;
+
+    const FusedProgram& program(uint32_t effects) {
+        auto it = programs.find(effects);
+        if (it != programs.end()) return it->second;
+
+        FusedProgram fused;
+        fused.shader.load(POST_VERTEX_SHADER, fragmentSource(effects).c_str());
+        fused.source = fused.shader.uniform("source");
+        fused.bloomTexture = fused.shader.uniform("bloomTexture");
+        fused.bloomIntensity = fused.shader.uniform("bloomIntensity");
+        fused.gradingTint = fused.shader.uniform("gradingTint");
+        fused.gradingContrast = fused.shader.uniform("gradingContrast");
+        fused.vignette = fused.shader.uniform("vignette");
+        fused.crt = fused.shader.uniform("crt");
+        return programs.emplace(effects, std::move(fused)).first->second;
+    }
+
+    void drawPass() {
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glState().countDrawCall();
+        ++stats.passes;
+    }
+
+    // Prefilter to half resolution, then blur there across and down. The result
+    // stays acquired until the fused pass has read it.
+    const RenderTarget* blur(GLuint source, int sourceWidth, int sourceHeight) {
+        int width = std::max(1, sourceWidth / 2), height = std::max(1, sourceHeight / 2);
+        RenderTarget& bright = targets.acquire(width, height, GL_R11F_G11F_B10F);
+        RenderTarget& across = targets.acquire(width, height, GL_R11F_G11F_B10F);
+
+        prefilterShader.use();
+        glState().bindTexture(0, source);
+        Shader::setInt(prefilterSource, 0);
+        Shader::setVec2(prefilterTexelSize, glm::vec2(1.0f / sourceWidth, 1.0f / sourceHeight));
+        Shader::setVec2(prefilterThreshold, glm::vec2(bloom.threshold, bloom.knee));
+        glState().countIssued(3);
+        bright.bind();
+        drawPass();
+
+        blurShader.use();
+        Shader::setInt(blurSource, 0);
+        glState().countIssued();
+        const glm::vec2 texel(1.0f / width, 1.0f / height);
+        for (int pass = 0; pass < 2; ++pass) {
+            const RenderTarget& from = pass == 0 ? bright : across;
+            const RenderTarget& to = pass == 0 ? across : bright;
+            glState().bindTexture(0, from.colorTexture);
+            Shader::setVec2(blurDirection, pass == 0 ? glm::vec2(texel.x, 0.0f) : glm::vec2(0.0f, texel.y));
+            glState().countIssued();
+            to.bind();
+            drawPass();
+        }
+        targets.release(across);
+        return &bright;
+    }
+};
+
+#endif  // POST_PROCESS_H
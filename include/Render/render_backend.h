@@ -0,0 +1,57 @@
+#ifndef RENDER_BACKEND_H
+#define RENDER_BACKEND_H
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
+#include "image.h"
+#include "image_cache.h"
+#include "render_queue.h"
+#include "sprite_mesh.h"
+#include "texture_container.h"
+#include "texture_cook.h"
+
+// What the game needs from a renderer: textures, a camera and a sorted queue to
+// execute. Texture handles go into RenderCommand::texture, so the same queue
+// renders on the GL backend or on the CPU rasterizer.
+class RenderBackend {
+public:
+    virtual ~RenderBackend() = default;
+
+    virtual uint32_t createTexture(const Image& image) = 0;
+    virtual void destroyTexture(uint32_t texture) = 0;
+
+    // Create from a cooked container; backends that can take the stored levels as they are override this
+    virtual uint32_t createCookedTexture(const TextureContainer& container) {
+        Image image;
+        decodeTextureLevel(container, 0, image);
+        return createTexture(image);
+    }
+
+    // Decode and create in one step; 0 when the file cannot be read.
+    // An up-to-date cooked .tex next to the file is used instead when there is one,
+    // and otherwise the decoded levels an earlier run left in the image cache.
+    virtual uint32_t loadTexture(const char* path) {
+        std::string cooked = cookedTexturePath(path);
+        TextureContainer container;
+        if (!cooked.empty() && container.open(cooked.c_str())) return createCookedTexture(container);
+        if (imageCache().load(path, ImageDecodeOptions(), container)) return createCookedTexture(container);
+
+        Image image;
+        if (!loadImage(path, image)) return 0;
+        return createTexture(image);
+    }
+
+    // Outlines for commands with a RenderCommand::mesh; without a table every command is a quad
+    virtual void setSpriteMeshes(const SpriteMeshTable* meshes) = 0;
+
+    // Shader id for the plain textured sprite program
+    virtual uint8_t spriteShader() const { return 0; }
+
+    virtual void beginFrame(int width, int height, const glm::vec4& clearColor) = 0;
+    virtual void setCamera(const glm::mat4& projection, const glm::mat4& view) = 0;
+    virtual void draw(const RenderQueue& sortedQueue) = 0;
+    virtual void endFrame() = 0;
+};
+
+#endif  // RENDER_BACKEND_H
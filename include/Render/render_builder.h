@@ -0,0 +1,80 @@
+#ifndef RENDER_BUILDER_H
+#define RENDER_BUILDER_H
+
+#include <cstring>
+#include <vector>
+#include "render_queue.h"
+#include "sprite_mesh.h"
+#include "thread_pool.h"
+
+// Builds one frame's RenderQueue on the worker threads. Every chunk is culled
+// and submitted into its own queue, so no two threads share a buffer, then the
+// chunk queues are copied into the frame queue in parallel. Merging in chunk
+// order keeps the result identical whatever thread ran which chunk.
+// Only the frame thread touches GL.
+class ParallelRenderBuilder {
+public:
+    explicit ParallelRenderBuilder(ThreadPool& threadPool) : pool(threadPool) {}
+
+    // fn(chunkIndex, chunkQueue) is called once per chunk, on any thread.
+    // The results are appended to 'out' after whatever it already holds.
+    template <typename Fn>
+    void build(size_t chunkCount, Fn&& fn, RenderQueue& out) {
+        if (chunkQueues.size() < chunkCount) chunkQueues.resize(chunkCount);
+        offsets.resize(chunkCount + 1);
+
+        pool.parallelFor(chunkCount, 1, [&](size_t begin, size_t end, unsigned) {
+            for (size_t chunk = begin; chunk < end; ++chunk) {
+                chunkQueues[chunk].clear();
+                fn(chunk, chunkQueues[chunk]);
+            }
+        });
+
+        // Each chunk gets a disjoint slice of the output
+        offsets[0] = out.size();
+        for (size_t i = 0; i < chunkCount; ++i) {
+            offsets[i + 1] = offsets[i] + chunkQueues[i].size();
+        }
+        out.resizeForMerge(offsets[chunkCount]);
+
+        pool.parallelFor(chunkCount, 4, [&](size_t begin, size_t end, unsigned) {
+            for (size_t i = begin; i < end; ++i) {
+                const RenderQueue& local = chunkQueues[i];
+                if (local.empty()) continue;
+
+                size_t base = offsets[i];
+                std::memcpy(out.commandData() + base, local.getCommands().data(), local.size() * sizeof(RenderCommand));
+                SortEntry* entries = out.entryData() + base;
+                const std::vector<SortEntry>& source = local.getEntries();
+                for (size_t j = 0; j < source.size(); ++j) {
+                    entries[j] = { source[j].key, static_cast<uint32_t>(base + source[j].index), 0 };
+                }
+            }
+        });
+    }
+
+    // Turn a sorted queue into quad vertices, four per command in sorted order, or
+    // with 'meshes' into SpriteMesh::MAX_VERTICES fan vertices per command.
+    // 'vertices' may be mapped GL memory; the workers only write to it.
+    void buildVertices(const RenderQueue& queue, SpriteVertex* vertices, const SpriteMeshTable* meshes = nullptr) {
+        pool.parallelFor(queue.size(), 4096, [&](size_t begin, size_t end, unsigned) {
+            if (!meshes) {
+                for (size_t i = begin; i < end; ++i) writeQuadVertices(queue.sorted(i), &vertices[i * 4]);
+                return;
+            }
+            for (size_t i = begin; i < end; ++i) {
+                const RenderCommand& cmd = queue.sorted(i);
+                writeMeshVertices(cmd, (*meshes)[cmd.mesh], &vertices[i * SpriteMesh::MAX_VERTICES]);
+            }
+        });
+    }
+
+    ThreadPool& threadPool() { return pool; }
+
+private:
+    ThreadPool& pool;
+    std::vector<RenderQueue> chunkQueues;
+    std::vector<size_t> offsets;
+};
+
+#endif  // RENDER_BUILDER_H
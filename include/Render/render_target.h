@@ -0,0 +1,143 @@
+#ifndef RENDER_TARGET_H
+#define RENDER_TARGET_H
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "gl_state.h"
+
+// Framebuffer object with one colour texture, for offscreen rendering. RGBA8
+// unless another colour-renderable format is asked for, e.g. GL_R11F_G11F_B10F
+// for values above 1.
+class RenderTarget {
+public:
+    GLuint framebuffer = 0;
+    GLuint colorTexture = 0;
+    int width = 0;
+    int height = 0;
+    GLenum format = GL_RGBA8;
+
+    RenderTarget() = default;
+    RenderTarget(int w, int h, GLenum internalFormat = GL_RGBA8) { resize(w, h, internalFormat); }
+
+    ~RenderTarget() { release(); }
+
+    RenderTarget(const RenderTarget&) = delete;
+    RenderTarget& operator=(const RenderTarget&) = delete;
+
+    // (Re)allocate storage; a no-op when the size and format are unchanged
+    bool resize(int w, int h, GLenum internalFormat = GL_RGBA8) {
+        if (framebuffer && w == width && h == height && internalFormat == format) return true;
+        release();
+        width = w;
+        height = h;
+        format = internalFormat;
+
+        glGenTextures(1, &colorTexture);
+        glState().bindTexture(0, colorTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+        glGenFramebuffers(1, &framebuffer);
+        glState().bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+        glState().countIssued(8);
+
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "ERROR::FRAMEBUFFER::INCOMPLETE " << width << "x" << height << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Draw into (and read from) this target, covering all of it
+    void bind() const {
+        glState().bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glState().viewport(0, 0, width, height);
+    }
+
+    static void bindDefault(int w, int h) {
+        glState().bindFramebuffer(GL_FRAMEBUFFER, 0);
+        glState().viewport(0, 0, w, h);
+    }
+
+    size_t bytes() const {
+        size_t texel = format == GL_RGBA16F || format == GL_RG32F ? 8 : format == GL_RGBA32F ? 16 : 4;
+        return static_cast<size_t>(width) * height * texel;
+    }
+
+private:
+    void release() {
+        if (framebuffer) glState().deleteFramebuffer(framebuffer);
+        if (colorTexture) glState().deleteTexture(colorTexture);
+        framebuffer = colorTexture = 0;
+    }
+};
+
+// Targets that passes only need for part of a frame. acquire() hands out an
+// idle target of the same size and format when there is one, so a chain of
+// passes allocates nothing after its first frame; targets nobody acquired for
+// 'maxIdleFrames' are freed in endFrame(), e.g. the old sizes after a resize.
+class RenderTargetPool {
+public:
+    int maxIdleFrames = 120;
+
+    RenderTarget& acquire(int width, int height, GLenum format = GL_RGBA8) {
+        for (Entry& entry : entries) {
+            const RenderTarget& target = *entry.target;
+            if (!entry.inUse && target.width == width && target.height == height && target.format == format) {
+                entry.inUse = true;
+                entry.lastUsed = frame;
+                return *entry.target;
+            }
+        }
+        entries.push_back({ std::make_unique<RenderTarget>(width, height, format), true, frame });
+        ++allocationCount;
+        return *entries.back().target;
+    }
+
+    // Back to the pool; its contents stay until someone else acquires it
+    void release(const RenderTarget& target) {
+        for (Entry& entry : entries) {
+            if (entry.target.get() == &target) entry.inUse = false;
+        }
+    }
+
+    // Call once per frame, after the last pass released its targets
+    void endFrame() {
+        ++frame;
+        for (size_t i = entries.size(); i-- > 0;) {
+            if (!entries[i].inUse && frame - entries[i].lastUsed > static_cast<uint64_t>(maxIdleFrames)) {
+                entries[i] = std::move(entries.back());
+                entries.pop_back();
+            }
+        }
+    }
+
+    size_t size() const { return entries.size(); }
+    size_t bytes() const {
+        size_t total = 0;
+        for (const Entry& entry : entries) total += entry.target->bytes();
+        return total;
+    }
+    // Targets created so far; stays put once the passes' sizes settle
+    uint32_t allocations() const { return allocationCount; }
+
+private:
+    struct Entry {
+        std::unique_ptr<RenderTarget> target;  // Stable address while the vector grows
+        bool inUse;
+        uint64_t lastUsed;
+    };
+
+    std::vector<Entry> entries;
+    uint64_t frame = 0;
+    uint32_t allocationCount = 0;
+};
+
+#endif  // RENDER_TARGET_H
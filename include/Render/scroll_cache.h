@@ -0,0 +1,193 @@
+#ifndef SCROLL_CACHE_H
+#define SCROLL_CACHE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "gl_state.h"
+#include "render_target.h"
+#include "shader.h"
+
+// Copies the cache to the screen: every screen pixel fetches its world pixel modulo the cache size
+constexpr const char* SCROLL_COMPOSITE_VERTEX_SHADER = R"(
+    #version 330 core
+    void main() {
+        vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+        gl_Position = vec4(corner * 4.0 - 1.0, 0.0, 1.0);
+    }
+)";
+
+constexpr const char* SCROLL_COMPOSITE_FRAGMENT_SHADER = R"(
+    #version 330 core
+    out vec4 FragColor;
+
+    uniform sampler2D cache;
+    uniform vec2 viewOrigin;
+    uniform vec2 cacheSize;
+
+    void main() {
+        vec2 world = floor(gl_FragCoord.xy) + viewOrigin;
+        FragColor = texelFetch(cache, ivec2(mod(world, cacheSize)), 0);
+    }
+)";
+
+// What the last ScrollCache::update redrew
+struct ScrollCacheStats {
+    uint32_t regions = 0;      // Wrapped sub-rectangles drawn
+    uint64_t pixels = 0;       // Cache texels redrawn
+    bool fullRedraw = false;
+};
+
+// Static layers rendered once into an offscreen texture a margin larger than
+// the view and addressed toroidally: world pixel p lives at texel p mod size.
+// When the view leaves the cached area the cache recentres and only the newly
+// exposed strips are drawn; the rest stays valid where it is, so scrolling
+// costs the strip area instead of the whole layer.
+// Coordinates are world units times zoom ("world pixels"). The composite snaps
+// to whole pixels, so the static layer moves in pixel steps.
+class ScrollCache {
+public:
+    explicit ScrollCache(int marginPixels = 32)
+        : margin(marginPixels), composite(SCROLL_COMPOSITE_VERTEX_SHADER, SCROLL_COMPOSITE_FRAGMENT_SHADER) {
+        glGenVertexArrays(1, &vao);
+        cacheLocation = composite.uniform("cache");
+        viewOriginLocation = composite.uniform("viewOrigin");
+        cacheSizeLocation = composite.uniform("cacheSize");
+    }
+
+    ~ScrollCache() { glState().deleteVertexArray(vao); }
+
+    ScrollCache(const ScrollCache&) = delete;
+    ScrollCache& operator=(const ScrollCache&) = delete;
+
+    // Drop everything, e.g. after loading a map
+    void invalidate() { valid = false; }
+
+    // Mark a world-unit rectangle (minX, minY, maxX, maxY) for redraw, e.g. an edited tile
+    void invalidateRect(const glm::vec4& worldBounds) { dirty.push_back(worldBounds); }
+
+    // Bring the cache up to date for a view whose bottom-left screen pixel shows
+    // world point 'viewOrigin'. drawRegion(worldBounds, projection) must draw the
+    // static layer with that projection and an identity view; viewport and
+    // scissor are already set. Leaves the cache bound as the framebuffer.
+    template <typename DrawRegion>
+    void update(int viewWidth, int viewHeight, float zoom, const glm::vec2& viewOrigin, DrawRegion&& drawRegion) {
+        stats = ScrollCacheStats();
+        if (target.width != viewWidth + 2 * margin || target.height != viewHeight + 2 * margin) {
+            target.resize(viewWidth + 2 * margin, viewHeight + 2 * margin);
+            valid = false;
+        }
+        target.bind();
+        if (zoom != cachedZoom) valid = false;
+        cachedZoom = zoom;
+
+        glm::ivec2 view = snappedOrigin(viewOrigin, zoom);
+        glm::ivec2 size(target.width, target.height);
+        bool inside = view.x >= origin.x && view.y >= origin.y &&
+                      view.x + viewWidth <= origin.x + size.x && view.y + viewHeight <= origin.y + size.y;
+
+        glEnable(GL_SCISSOR_TEST);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glState().countIssued(2);
+
+        if (!valid || !inside) {
+            glm::ivec2 next = view - glm::ivec2(margin);
+            glm::ivec2 delta = next - origin;
+            if (!valid || std::abs(delta.x) >= size.x || std::abs(delta.y) >= size.y) {
+                stats.fullRedraw = true;
+                drawRect(next, next + size, drawRegion);
+            } else {
+                // Columns that came into view, then the rows, minus the corner already covered
+                if (delta.x > 0) drawRect(glm::ivec2(origin.x + size.x, next.y), next + size, drawRegion);
+                if (delta.x < 0) drawRect(next, glm::ivec2(origin.x, next.y + size.y), drawRegion);
+                int keptMinX = std::max(next.x, origin.x), keptMaxX = std::min(next.x, origin.x) + size.x;
+                if (delta.y > 0) drawRect(glm::ivec2(keptMinX, origin.y + size.y), glm::ivec2(keptMaxX, next.y + size.y), drawRegion);
+                if (delta.y < 0) drawRect(glm::ivec2(keptMinX, next.y), glm::ivec2(keptMaxX, origin.y), drawRegion);
+            }
+            origin = next;
+            valid = true;
+        }
+
+        // Edited areas that are currently cached
+        for (const glm::vec4& bounds : dirty) {
+            glm::ivec2 low = glm::max(glm::ivec2(glm::floor(glm::vec2(bounds.x, bounds.y) * zoom)), origin);
+            glm::ivec2 high = glm::min(glm::ivec2(glm::ceil(glm::vec2(bounds.z, bounds.w) * zoom)), origin + size);
+            if (low.x < high.x && low.y < high.y) drawRect(low, high, drawRegion);
+        }
+        dirty.clear();
+
+        glDisable(GL_SCISSOR_TEST);
+        glState().countIssued();
+    }
+
+    // Draw the cached layer over the bound framebuffer, which must be the view's size
+    void draw(const glm::vec2& viewOrigin) {
+        composite.use();
+        glState().bindTexture(0, target.colorTexture);
+        Shader::setInt(cacheLocation, 0);
+        Shader::setVec2(viewOriginLocation, glm::vec2(snappedOrigin(viewOrigin, cachedZoom)));
+        Shader::setVec2(cacheSizeLocation, glm::vec2(target.width, target.height));
+        glState().countIssued(3);
+
+        glState().bindVertexArray(vao);
+        glState().setBlend(true);
+        glState().blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glState().countDrawCall();
+    }
+
+    const ScrollCacheStats& lastStats() const { return stats; }
+
+private:
+    int margin;
+    Shader composite;
+    RenderTarget target;
+    GLuint vao = 0;
+    GLint cacheLocation, viewOriginLocation, cacheSizeLocation;
+
+    bool valid = false;
+    float cachedZoom = 0.0f;
+    glm::ivec2 origin = glm::ivec2(0);  // World pixel held by the cache's logical bottom-left
+    std::vector<glm::vec4> dirty;
+    ScrollCacheStats stats;
+
+    static glm::ivec2 snappedOrigin(const glm::vec2& viewOrigin, float zoom) {
+        return glm::ivec2(glm::floor(viewOrigin * zoom + 0.5f));
+    }
+
+    static int wrap(int value, int size) {
+        int r = value % size;
+        return r < 0 ? r + size : r;
+    }
+
+    // World-pixel rectangle [min, max), split where it wraps around the texture edges
+    template <typename DrawRegion>
+    void drawRect(glm::ivec2 min, glm::ivec2 max, DrawRegion& drawRegion) {
+        for (int y = min.y; y < max.y;) {
+            int texelY = wrap(y, target.height);
+            int height = std::min(max.y - y, target.height - texelY);
+            for (int x = min.x; x < max.x;) {
+                int texelX = wrap(x, target.width);
+                int width = std::min(max.x - x, target.width - texelX);
+
+                glState().viewport(texelX, texelY, width, height);
+                glScissor(texelX, texelY, width, height);
+                glClear(GL_COLOR_BUFFER_BIT);
+                glState().countIssued(2);
+
+                glm::vec4 bounds = glm::vec4(x, y, x + width, y + height) / cachedZoom;
+                drawRegion(bounds, glm::ortho(bounds.x, bounds.z, bounds.y, bounds.w, -1.0f, 1.0f));
+                ++stats.regions;
+                stats.pixels += static_cast<uint64_t>(width) * height;
+                x += width;
+            }
+            y += height;
+        }
+    }
+};
+
+#endif  // SCROLL_CACHE_H
@@ -0,0 +1,184 @@
+#ifndef SHADER_H
+#define SHADER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include "gl_state.h"
+
+// Uniform block binding point shared by every program that declares "Camera"
+constexpr GLuint CAMERA_UBO_BINDING = 0;
+
+// Linked GL program. Active uniforms are reflected once at link time, so
+// callers look a location up once and reuse it for every draw.
+class Shader {
+public:
+    GLuint id = 0;
+
+    Shader() = default;
+    Shader(const char* vertexShaderSource, const char* fragmentShaderSource) {
+        load(vertexShaderSource, fragmentShaderSource);
+    }
+
+    ~Shader() {
+        if (id) glState().deleteProgram(id);
+    }
+
+    Shader(const Shader&) = delete;
+    Shader& operator=(const Shader&) = delete;
+
+    Shader(Shader&& other) noexcept : id(other.id), uniforms(std::move(other.uniforms)) { other.id = 0; }
+    Shader& operator=(Shader&& other) noexcept {
+        if (this != &other) {
+            if (id) glState().deleteProgram(id);
+            id = other.id;
+            uniforms = std::move(other.uniforms);
+            other.id = 0;
+        }
+        return *this;
+    }
+
+    bool load(const char* vertexShaderSource, const char* fragmentShaderSource) {
+        GLuint program = glCreateProgram();
+        GLuint vs = compile(GL_VERTEX_SHADER, vertexShaderSource);
+        GLuint fs = compile(GL_FRAGMENT_SHADER, fragmentShaderSource);
+
+        glAttachShader(program, vs);
+        glAttachShader(program, fs);
+        glLinkProgram(program);
+        glDeleteShader(vs);
+        glDeleteShader(fs);
+
+        int success;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success) {
+            char infoLog[512];
+            glGetProgramInfoLog(program, 512, nullptr, infoLog);
+            std::cout << "ERROR::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+            glDeleteProgram(program);
+            return false;
+        }
+
+        if (id) glState().deleteProgram(id);
+        id = program;
+        reflect();
+        return true;
+    }
+
+    void use() const { glState().useProgram(id); }
+
+    // Location of an active uniform, or -1 if the linker dropped it
+    GLint uniform(const char* name) const {
+        auto it = uniforms.find(name);
+        return it == uniforms.end() ? -1 : it->second;
+    }
+
+    bool hasUniform(const char* name) const { return uniforms.count(name) != 0; }
+
+    // Attach a named uniform block to a binding point; no-op if the program lacks it
+    void bindUniformBlock(const char* blockName, GLuint binding) const {
+        GLuint index = glGetUniformBlockIndex(id, blockName);
+        if (index != GL_INVALID_INDEX) glUniformBlockBinding(id, index, binding);
+    }
+
+    // Setters take a location from uniform(); the program must be current
+    static void setInt(GLint location, int value) { glUniform1i(location, value); }
+    static void setFloat(GLint location, float value) { glUniform1f(location, value); }
+    static void setVec2(GLint location, const glm::vec2& value) { glUniform2fv(location, 1, glm::value_ptr(value)); }
+    static void setVec4(GLint location, const glm::vec4& value) { glUniform4fv(location, 1, glm::value_ptr(value)); }
+    static void setMat4(GLint location, const glm::mat4& value) {
+        glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+    }
+
+private:
+    std::unordered_map<std::string, GLint> uniforms;
+
+    static GLuint compile(GLenum type, const char* source) {
+        GLuint shader = glCreateShader(type);
+        glShaderSource(shader, 1, &source, nullptr);
+        glCompileShader(shader);
+
+        int success;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+        if (!success) {
+            char infoLog[512];
+            glGetShaderInfoLog(shader, 512, nullptr, infoLog);
+            std::cout << "ERROR::SHADER::COMPILATION_FAILED\n" << infoLog << std::endl;
+        }
+        return shader;
+    }
+
+    void reflect() {
+        uniforms.clear();
+
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::string name(maxLength > 0 ? maxLength : 1, '\0');
+
+        for (GLint i = 0; i < count; ++i) {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(id, static_cast<GLuint>(i), maxLength, &length, &size, &type, &name[0]);
+
+            std::string uniformName(name.data(), length);
+            GLint location = glGetUniformLocation(id, uniformName.c_str());
+            if (location < 0) continue;  // Lives in a uniform block
+
+            // Arrays are reported as "name[0]"; make them reachable by their bare name too
+            uniforms[uniformName] = location;
+            size_t bracket = uniformName.find('[');
+            if (bracket != std::string::npos) uniforms[uniformName.substr(0, bracket)] = location;
+        }
+
+        bindUniformBlock("Camera", CAMERA_UBO_BINDING);
+    }
+};
+
+// std140 layout of the "Camera" uniform block
+struct CameraBlock {
+    glm::mat4 projection;
+    glm::mat4 view;
+};
+
+// Camera matrices in one uniform buffer, written once per frame and shared by every program
+class CameraUniformBuffer {
+public:
+    GLuint ubo = 0;
+
+    CameraUniformBuffer() {
+        glGenBuffers(1, &ubo);
+        glState().bindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraBlock), nullptr, GL_DYNAMIC_DRAW);
+        glState().bindBufferBase(GL_UNIFORM_BUFFER, CAMERA_UBO_BINDING, ubo);
+    }
+
+    ~CameraUniformBuffer() {
+        if (ubo) glState().deleteBuffer(ubo);
+    }
+
+    CameraUniformBuffer(const CameraUniformBuffer&) = delete;
+    CameraUniformBuffer& operator=(const CameraUniformBuffer&) = delete;
+
+    // Upload only when the matrices changed since the last frame
+    void update(const glm::mat4& projection, const glm::mat4& view) {
+        CameraBlock block{ projection, view };
+        if (uploaded && std::memcmp(&block, &last, sizeof(CameraBlock)) == 0) return;
+
+        glState().bindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(CameraBlock), &block);
+        last = block;
+        uploaded = true;
+    }
+
+private:
+    CameraBlock last;
+    bool uploaded = false;
+};
+
+#endif  // SHADER_H
@@ -0,0 +1,548 @@
+#ifndef SOFTWARE_RASTERIZER_H
+#define SOFTWARE_RASTERIZER_H
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "image.h"
+#include "render_backend.h"
+#include "render_queue.h"
+#include "sprite_mesh.h"
+#include "thread_pool.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SOFTRAST_SSE2 1
+#endif
+
+enum class SampleFilter { Nearest, Bilinear };
+
+// Pixel counters for one frame; overdraw = pixelsShaded / covered screen area
+struct RasterStats {
+    uint64_t triangles = 0;
+    uint64_t pixelsTested = 0;   // Inside a triangle's bounding box
+    uint64_t pixelsShaded = 0;   // Inside the triangle: sampled and blended
+    uint64_t pixelsWritten = 0;  // Shaded with non-zero alpha
+
+    void add(const RasterStats& other) {
+        triangles += other.triangles;
+        pixelsTested += other.pixelsTested;
+        pixelsShaded += other.pixelsShaded;
+        pixelsWritten += other.pixelsWritten;
+    }
+};
+
+namespace SoftRaster {
+
+    // Screen-space triangle after setup. Edge k is >= 0 inside; 'inclusive'
+    // applies the tie-break so a pixel on a shared edge is drawn exactly once.
+    struct Triangle {
+        float a[3], b[3], c[3];
+        bool inclusive[3];
+        float uA, uB, uC;  // u = uA * x + uB * y + uC (affine, this is 2D)
+        float vA, vB, vC;
+        int minX, minY, maxX, maxY;
+        uint32_t color;
+        uint32_t texture;
+    };
+
+    inline const uint32_t* texels(const Image& image) {
+        return reinterpret_cast<const uint32_t*>(image.pixels.data());
+    }
+
+#ifdef SOFTRAST_SSE2
+    // Four pixels, one channel per register
+    struct Color4 {
+        __m128 r, g, b, a;
+    };
+
+    inline __m128 floor4(__m128 x) {
+        __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+        return _mm_sub_ps(t, _mm_and_ps(_mm_cmplt_ps(x, t), _mm_set1_ps(1.0f)));
+    }
+
+    // GL_REPEAT: texel coordinate into [0, size - 1], as integers
+    inline __m128i wrap4(__m128 x, float size) {
+        x = _mm_sub_ps(x, _mm_mul_ps(floor4(_mm_mul_ps(x, _mm_set1_ps(1.0f / size))), _mm_set1_ps(size)));
+        x = _mm_min_ps(_mm_max_ps(x, _mm_setzero_ps()), _mm_set1_ps(size - 0.5f));
+        return _mm_cvttps_epi32(x);
+    }
+
+    inline Color4 unpack4(__m128i rgba) {
+        __m128i byte = _mm_set1_epi32(0xFF);
+        return { _mm_cvtepi32_ps(_mm_and_si128(rgba, byte)),
+                 _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(rgba, 8), byte)),
+                 _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(rgba, 16), byte)),
+                 _mm_cvtepi32_ps(_mm_srli_epi32(rgba, 24)) };
+    }
+
+    inline __m128i pack4(const Color4& c) {
+        __m128 zero = _mm_setzero_ps(), full = _mm_set1_ps(255.0f);
+        __m128i r = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(c.r, zero), full));
+        __m128i g = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(c.g, zero), full));
+        __m128i b = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(c.b, zero), full));
+        __m128i a = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(c.a, zero), full));
+        return _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(b, 16), _mm_slli_epi32(a, 24)));
+    }
+
+    inline Color4 lerp4(const Color4& from, const Color4& to, __m128 t) {
+        return { _mm_add_ps(from.r, _mm_mul_ps(_mm_sub_ps(to.r, from.r), t)),
+                 _mm_add_ps(from.g, _mm_mul_ps(_mm_sub_ps(to.g, from.g), t)),
+                 _mm_add_ps(from.b, _mm_mul_ps(_mm_sub_ps(to.b, from.b), t)),
+                 _mm_add_ps(from.a, _mm_mul_ps(_mm_sub_ps(to.a, from.a), t)) };
+    }
+
+    // SSE2 has no gather; four scalar loads
+    inline __m128i gather4(const Image& image, __m128i x, __m128i y) {
+        alignas(16) int32_t xs[4], ys[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(xs), x);
+        _mm_store_si128(reinterpret_cast<__m128i*>(ys), y);
+        const uint32_t* data = texels(image);
+        size_t w = static_cast<size_t>(image.width);
+        return _mm_set_epi32(static_cast<int>(data[ys[3] * w + xs[3]]), static_cast<int>(data[ys[2] * w + xs[2]]),
+                             static_cast<int>(data[ys[1] * w + xs[1]]), static_cast<int>(data[ys[0] * w + xs[0]]));
+    }
+
+    // Texel centres at half-integers like GL
+    inline Color4 sample4(const Image& image, __m128 u, __m128 v, SampleFilter filter) {
+        float w = static_cast<float>(image.width), h = static_cast<float>(image.height);
+        __m128 x = _mm_mul_ps(u, _mm_set1_ps(w));
+        __m128 y = _mm_mul_ps(v, _mm_set1_ps(h));
+        if (filter == SampleFilter::Nearest) return unpack4(gather4(image, wrap4(x, w), wrap4(y, h)));
+
+        x = _mm_sub_ps(x, _mm_set1_ps(0.5f));
+        y = _mm_sub_ps(y, _mm_set1_ps(0.5f));
+        __m128 fx = _mm_sub_ps(x, floor4(x)), fy = _mm_sub_ps(y, floor4(y));
+        __m128i x0 = wrap4(x, w), y0 = wrap4(y, h);
+        __m128i x1 = _mm_add_epi32(x0, _mm_set1_epi32(1)), y1 = _mm_add_epi32(y0, _mm_set1_epi32(1));
+        x1 = _mm_and_si128(x1, _mm_cmplt_epi32(x1, _mm_set1_epi32(image.width)));
+        y1 = _mm_and_si128(y1, _mm_cmplt_epi32(y1, _mm_set1_epi32(image.height)));
+
+        Color4 bottom = lerp4(unpack4(gather4(image, x0, y0)), unpack4(gather4(image, x1, y0)), fx);
+        Color4 top = lerp4(unpack4(gather4(image, x0, y1)), unpack4(gather4(image, x1, y1)), fx);
+        return lerp4(bottom, top, fy);
+    }
+
+    inline __m128 plane4(float a, float b, float c, __m128 x, __m128 y) {
+        return _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(a), x), _mm_mul_ps(_mm_set1_ps(b), y)), _mm_set1_ps(c));
+    }
+#else
+    inline uint32_t texelAt(const Image& image, int x, int y) {
+        x %= image.width;
+        y %= image.height;
+        if (x < 0) x += image.width;
+        if (y < 0) y += image.height;
+        return texels(image)[static_cast<size_t>(y) * image.width + x];
+    }
+
+    inline void unpack(uint32_t rgba, float out[4]) {
+        for (int i = 0; i < 4; ++i) out[i] = static_cast<float>((rgba >> (i * 8)) & 0xFF);
+    }
+
+    inline uint32_t pack(const float color[4]) {
+        uint32_t out = 0;
+        for (int i = 0; i < 4; ++i) {
+            float c = std::min(std::max(color[i] + 0.5f, 0.0f), 255.0f);
+            out |= static_cast<uint32_t>(c) << (i * 8);
+        }
+        return out;
+    }
+
+    // Texel centres at half-integers like GL
+    inline void sample(const Image& image, float u, float v, SampleFilter filter, float out[4]) {
+        float x = u * image.width;
+        float y = v * image.height;
+        if (filter == SampleFilter::Nearest) {
+            unpack(texelAt(image, static_cast<int>(std::floor(x)), static_cast<int>(std::floor(y))), out);
+            return;
+        }
+
+        x -= 0.5f;
+        y -= 0.5f;
+        float fx = std::floor(x), fy = std::floor(y);
+        int x0 = static_cast<int>(fx), y0 = static_cast<int>(fy);
+        float c00[4], c10[4], c01[4], c11[4];
+        unpack(texelAt(image, x0, y0), c00);
+        unpack(texelAt(image, x0 + 1, y0), c10);
+        unpack(texelAt(image, x0, y0 + 1), c01);
+        unpack(texelAt(image, x0 + 1, y0 + 1), c11);
+        fx = x - fx;
+        fy = y - fy;
+        for (int i = 0; i < 4; ++i) {
+            float bottom = c00[i] + (c10[i] - c00[i]) * fx;
+            float top = c01[i] + (c11[i] - c01[i]) * fx;
+            out[i] = bottom + (top - bottom) * fy;
+        }
+    }
+
+    inline bool covers(const Triangle& tri, float x, float y) {
+        for (int k = 0; k < 3; ++k) {
+            float w = tri.a[k] * x + tri.b[k] * y + tri.c[k];
+            if (tri.inclusive[k] ? w < 0.0f : w <= 0.0f) return false;
+        }
+        return true;
+    }
+#endif
+}
+
+// CPU backend: tile-binned, multithreaded rasterizer for textured, alpha-blended
+// 2D triangles (sprites are two each, or the fan of their SpriteMesh). Blending matches the GL path's
+// GL_SRC_ALPHA / GL_ONE_MINUS_SRC_ALPHA so frames compare against it directly.
+// Runs without a GL context, e.g. for server-side thumbnails and tests.
+class SoftwareRasterizer : public RenderBackend {
+public:
+    static constexpr int TILE_SIZE = 64;
+
+    SampleFilter filter = SampleFilter::Bilinear;
+
+    explicit SoftwareRasterizer(ThreadPool* threadPool = nullptr) : pool(threadPool) {}
+
+    // Handles are 1-based; 0 samples as opaque white
+    uint32_t createTexture(const Image& image) override {
+        textures.push_back(image);
+        return static_cast<uint32_t>(textures.size());
+    }
+
+    void destroyTexture(uint32_t texture) override {
+        if (texture > 0 && texture <= textures.size()) textures[texture - 1] = Image();
+    }
+
+    void setSpriteMeshes(const SpriteMeshTable* table) override { meshes = table; }
+
+    void beginFrame(int width, int height, const glm::vec4& clearColor) override {
+        if (color.width != width || color.height != height) color = Image(width, height);
+        tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+        tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+        frameStats = RasterStats();
+
+        uint32_t clear = packColor(clearColor);
+        parallelFor(static_cast<size_t>(height), 16, [&](size_t begin, size_t end, unsigned) {
+            for (size_t y = begin; y < end; ++y) {
+                uint32_t* row = reinterpret_cast<uint32_t*>(color.pixel(0, static_cast<int>(y)));
+                std::fill(row, row + width, clear);
+            }
+        });
+    }
+
+    void setCamera(const glm::mat4& projection, const glm::mat4& view) override {
+        viewProjection = projection * view;
+    }
+
+    void draw(const RenderQueue& sortedQueue) override {
+        if (meshes && usesSpriteMeshes(sortedQueue)) {
+            drawMeshes(sortedQueue);
+            return;
+        }
+        triangles.resize(sortedQueue.size() * 2);
+        parallelFor(sortedQueue.size(), 1024, [&](size_t begin, size_t end, unsigned) {
+            for (size_t i = begin; i < end; ++i) {
+                const RenderCommand& cmd = sortedQueue.sorted(i);
+                glm::vec2 p0 = cmd.position, p2 = cmd.position + cmd.size;
+                glm::vec2 p1(p2.x, p0.y), p3(p0.x, p2.y);
+                glm::vec2 t0(cmd.uv.x, cmd.uv.y), t1(cmd.uv.z, cmd.uv.y), t2(cmd.uv.z, cmd.uv.w), t3(cmd.uv.x, cmd.uv.w);
+                setupTriangle(p0, p1, p2, t0, t1, t2, cmd.color, cmd.texture, triangles[i * 2]);
+                setupTriangle(p2, p3, p0, t2, t3, t0, cmd.color, cmd.texture, triangles[i * 2 + 1]);
+            }
+        });
+        rasterize();
+    }
+
+    // Raw triangles in world space, in draw order; for meshes that are not quads
+    void drawTriangles(const glm::vec2* positions, const glm::vec2* uvs, size_t vertexCount,
+                       uint32_t tint, uint32_t texture) {
+        size_t count = vertexCount / 3;
+        triangles.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            const glm::vec2* p = positions + i * 3;
+            const glm::vec2* t = uvs + i * 3;
+            setupTriangle(p[0], p[1], p[2], t[0], t[1], t[2], tint, texture, triangles[i]);
+        }
+        rasterize();
+    }
+
+    void endFrame() override {}
+
+    const Image& framebuffer() const { return color; }
+    const RasterStats& stats() const { return frameStats; }
+
+private:
+    ThreadPool* pool;
+    const SpriteMeshTable* meshes = nullptr;
+    std::vector<Image> textures;
+    Image color;
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    int tilesX = 0, tilesY = 0;
+
+    std::vector<SoftRaster::Triangle> triangles;
+    std::vector<uint32_t> firstTriangle;  // Per command, when drawing meshes
+    // bins[binner][tile] lists triangle indices in draw order
+    std::vector<std::vector<std::vector<uint32_t>>> bins;
+    std::vector<RasterStats> threadStats;
+    RasterStats frameStats;
+
+    template <typename Fn>
+    void parallelFor(size_t count, size_t grain, Fn&& fn) {
+        if (pool) pool->parallelFor(count, grain, fn);
+        else fn(size_t(0), count, 0u);
+    }
+
+    unsigned threadCount() const { return pool ? pool->threadCount() : 1; }
+
+    // Each command becomes the fan of its mesh, count - 2 triangles. Texture
+    // coordinates come from the quad half holding each triangle rather than from
+    // the triangle: a sliver's own uv plane loses precision far from the origin,
+    // and a plain quad keeps exactly the planes of the quad path.
+    void drawMeshes(const RenderQueue& sortedQueue) {
+        firstTriangle.resize(sortedQueue.size() + 1);
+        firstTriangle[0] = 0;
+        for (size_t i = 0; i < sortedQueue.size(); ++i) {
+            const SpriteMesh& mesh = (*meshes)[sortedQueue.sorted(i).mesh];
+            firstTriangle[i + 1] = firstTriangle[i] + std::max(mesh.count, uint8_t(2)) - 2;
+        }
+        triangles.resize(firstTriangle.back());
+        parallelFor(sortedQueue.size(), 1024, [&](size_t begin, size_t end, unsigned) {
+            SpriteVertex fan[SpriteMesh::MAX_VERTICES];
+            for (size_t i = begin; i < end; ++i) {
+                const RenderCommand& cmd = sortedQueue.sorted(i);
+                const SpriteMesh& mesh = (*meshes)[cmd.mesh];
+                if (mesh.count < 3) continue;
+
+                glm::vec2 q0 = cmd.position, q2 = cmd.position + cmd.size;
+                glm::vec2 q1(q2.x, q0.y), q3(q0.x, q2.y);
+                glm::vec2 t0(cmd.uv.x, cmd.uv.y), t1(cmd.uv.z, cmd.uv.y), t2(cmd.uv.z, cmd.uv.w), t3(cmd.uv.x, cmd.uv.w);
+                SoftRaster::Triangle halves[2];
+                setupTriangle(q0, q1, q2, t0, t1, t2, cmd.color, cmd.texture, halves[0]);
+                setupTriangle(q2, q3, q0, t2, t3, t0, cmd.color, cmd.texture, halves[1]);
+
+                writeMeshVertices(cmd, mesh, fan);
+                SoftRaster::Triangle* out = &triangles[firstTriangle[i]];
+                for (int k = 1; k + 1 < mesh.count; ++k, ++out) {
+                    glm::vec2 p[3] = { { fan[0].x, fan[0].y }, { fan[k].x, fan[k].y }, { fan[k + 1].x, fan[k + 1].y } };
+                    // Same vertex order as the quad path when the mesh is a rect
+                    if (k == 2 && mesh.count == 4) setupTriangle(p[1], p[2], p[0], t0, t0, t0, cmd.color, cmd.texture, *out);
+                    else setupTriangle(p[0], p[1], p[2], t0, t0, t0, cmd.color, cmd.texture, *out);
+
+                    glm::vec2 centroid = (p[0] + p[1] + p[2]) / 3.0f, diagonal = q2 - q0, offset = centroid - q0;
+                    const SoftRaster::Triangle& half = halves[diagonal.x * offset.y - diagonal.y * offset.x > 0.0f ? 1 : 0];
+                    out->uA = half.uA; out->uB = half.uB; out->uC = half.uC;
+                    out->vA = half.vA; out->vB = half.vB; out->vC = half.vC;
+                }
+            }
+        });
+        rasterize();
+    }
+
+    void setupTriangle(glm::vec2 p0, glm::vec2 p1, glm::vec2 p2, glm::vec2 t0, glm::vec2 t1, glm::vec2 t2,
+                       uint32_t tint, uint32_t texture, SoftRaster::Triangle& tri) const {
+        // World -> pixels, y up like glReadPixels
+        glm::vec2 s[3];
+        const glm::vec2* p[3] = { &p0, &p1, &p2 };
+        for (int i = 0; i < 3; ++i) {
+            glm::vec4 clip = viewProjection * glm::vec4(*p[i], 0.0f, 1.0f);
+            s[i] = glm::vec2((clip.x * 0.5f + 0.5f) * color.width, (clip.y * 0.5f + 0.5f) * color.height);
+        }
+
+        float area2 = (s[1].x - s[0].x) * (s[2].y - s[0].y) - (s[2].x - s[0].x) * (s[1].y - s[0].y);
+        tri.color = tint;
+        tri.texture = texture;
+        if (std::fabs(area2) < 1e-8f) {
+            tri.minX = 1;
+            tri.maxX = 0;  // Degenerate: empty bounding box
+            return;
+        }
+
+        float sign = area2 > 0.0f ? 1.0f : -1.0f;
+        float u[3] = { t0.x, t1.x, t2.x }, v[3] = { t0.y, t1.y, t2.y };
+        tri.uA = tri.uB = tri.uC = tri.vA = tri.vB = tri.vC = 0.0f;
+        for (int k = 0; k < 3; ++k) {
+            const glm::vec2& pi = s[(k + 1) % 3];
+            const glm::vec2& pj = s[(k + 2) % 3];
+            tri.a[k] = (pi.y - pj.y) * sign;
+            tri.b[k] = (pj.x - pi.x) * sign;
+            tri.c[k] = (pi.x * pj.y - pj.x * pi.y) * sign;
+            tri.inclusive[k] = tri.a[k] > 0.0f || (tri.a[k] == 0.0f && tri.b[k] > 0.0f);
+
+            // Barycentric weight of vertex k is edge k over the doubled area
+            float inv = 1.0f / std::fabs(area2);
+            tri.uA += tri.a[k] * inv * u[k];
+            tri.uB += tri.b[k] * inv * u[k];
+            tri.uC += tri.c[k] * inv * u[k];
+            tri.vA += tri.a[k] * inv * v[k];
+            tri.vB += tri.b[k] * inv * v[k];
+            tri.vC += tri.c[k] * inv * v[k];
+        }
+
+        float minX = std::min({ s[0].x, s[1].x, s[2].x }), maxX = std::max({ s[0].x, s[1].x, s[2].x });
+        float minY = std::min({ s[0].y, s[1].y, s[2].y }), maxY = std::max({ s[0].y, s[1].y, s[2].y });
+        tri.minX = std::max(0, static_cast<int>(std::ceil(minX - 0.5f)));
+        tri.maxX = std::min(color.width - 1, static_cast<int>(std::floor(maxX - 0.5f)));
+        tri.minY = std::max(0, static_cast<int>(std::ceil(minY - 0.5f)));
+        tri.maxY = std::min(color.height - 1, static_cast<int>(std::floor(maxY - 0.5f)));
+    }
+
+    void rasterize() {
+        if (triangles.empty() || color.empty()) return;
+
+        // Bin contiguous triangle ranges per thread; tiles replay binners in order, keeping draw order
+        unsigned binners = threadCount();
+        size_t tileCount = static_cast<size_t>(tilesX) * tilesY;
+        bins.resize(binners);
+        for (auto& binner : bins) {
+            binner.resize(tileCount);
+            for (auto& tile : binner) tile.clear();
+        }
+
+        size_t perBinner = (triangles.size() + binners - 1) / binners;
+        parallelFor(binners, 1, [&](size_t begin, size_t end, unsigned) {
+            for (size_t b = begin; b < end; ++b) {
+                size_t first = b * perBinner;
+                size_t last = std::min(triangles.size(), first + perBinner);
+                for (size_t i = first; i < last; ++i) {
+                    const SoftRaster::Triangle& tri = triangles[i];
+                    if (tri.minX > tri.maxX || tri.minY > tri.maxY) continue;
+                    for (int ty = tri.minY / TILE_SIZE; ty <= tri.maxY / TILE_SIZE; ++ty) {
+                        for (int tx = tri.minX / TILE_SIZE; tx <= tri.maxX / TILE_SIZE; ++tx) {
+                            bins[b][static_cast<size_t>(ty) * tilesX + tx].push_back(static_cast<uint32_t>(i));
+                        }
+                    }
+                }
+            }
+        });
+
+        threadStats.assign(threadCount(), RasterStats());
+        parallelFor(tileCount, 1, [&](size_t begin, size_t end, unsigned threadIndex) {
+            for (size_t tile = begin; tile < end; ++tile) rasterizeTile(tile, threadStats[threadIndex]);
+        });
+
+        for (const RasterStats& stats : threadStats) frameStats.add(stats);
+        frameStats.triangles += triangles.size();
+    }
+
+    void rasterizeTile(size_t tile, RasterStats& stats) {
+        int tileX0 = static_cast<int>(tile % tilesX) * TILE_SIZE;
+        int tileY0 = static_cast<int>(tile / tilesX) * TILE_SIZE;
+        int tileX1 = std::min(tileX0 + TILE_SIZE, color.width) - 1;
+        int tileY1 = std::min(tileY0 + TILE_SIZE, color.height) - 1;
+
+        for (const auto& binner : bins) {
+            for (uint32_t index : binner[tile]) {
+                const SoftRaster::Triangle& tri = triangles[index];
+                int x0 = std::max(tri.minX, tileX0), x1 = std::min(tri.maxX, tileX1);
+                int y0 = std::max(tri.minY, tileY0), y1 = std::min(tri.maxY, tileY1);
+                rasterizeSpan(tri, x0, x1, y0, y1, stats);
+            }
+        }
+    }
+
+    void rasterizeSpan(const SoftRaster::Triangle& tri, int x0, int x1, int y0, int y1, RasterStats& stats) {
+        using namespace SoftRaster;
+        const Image* texture = tri.texture > 0 && tri.texture <= textures.size() && !textures[tri.texture - 1].empty()
+            ? &textures[tri.texture - 1] : nullptr;
+        stats.pixelsTested += static_cast<uint64_t>(x1 - x0 + 1) * (y1 - y0 + 1);
+
+#ifdef SOFTRAST_SSE2
+        // Groups of four start on multiples of 4, so a group never straddles two tiles
+        Color4 tint = unpack4(_mm_set1_epi32(static_cast<int>(tri.color)));
+        __m128 inv255 = _mm_set1_ps(1.0f / 255.0f);
+        tint = { _mm_mul_ps(tint.r, inv255), _mm_mul_ps(tint.g, inv255), _mm_mul_ps(tint.b, inv255), _mm_mul_ps(tint.a, inv255) };
+        __m128 laneOffset = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+        __m128i laneIndex = _mm_set_epi32(3, 2, 1, 0);
+        Color4 white = { _mm_set1_ps(255.0f), _mm_set1_ps(255.0f), _mm_set1_ps(255.0f), _mm_set1_ps(255.0f) };
+
+        // Edge and UV planes are stepped per group instead of evaluated per pixel
+        __m128 zero = _mm_setzero_ps();
+        __m128 edgeStep[3], inclusive[3];
+        for (int k = 0; k < 3; ++k) {
+            edgeStep[k] = _mm_set1_ps(tri.a[k] * 4.0f);
+            inclusive[k] = _mm_castsi128_ps(_mm_set1_epi32(tri.inclusive[k] ? -1 : 0));
+        }
+        __m128 uStep = _mm_set1_ps(tri.uA * 4.0f), vStep = _mm_set1_ps(tri.vA * 4.0f);
+        int groupStart = x0 & ~3;
+        __m128i first = _mm_set1_epi32(x0), pastLast = _mm_set1_epi32(x1 + 1);
+
+        for (int y = y0; y <= y1; ++y) {
+            uint32_t* row = reinterpret_cast<uint32_t*>(color.pixel(0, y));
+            __m128 py = _mm_set1_ps(y + 0.5f);
+            __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(groupStart)), laneOffset);
+            __m128 edge[3];
+            for (int k = 0; k < 3; ++k) edge[k] = plane4(tri.a[k], tri.b[k], tri.c[k], px, py);
+            __m128 u = plane4(tri.uA, tri.uB, tri.uC, px, py);
+            __m128 v = plane4(tri.vA, tri.vB, tri.vC, px, py);
+
+            for (int x = groupStart; x <= x1; x += 4) {
+                __m128 mask = _mm_castsi128_ps(_mm_set1_epi32(-1));
+                for (int k = 0; k < 3; ++k) {
+                    __m128 inside = _mm_or_ps(_mm_cmpgt_ps(edge[k], zero), _mm_and_ps(inclusive[k], _mm_cmpeq_ps(edge[k], zero)));
+                    mask = _mm_and_ps(mask, inside);
+                    edge[k] = _mm_add_ps(edge[k], edgeStep[k]);
+                }
+                __m128 groupU = u, groupV = v;
+                u = _mm_add_ps(u, uStep);
+                v = _mm_add_ps(v, vStep);
+
+                __m128i lane = _mm_add_epi32(_mm_set1_epi32(x), laneIndex);
+                __m128i inSpan = _mm_andnot_si128(_mm_cmplt_epi32(lane, first), _mm_cmplt_epi32(lane, pastLast));
+                mask = _mm_and_ps(mask, _mm_castsi128_ps(inSpan));
+                int bits = _mm_movemask_ps(mask);
+                if (!bits) continue;
+
+                Color4 src = texture ? sample4(*texture, groupU, groupV, filter) : white;
+                src = { _mm_mul_ps(src.r, tint.r), _mm_mul_ps(src.g, tint.g), _mm_mul_ps(src.b, tint.b), _mm_mul_ps(src.a, tint.a) };
+                __m128 alpha = _mm_mul_ps(src.a, inv255);
+                stats.pixelsShaded += popcount4(bits);
+                stats.pixelsWritten += popcount4(bits & _mm_movemask_ps(_mm_cmpgt_ps(alpha, _mm_setzero_ps())));
+
+                // The last group of a row may run past the framebuffer edge
+                bool full = x + 4 <= color.width;
+                alignas(16) uint32_t edge[4] = {};
+                uint32_t* dst = full ? row + x : edge;
+                if (!full) std::memcpy(edge, row + x, (color.width - x) * sizeof(uint32_t));
+
+                __m128i old = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst));
+                __m128i blended = pack4(lerp4(unpack4(old), src, alpha));
+                __m128i maskBits = _mm_castps_si128(mask);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst),
+                                 _mm_or_si128(_mm_and_si128(maskBits, blended), _mm_andnot_si128(maskBits, old)));
+                if (!full) std::memcpy(row + x, edge, (color.width - x) * sizeof(uint32_t));
+            }
+        }
+#else
+        float tint[4];
+        unpack(tri.color, tint);
+        for (float& channel : tint) channel *= 1.0f / 255.0f;
+
+        for (int y = y0; y <= y1; ++y) {
+            uint32_t* row = reinterpret_cast<uint32_t*>(color.pixel(0, y));
+            float py = y + 0.5f;
+            for (int x = x0; x <= x1; ++x) {
+                float px = x + 0.5f;
+                if (!covers(tri, px, py)) continue;
+                ++stats.pixelsShaded;
+
+                float src[4] = { 255.0f, 255.0f, 255.0f, 255.0f };
+                if (texture) {
+                    sample(*texture, tri.uA * px + tri.uB * py + tri.uC, tri.vA * px + tri.vB * py + tri.vC, filter, src);
+                }
+                for (int i = 0; i < 4; ++i) src[i] *= tint[i];
+                float alpha = src[3] * (1.0f / 255.0f);
+                if (alpha <= 0.0f) continue;
+                ++stats.pixelsWritten;
+
+                float dst[4];
+                unpack(row[x], dst);
+                for (int i = 0; i < 4; ++i) dst[i] += (src[i] - dst[i]) * alpha;
+                row[x] = pack(dst);
+            }
+        }
+#endif
+    }
+
+    static int popcount4(int bits) {
+        return (bits & 1) + ((bits >> 1) & 1) + ((bits >> 2) & 1) + ((bits >> 3) & 1);
+    }
+};
+
+#endif  // SOFTWARE_RASTERIZER_H
@@ -0,0 +1,194 @@
+#ifndef SPRITE_ANIMATION_H
+#define SPRITE_ANIMATION_H
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class AnimationLoop : uint8_t {
+    Loop,
+    Once,      // Holds the last frame
+    PingPong,  // Forwards, then back, without repeating the end frames
+};
+
+using ClipId = uint16_t;
+
+// Grid of equal cells inside 'region' of a texture (the whole texture, or an atlas
+// region's uv). Cells count left to right from the top row, as they are drawn.
+struct SpriteSheet {
+    int columns = 1;
+    int rows = 1;
+    glm::vec4 region = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);  // u0, v0, u1, v1
+
+    // Textures are stored bottom-up, so the top row has the largest v
+    glm::vec4 cell(int index) const {
+        int column = index % columns, row = index / columns;
+        float width = (region.z - region.x) / columns, height = (region.w - region.y) / rows;
+        float u0 = region.x + column * width, v1 = region.w - row * height;
+        return glm::vec4(u0, v1 - height, u0 + width, v1);
+    }
+};
+
+// A flipbook: consecutive frames in ClipLibrary's frame table
+struct AnimationClip {
+    uint32_t firstFrame;
+    uint16_t frameCount;
+    AnimationLoop loop;
+    float framesPerSecond;
+};
+
+// Clips defined once and shared by every entity that plays them
+class ClipLibrary {
+public:
+    // Frames longer than this would overflow the 16.16 playback position
+    static constexpr uint16_t MAX_FRAMES = 16384;
+
+    ClipId add(const std::string& name, const std::vector<glm::vec4>& frameUVs, float framesPerSecond,
+               AnimationLoop loop = AnimationLoop::Loop) {
+        auto existing = names.find(name);
+        if (existing != names.end()) return existing->second;
+
+        size_t count = std::min<size_t>(std::max<size_t>(frameUVs.size(), 1), MAX_FRAMES);
+        if (frameUVs.size() != count) std::cerr << "Clip " << name << " needs 1 to " << MAX_FRAMES << " frames" << std::endl;
+        AnimationClip clip = { static_cast<uint32_t>(frames.size()), static_cast<uint16_t>(count), loop, framesPerSecond };
+        for (size_t i = 0; i < count; ++i) frames.push_back(i < frameUVs.size() ? frameUVs[i] : glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
+        ClipId id = static_cast<ClipId>(clips.size());
+        clips.push_back(clip);
+        names.emplace(name, id);
+        return id;
+    }
+
+    // 'cellCount' cells of a sheet starting at 'firstCell'
+    ClipId addFromSheet(const std::string& name, const SpriteSheet& sheet, int firstCell, int cellCount,
+                        float framesPerSecond, AnimationLoop loop = AnimationLoop::Loop) {
+        std::vector<glm::vec4> frameUVs;
+        for (int i = 0; i < cellCount; ++i) frameUVs.push_back(sheet.cell(firstCell + i));
+        return add(name, frameUVs, framesPerSecond, loop);
+    }
+
+    // -1 when there is no clip by that name
+    int find(const std::string& name) const {
+        auto it = names.find(name);
+        return it != names.end() ? it->second : -1;
+    }
+
+    const AnimationClip& clip(ClipId id) const { return clips[id]; }
+    const glm::vec4& frame(ClipId id, uint32_t index) const { return frames[clips[id].firstFrame + index]; }
+    size_t size() const { return clips.size(); }
+
+private:
+    std::vector<AnimationClip> clips;
+    std::vector<glm::vec4> frames;
+    std::unordered_map<std::string, ClipId> names;
+};
+
+// Playback state for many entities, structure-of-arrays: a clip id and a 16.16
+// fixed-point position in frames, six bytes each. update() turns the delta time
+// into one fixed-point step per clip and then advances every entity in one pass
+// over the two arrays; positions wrap (or clamp, for Once clips) as they go, so
+// the frame is just the integer part.
+class SpriteAnimator {
+public:
+    explicit SpriteAnimator(const ClipLibrary& clipLibrary) : library(clipLibrary) {}
+
+    // Returns the entity's index; 'startFrame' offsets entities sharing a clip
+    uint32_t add(ClipId clip, float startFrame = 0.0f) {
+        clips.push_back(clip);
+        positions.push_back(0);
+        start(static_cast<uint32_t>(clips.size()) - 1, startFrame);
+        return static_cast<uint32_t>(clips.size()) - 1;
+    }
+
+    // The last entity moves into the freed index
+    void remove(uint32_t index) {
+        clips[index] = clips.back();
+        positions[index] = positions.back();
+        clips.pop_back();
+        positions.pop_back();
+    }
+
+    // Switch clip; playing the current one again leaves it running unless 'restart'
+    void play(uint32_t index, ClipId clip, bool restart = false) {
+        if (clips[index] == clip && !restart) return;
+        clips[index] = clip;
+        start(index, 0.0f);
+    }
+
+    void update(float deltaTime) {
+        // Per clip: the step this frame and where positions wrap or stop. Steps are
+        // reduced below the period, so one subtraction always brings a position back.
+        size_t clipCount = library.size();
+        advances.resize(clipCount);
+        for (size_t i = 0; i < clipCount; ++i) {
+            const AnimationClip& clip = library.clip(static_cast<ClipId>(i));
+            uint32_t end = period(clip);
+            bool once = clip.loop == AnimationLoop::Once;
+            double step = std::max(0.0, static_cast<double>(deltaTime) * clip.framesPerSecond * 65536.0 + 0.5);
+            advances[i].step = static_cast<uint32_t>(once ? std::min(step, static_cast<double>(end)) : std::fmod(step, end));
+            advances[i].period = end;
+            advances[i].clamp = once ? ~0u : 0u;
+        }
+
+        // Branchless, so clips wrapping at random frames cost no mispredictions
+        const ClipId* clip = clips.data();
+        uint32_t* position = positions.data();
+        const Advance* advance = advances.data();
+        for (size_t i = 0, count = clips.size(); i < count; ++i) {
+            const Advance& a = advance[clip[i]];
+            uint32_t next = position[i] + a.step;
+            uint32_t over = next >= a.period ? ~0u : 0u;
+            uint32_t wrapped = ((next - a.period) & ~a.clamp) | ((a.period - 1) & a.clamp);
+            position[i] = (next & ~over) | (wrapped & over);
+        }
+    }
+
+    // Index into the clip's frames
+    uint32_t frame(uint32_t index) const {
+        const AnimationClip& clip = library.clip(clips[index]);
+        uint32_t frame = positions[index] >> 16;
+        if (clip.loop == AnimationLoop::PingPong && frame >= clip.frameCount) frame = 2u * (clip.frameCount - 1) - frame;
+        return frame;
+    }
+
+    const glm::vec4& uv(uint32_t index) const { return library.frame(clips[index], frame(index)); }
+
+    // A Once clip showing its last frame
+    bool finished(uint32_t index) const {
+        const AnimationClip& clip = library.clip(clips[index]);
+        return clip.loop == AnimationLoop::Once && positions[index] >> 16 == clip.frameCount - 1u;
+    }
+
+    ClipId clip(uint32_t index) const { return clips[index]; }
+    size_t size() const { return clips.size(); }
+
+private:
+    struct Advance {
+        uint32_t step;    // 16.16 frames this update
+        uint32_t period;  // 16.16; a ping-pong cycle is 2 * (frames - 1) frames long
+        uint32_t clamp;   // All ones for Once clips, which stop on their last frame
+    };
+
+    const ClipLibrary& library;
+    std::vector<ClipId> clips;
+    std::vector<uint32_t> positions;
+    std::vector<Advance> advances;
+
+    static uint32_t period(const AnimationClip& clip) {
+        uint32_t frames = clip.loop == AnimationLoop::PingPong && clip.frameCount > 1 ? 2u * (clip.frameCount - 1) : clip.frameCount;
+        return frames << 16;
+    }
+
+    void start(uint32_t index, float startFrame) {
+        const AnimationClip& clip = library.clip(clips[index]);
+        uint32_t end = period(clip);
+        uint32_t position = static_cast<uint32_t>(std::max(0.0f, startFrame) * 65536.0f);
+        positions[index] = position < end ? position : clip.loop == AnimationLoop::Once ? end - 1 : position % end;
+    }
+};
+
+#endif  // SPRITE_ANIMATION_H
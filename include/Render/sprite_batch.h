@@ -0,0 +1,175 @@
+#ifndef SPRITE_BATCH_H
+#define SPRITE_BATCH_H
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <vector>
+#include "gl_state.h"
+#include "render_builder.h"
+#include "render_queue.h"
+#include "shader.h"
+#include "sprite_mesh.h"
+#include "stream_buffer.h"
+
+// Vertex/fragment pair every sprite program is built on
+constexpr const char* SPRITE_VERTEX_SHADER = R"(
+    #version 330 core
+    layout (location = 0) in vec2 aPos;
+    layout (location = 1) in vec2 aTexCoord;
+    layout (location = 2) in vec4 aColor;
+
+    out vec2 TexCoord;
+    out vec4 Color;
+
+    layout (std140) uniform Camera {
+        mat4 projection;
+        mat4 view;
+    };
+
+    void main() {
+        gl_Position = projection * view * vec4(aPos, 0.0, 1.0);
+        TexCoord = aTexCoord;
+        Color = aColor;
+    }
+)";
+
+constexpr const char* SPRITE_FRAGMENT_SHADER = R"(
+    #version 330 core
+    out vec4 FragColor;
+
+    in vec2 TexCoord;
+    in vec4 Color;
+    uniform sampler2D texture1;
+
+    void main() {
+        FragColor = texture(texture1, TexCoord) * Color;
+    }
+)";
+
+// Executes a sorted RenderQueue: consecutive commands that share shader and
+// texture become one draw, so state only changes at key boundaries. All vertices
+// are generated straight into the vertex stream (on the workers when a builder
+// is given) in one allocation per frame.
+class SpriteBatcher {
+public:
+    static constexpr size_t MAX_QUADS = 16384;  // Sprites per draw call, bounded by the shared index buffers
+
+    // Draw RenderCommand::mesh outlines from this table; without one every command is a quad
+    const SpriteMeshTable* meshes = nullptr;
+
+    explicit SpriteBatcher(StreamBuffer& vertexStream) : stream(vertexStream) {
+        std::vector<uint32_t> indices(MAX_QUADS * 6);
+        for (uint32_t i = 0; i < MAX_QUADS; ++i) {
+            uint32_t base = i * 4;
+            uint32_t* quad = &indices[i * 6];
+            quad[0] = base; quad[1] = base + 1; quad[2] = base + 2;
+            quad[3] = base + 2; quad[4] = base + 3; quad[5] = base;
+        }
+        createVertexArray(vao, ebo, indices);
+
+        // Meshes are fans over MAX_VERTICES slots per sprite
+        const uint32_t slots = SpriteMesh::MAX_VERTICES, fanIndices = (slots - 2) * 3;
+        indices.resize(MAX_QUADS * fanIndices);
+        for (uint32_t i = 0; i < MAX_QUADS; ++i) {
+            uint32_t base = i * slots;
+            uint32_t* fan = &indices[i * fanIndices];
+            for (uint32_t k = 1; k + 1 < slots; ++k, fan += 3) {
+                fan[0] = base; fan[1] = base + k; fan[2] = base + k + 1;
+            }
+        }
+        createVertexArray(meshVao, meshEbo, indices);
+    }
+
+    ~SpriteBatcher() {
+        glState().deleteVertexArray(vao);
+        glState().deleteVertexArray(meshVao);
+        glState().deleteBuffer(ebo);
+        glState().deleteBuffer(meshEbo);
+    }
+
+    SpriteBatcher(const SpriteBatcher&) = delete;
+    SpriteBatcher& operator=(const SpriteBatcher&) = delete;
+
+    // Register a program; the returned id goes into RenderCommand::shader and the sort key
+    uint8_t addShader(const Shader& shader) {
+        shaders.push_back(&shader);
+        return static_cast<uint8_t>(shaders.size() - 1);
+    }
+
+    // A frame where any command has a mesh writes every command as a mesh, quads included
+    void draw(const RenderQueue& queue, ParallelRenderBuilder* builder = nullptr) {
+        if (queue.empty()) return;
+
+        const SpriteMeshTable* frameMeshes = meshes && usesSpriteMeshes(queue) ? meshes : nullptr;
+        vertsPerSprite = frameMeshes ? SpriteMesh::MAX_VERTICES : 4;
+        indicesPerSprite = frameMeshes ? (SpriteMesh::MAX_VERTICES - 2) * 3 : 6;
+        glState().bindVertexArray(frameMeshes ? meshVao : vao);
+        StreamAllocation allocation = stream.allocate(queue.size() * vertsPerSprite * sizeof(SpriteVertex), sizeof(SpriteVertex));
+        SpriteVertex* vertices = static_cast<SpriteVertex*>(allocation.data);
+        if (builder) {
+            builder->buildVertices(queue, vertices, frameMeshes);
+        } else if (frameMeshes) {
+            for (size_t i = 0; i < queue.size(); ++i) {
+                const RenderCommand& cmd = queue.sorted(i);
+                writeMeshVertices(cmd, (*frameMeshes)[cmd.mesh], &vertices[i * vertsPerSprite]);
+            }
+        } else {
+            for (size_t i = 0; i < queue.size(); ++i) writeQuadVertices(queue.sorted(i), &vertices[i * 4]);
+        }
+        stream.commit(allocation);
+        baseVertex = static_cast<GLint>(allocation.offset / sizeof(SpriteVertex));
+
+        glState().setBlend(true);
+        glState().blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        // Walk the sorted commands and draw each run of identical shader/texture
+        size_t runStart = 0;
+        for (size_t i = 1; i <= queue.size(); ++i) {
+            if (i < queue.size()) {
+                const RenderCommand& prev = queue.sorted(i - 1);
+                const RenderCommand& cmd = queue.sorted(i);
+                if (cmd.shader == prev.shader && cmd.texture == prev.texture) continue;
+            }
+            drawRun(queue.sorted(runStart), runStart, i);
+            runStart = i;
+        }
+    }
+
+private:
+    StreamBuffer& stream;
+    GLuint vao = 0, ebo = 0;
+    GLuint meshVao = 0, meshEbo = 0;
+    GLint baseVertex = 0;  // First vertex of this frame's allocation
+    size_t vertsPerSprite = 4, indicesPerSprite = 6;
+    std::vector<const Shader*> shaders;
+
+    void drawRun(const RenderCommand& first, size_t begin, size_t end) {
+        shaders[first.shader]->use();
+        glState().bindTexture(0, first.texture);
+
+        for (size_t quad = begin; quad < end; quad += MAX_QUADS) {
+            size_t quads = std::min(end - quad, MAX_QUADS);
+            glState().drawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(quads * indicesPerSprite), GL_UNSIGNED_INT, 0,
+                                             baseVertex + static_cast<GLint>(quad * vertsPerSprite));
+        }
+    }
+
+    void createVertexArray(GLuint& array, GLuint& elements, const std::vector<uint32_t>& indices) {
+        glGenVertexArrays(1, &array);
+        glGenBuffers(1, &elements);
+
+        glState().bindVertexArray(array);
+        glState().bindBuffer(GL_ARRAY_BUFFER, stream.buffer);
+        glState().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, elements);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (void*)(2 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SpriteVertex), (void*)(4 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+    }
+};
+
+#endif  // SPRITE_BATCH_H
@@ -0,0 +1,232 @@
+#ifndef SPRITE_MESH_H
+#define SPRITE_MESH_H
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "atlas_packer.h"
+#include "image.h"
+#include "render_queue.h"
+
+// Convex outline of a sprite's visible texels, counter-clockwise, in the sprite's
+// own frame: (0,0) is the bottom-left corner of the quad and (1,1) the top-right.
+// The same points place the vertices in the world and in the command's uv rect,
+// so a mesh fits whatever size and atlas region a command draws it at.
+struct SpriteMesh {
+    static constexpr int MAX_VERTICES = 8;
+
+    glm::vec2 points[MAX_VERTICES];
+    uint8_t count = 0;  // 0 for a sprite with nothing visible
+
+    // Fraction of the quad the mesh covers
+    float area() const {
+        float twice = 0.0f;
+        for (int i = 0; i < count; ++i) {
+            const glm::vec2& a = points[i];
+            const glm::vec2& b = points[(i + 1) % count];
+            twice += a.x * b.y - b.x * a.y;
+        }
+        return twice * 0.5f;
+    }
+};
+
+inline SpriteMesh rectMesh(float x0, float y0, float x1, float y1) {
+    SpriteMesh mesh;
+    mesh.points[0] = glm::vec2(x0, y0);
+    mesh.points[1] = glm::vec2(x1, y0);
+    mesh.points[2] = glm::vec2(x1, y1);
+    mesh.points[3] = glm::vec2(x0, y1);
+    mesh.count = 4;
+    return mesh;
+}
+
+inline SpriteMesh quadMesh() { return rectMesh(0.0f, 0.0f, 1.0f, 1.0f); }
+
+// Meshes that RenderCommand::mesh indexes; id 0 is always the full quad
+class SpriteMeshTable {
+public:
+    SpriteMeshTable() { meshes.push_back(quadMesh()); }
+
+    // A mesh that is just the full quad keeps id 0, so the backends stay on their quad path
+    uint16_t add(const SpriteMesh& mesh) {
+        if (isQuad(mesh) || meshes.size() > UINT16_MAX) return 0;
+        meshes.push_back(mesh);
+        return static_cast<uint16_t>(meshes.size() - 1);
+    }
+
+    // Overwrite a mesh from add(), so a sprite traced again keeps its id
+    void replace(uint16_t id, const SpriteMesh& mesh) {
+        if (id > 0 && id < meshes.size()) meshes[id] = mesh;
+    }
+
+    const SpriteMesh& operator[](uint16_t id) const { return meshes[id < meshes.size() ? id : 0]; }
+    size_t size() const { return meshes.size(); }
+
+private:
+    std::vector<SpriteMesh> meshes;
+
+    static bool isQuad(const SpriteMesh& mesh) {
+        SpriteMesh quad = quadMesh();
+        return mesh.count == 4 && std::memcmp(mesh.points, quad.points, sizeof(glm::vec2) * 4) == 0;
+    }
+};
+
+// True when any command in the queue draws a mesh other than the quad
+inline bool usesSpriteMeshes(const RenderQueue& queue) {
+    for (const RenderCommand& cmd : queue.getCommands()) {
+        if (cmd.mesh != 0) return true;
+    }
+    return false;
+}
+
+// Expand one command into MAX_VERTICES fan vertices. Slots past the mesh's own
+// vertices repeat its last one, so their triangles have no area and fill nothing.
+inline void writeMeshVertices(const RenderCommand& cmd, const SpriteMesh& mesh, SpriteVertex* out) {
+    // Blended between the corners, so points on the quad's edges land exactly where writeQuadVertices puts them
+    glm::vec2 low = cmd.position, high = cmd.position + cmd.size;
+    glm::vec2 uvLow(cmd.uv.x, cmd.uv.y), uvHigh(cmd.uv.z, cmd.uv.w);
+    for (int i = 0; i < SpriteMesh::MAX_VERTICES; ++i) {
+        glm::vec2 point = mesh.count > 0 ? mesh.points[std::min(i, mesh.count - 1)] : glm::vec2(0.0f);
+        glm::vec2 position = low * (1.0f - point) + high * point, uv = uvLow * (1.0f - point) + uvHigh * point;
+        out[i] = { position.x, position.y, uv.x, uv.y, cmd.color };
+    }
+}
+
+namespace SpriteMeshBuild {
+
+    inline float cross(const glm::vec2& a, const glm::vec2& b) { return a.x * b.y - a.y * b.x; }
+
+    // Andrew's monotone chain; drops collinear points
+    inline std::vector<glm::vec2> convexHull(std::vector<glm::vec2> points) {
+        std::sort(points.begin(), points.end(), [](const glm::vec2& a, const glm::vec2& b) {
+            return a.x < b.x || (a.x == b.x && a.y < b.y);
+        });
+        points.erase(std::unique(points.begin(), points.end()), points.end());
+        if (points.size() < 3) return points;
+
+        std::vector<glm::vec2> hull(points.size() * 2);
+        size_t k = 0;
+        for (size_t i = 0; i < points.size(); ++i) {
+            while (k >= 2 && cross(hull[k - 1] - hull[k - 2], points[i] - hull[k - 2]) <= 0.0f) --k;
+            hull[k++] = points[i];
+        }
+        for (size_t i = points.size() - 1, lower = k + 1; i-- > 0;) {
+            while (k >= lower && cross(hull[k - 1] - hull[k - 2], points[i] - hull[k - 2]) <= 0.0f) --k;
+            hull[k++] = points[i];
+        }
+        hull.resize(k - 1);
+        return hull;
+    }
+
+    // Cut vertices from a convex polygon without uncovering anything: an edge is
+    // replaced by the point where its two neighbouring edges meet, which only adds
+    // the triangle between them. The edge whose triangle is smallest goes first;
+    // points have to stay inside 'bounds' (the sprite's own rect). False when no
+    // edge can go before the polygon is down to 'maxVertices'.
+    inline bool reduce(std::vector<glm::vec2>& polygon, size_t maxVertices, const glm::vec2& bounds) {
+        const float slack = 1e-3f;
+        while (polygon.size() > maxVertices) {
+            size_t n = polygon.size(), best = n;
+            float bestArea = 0.0f;
+            glm::vec2 bestPoint(0.0f);
+            for (size_t i = 0; i < n; ++i) {
+                const glm::vec2& before = polygon[(i + n - 1) % n];
+                const glm::vec2& a = polygon[i];
+                const glm::vec2& b = polygon[(i + 1) % n];
+                const glm::vec2& after = polygon[(i + 2) % n];
+                glm::vec2 incoming = a - before, outgoing = after - b;
+                float turn = cross(incoming, outgoing);
+                if (turn <= 1e-6f) continue;  // The neighbours never meet on the outside
+
+                glm::vec2 point = a + incoming * (cross(b - a, outgoing) / turn);
+                if (point.x < -slack || point.y < -slack || point.x > bounds.x + slack || point.y > bounds.y + slack) continue;
+                float area = 0.5f * std::fabs(cross(point - a, b - a));
+                if (best == n || area < bestArea) {
+                    best = i;
+                    bestArea = area;
+                    bestPoint = glm::clamp(point, glm::vec2(0.0f), bounds);
+                }
+            }
+            if (best == n) return false;
+
+            polygon[best] = bestPoint;
+            polygon.erase(polygon.begin() + (best + 1) % n);
+        }
+        return true;
+    }
+}
+
+// Preprocess one sprite: the tightest convex mesh of at most 'maxVertices' (4 to
+// 8) around its texels with alpha above 'alphaThreshold'. 'region' is the sprite's
+// rect inside 'rgba' (width x height texels, bottom-up), e.g. an atlas region.
+// Every visible texel is grown by half a texel so bilinear filtering never
+// reaches outside the mesh. The trimmed rect comes back instead whenever the
+// polygon would not cover less; maxVertices 4 just trims the transparent border.
+inline SpriteMesh buildSpriteMesh(const uint8_t* rgba, int width, int height, const PackRect& region,
+                                  int maxVertices = SpriteMesh::MAX_VERTICES, uint8_t alphaThreshold = 0) {
+    using namespace SpriteMeshBuild;
+    maxVertices = std::min(std::max(maxVertices, 4), SpriteMesh::MAX_VERTICES);
+    if (region.x < 0 || region.y < 0 || region.x + region.width > width || region.y + region.height > height ||
+        region.width <= 0 || region.height <= 0) {
+        return quadMesh();
+    }
+    glm::vec2 bounds(static_cast<float>(region.width), static_cast<float>(region.height));
+
+    // Visible span per row, and the outline points of its texels
+    std::vector<glm::vec2> points;
+    int minX = region.width, minY = region.height, maxX = -1, maxY = -1;
+    for (int y = 0; y < region.height; ++y) {
+        const uint8_t* row = rgba + (static_cast<size_t>(region.y + y) * width + region.x) * 4;
+        int first = 0, last = region.width - 1;
+        while (first <= last && row[first * 4 + 3] <= alphaThreshold) ++first;
+        while (last >= first && row[last * 4 + 3] <= alphaThreshold) --last;
+        if (first > last) continue;
+
+        minX = std::min(minX, first);
+        maxX = std::max(maxX, last);
+        minY = std::min(minY, y);
+        maxY = y;
+        for (float py : { y - 0.5f, y + 1.5f }) {
+            for (float px : { first - 0.5f, last + 1.5f }) points.push_back(glm::clamp(glm::vec2(px, py), glm::vec2(0.0f), bounds));
+        }
+    }
+    if (maxX < 0) return SpriteMesh();
+
+    glm::vec2 low = glm::clamp(glm::vec2(minX - 0.5f, minY - 0.5f), glm::vec2(0.0f), bounds);
+    glm::vec2 high = glm::clamp(glm::vec2(maxX + 1.5f, maxY + 1.5f), glm::vec2(0.0f), bounds);
+    SpriteMesh trimmed = rectMesh(low.x / bounds.x, low.y / bounds.y, high.x / bounds.x, high.y / bounds.y);
+    if (maxVertices == 4) return trimmed;
+
+    std::vector<glm::vec2> polygon = convexHull(std::move(points));
+    if (polygon.size() < 3 || !reduce(polygon, static_cast<size_t>(maxVertices), bounds)) return trimmed;
+
+    // Fan from the vertex whose thinnest triangle is fattest; slivers waste GPU quads
+    size_t n = polygon.size(), start = 0;
+    float bestThinnest = -1.0f;
+    for (size_t first = 0; first < n; ++first) {
+        float thinnest = bounds.x * bounds.y;
+        for (size_t k = 1; k + 1 < n; ++k) {
+            const glm::vec2& origin = polygon[first];
+            thinnest = std::min(thinnest, cross(polygon[(first + k) % n] - origin, polygon[(first + k + 1) % n] - origin));
+        }
+        if (thinnest > bestThinnest) {
+            bestThinnest = thinnest;
+            start = first;
+        }
+    }
+
+    SpriteMesh mesh;
+    for (size_t i = 0; i < n; ++i) mesh.points[mesh.count++] = polygon[(start + i) % n] / bounds;
+    return mesh.area() < trimmed.area() ? mesh : trimmed;
+}
+
+inline SpriteMesh buildSpriteMesh(const Image& image, int maxVertices = SpriteMesh::MAX_VERTICES, uint8_t alphaThreshold = 0) {
+    if (image.empty()) return SpriteMesh();
+    return buildSpriteMesh(image.pixels.data(), image.width, image.height, { 0, 0, image.width, image.height },
+                           maxVertices, alphaThreshold);
+}
+
+#endif  // SPRITE_MESH_H
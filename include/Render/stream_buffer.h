@@ -0,0 +1,194 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <glad/glad.h>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "gl_state.h"
+
+// Space handed out by StreamBuffer::allocate; write 'size' bytes to 'data', then commit()
+struct StreamAllocation {
+    void* data = nullptr;
+    GLintptr offset = 0;  // Byte offset inside StreamBuffer::buffer
+    size_t size = 0;
+};
+
+// Counters for the CPU waiting on the GPU (or the driver orphaning for us)
+struct StreamStats {
+    uint32_t stalls = 0;       // Region fences that had not signalled when we needed the region
+    double stallMs = 0.0;      // Time spent waiting on them
+    uint32_t orphans = 0;      // Whole-buffer orphans in the fallback path
+    uint32_t allocations = 0;
+    size_t bytes = 0;
+};
+
+// Ring of N regions (three by default) inside one GL buffer for per-frame
+// vertex/index data. Regions are written through glMapBufferRange with
+// unsynchronized writes, and a fence placed when the CPU leaves a region tells
+// us when the GPU is done reading it. If mapping is unavailable the ring
+// falls back to orphaning the buffer on wrap plus glBufferSubData.
+// Users allocate, write, commit and issue the draws that read an allocation
+// before allocating again, so a region fence always follows its draws.
+class StreamBuffer {
+public:
+    GLuint buffer = 0;
+    GLenum target;
+
+    StreamBuffer(GLenum bufferTarget, size_t bytesPerRegion, int regionCount = 3, bool useMapping = true)
+        : target(bufferTarget), regionSize(bytesPerRegion), fences(regionCount, nullptr), mapping(useMapping) {
+        glGenBuffers(1, &buffer);
+        allocateStorage();
+    }
+
+    ~StreamBuffer() {
+        for (GLsync& fence : fences) {
+            if (fence) glDeleteSync(fence);
+        }
+        glState().deleteBuffer(buffer);
+    }
+
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    // Reserve 'size' bytes; offset is a multiple of 'alignment' (any stride, not only powers of two).
+    // Requests larger than a region grow the ring, which orphans the current storage.
+    StreamAllocation allocate(size_t size, size_t alignment = 16) {
+        if (size + alignment > regionSize) {
+            size_t grown = regionSize;
+            while (size + alignment > grown) grown *= 2;
+            regionSize = grown;
+            dropFences();
+            allocateStorage();
+            region = 0;
+            cursor = 0;
+            regionAcquired = false;
+        }
+
+        size_t aligned = alignUp(regionBase() + cursor, alignment) - regionBase();
+        if (aligned + size > regionSize) {
+            nextRegion();
+            aligned = alignUp(regionBase(), alignment) - regionBase();
+        }
+        if (!regionAcquired) acquireRegion();
+
+        StreamAllocation allocation;
+        allocation.offset = static_cast<GLintptr>(regionBase() + aligned);
+        allocation.size = size;
+        cursor = aligned + size;
+
+        glState().bindBuffer(target, buffer);
+        if (mapping) {
+            allocation.data = glMapBufferRange(target, allocation.offset, size,
+                GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+            glState().countIssued();
+            if (!allocation.data) {
+                std::fprintf(stderr, "glMapBufferRange failed, streaming falls back to orphaning\n");
+                mapping = false;
+            }
+        }
+        if (!mapping) {
+            if (staging.size() < size) staging.resize(size);
+            allocation.data = staging.data();
+        }
+
+        ++current.allocations;
+        current.bytes += size;
+        return allocation;
+    }
+
+    // Finish writing an allocation; must happen before any draw that reads it
+    void commit(const StreamAllocation& allocation) {
+        glState().bindBuffer(target, buffer);
+        if (mapping) glUnmapBuffer(target);
+        else glBufferSubData(target, allocation.offset, allocation.size, allocation.data);
+        glState().countIssued();
+    }
+
+    // Fence the region written this frame and move on, so the next frame never
+    // writes memory the GPU may still be reading
+    void endFrame() {
+        if (cursor > 0) nextRegion();
+        lastFrame = current;
+        current = StreamStats();
+    }
+
+    bool usesMapping() const { return mapping; }
+    size_t bytesPerRegion() const { return regionSize; }
+    const StreamStats& lastFrameStats() const { return lastFrame; }
+
+private:
+    size_t regionSize;
+    std::vector<GLsync> fences;
+    bool mapping;
+    int region = 0;
+    size_t cursor = 0;
+    bool regionAcquired = false;
+    std::vector<unsigned char> staging;
+    StreamStats current;
+    StreamStats lastFrame;
+
+    size_t regionBase() const { return region * regionSize; }
+
+    static size_t alignUp(size_t value, size_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    void allocateStorage() {
+        glState().bindBuffer(target, buffer);
+        glBufferData(target, regionSize * fences.size(), nullptr, GL_STREAM_DRAW);
+        glState().countIssued();
+    }
+
+    void nextRegion() {
+        if (mapping) {
+            if (fences[region]) glDeleteSync(fences[region]);
+            fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            glState().countIssued();
+        }
+        region = (region + 1) % static_cast<int>(fences.size());
+        cursor = 0;
+        regionAcquired = false;
+    }
+
+    // Block until the GPU has finished with the region we are about to overwrite
+    void acquireRegion() {
+        regionAcquired = true;
+
+        if (!mapping) {
+            // Orphaning: the driver gives us new storage once per trip round the ring
+            if (region == 0) {
+                allocateStorage();
+                ++current.orphans;
+            }
+            return;
+        }
+
+        GLsync fence = fences[region];
+        if (!fence) return;
+
+        GLenum status = glClientWaitSync(fence, 0, 0);
+        if (status == GL_TIMEOUT_EXPIRED) {
+            ++current.stalls;
+            auto start = std::chrono::steady_clock::now();
+            do {
+                status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+            } while (status == GL_TIMEOUT_EXPIRED);
+            current.stallMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+        glDeleteSync(fence);
+        fences[region] = nullptr;
+        glState().countIssued(2);
+    }
+
+    void dropFences() {
+        for (GLsync& fence : fences) {
+            if (fence) glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+};
+
+#endif  // STREAM_BUFFER_H
@@ -0,0 +1,239 @@
+#ifndef TEXT_RENDERER_H
+#define TEXT_RENDERER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "bitmap_font.h"
+#include "gl_state.h"
+#include "shader.h"
+#include "stream_buffer.h"
+
+// Screen-space glyph quads: pixels with the origin at the top left, y down
+constexpr const char* TEXT_VERTEX_SHADER = R"(
+    #version 330 core
+    layout (location = 0) in vec4 aRect;    // x, y, width, height
+    layout (location = 1) in vec4 aUV;      // u0, v0, u1, v1
+    layout (location = 2) in vec4 aColor;
+    out vec2 TexCoord;
+    out vec4 Color;
+    uniform vec2 screenSize;
+
+    void main() {
+        vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+        vec2 pixel = aRect.xy + corner * aRect.zw;
+        TexCoord = mix(aUV.xy, aUV.zw, corner);
+        Color = aColor;
+        gl_Position = vec4(pixel.x / screenSize.x * 2.0 - 1.0, 1.0 - pixel.y / screenSize.y * 2.0, 0.0, 1.0);
+    }
+)";
+
+constexpr const char* TEXT_FRAGMENT_SHADER = R"(
+    #version 330 core
+    out vec4 FragColor;
+    in vec2 TexCoord;
+    in vec4 Color;
+    uniform sampler2D font;
+
+    void main() {
+        FragColor = Color * texture(font, TexCoord);
+    }
+)";
+
+// One glyph as the GPU reads it
+struct TextInstance {
+    float x, y, width, height;
+    GlyphUV uv;
+    uint32_t color;
+};
+
+// Counters for the last TextRenderer::draw
+struct TextStats {
+    size_t strings = 0;
+    size_t glyphs = 0;
+    size_t cacheHits = 0;
+    size_t cacheMisses = 0;
+    size_t cachedLayouts = 0;
+};
+
+// Batched text for HUDs and debug labels. add() queues a string, draw() sends
+// every glyph queued this frame as one instanced draw. Layouts (glyph and
+// cell position per character) are cached by string, so a label that does
+// not change is a hash lookup plus a copy per frame; strings that change
+// every frame, like counters, skip the cache. After warm-up nothing allocates.
+class TextRenderer {
+public:
+    BitmapFont font;
+    size_t maxCachedLayouts = 1024;  // Past this, layouts unused in a frame are dropped at draw()
+    float lineSpacing = 1.25f;       // In glyph heights
+
+    TextRenderer()
+        : shader(TEXT_VERTEX_SHADER, TEXT_FRAGMENT_SHADER),
+          stream(GL_ARRAY_BUFFER, 1 << 20) {
+        screenSizeLocation = shader.uniform("screenSize");
+        fontLocation = shader.uniform("font");
+        glGenVertexArrays(1, &vao);
+        glState().bindVertexArray(vao);
+        for (GLuint attribute = 0; attribute < 3; ++attribute) {
+            glEnableVertexAttribArray(attribute);
+            glVertexAttribDivisor(attribute, 1);
+        }
+        instances.reserve(4096);
+    }
+
+    ~TextRenderer() { glState().deleteVertexArray(vao); }
+
+    TextRenderer(const TextRenderer&) = delete;
+    TextRenderer& operator=(const TextRenderer&) = delete;
+
+    // Queue text with its top-left corner at 'position' in pixels. 'scale' is
+    // pixels per font texel; whole numbers keep the glyphs sharp. Pass
+    // cacheLayout = false for text that changes from frame to frame.
+    void add(std::string_view text, glm::vec2 position, float scale = 1.0f, uint32_t color = 0xFFFFFFFFu,
+             bool cacheLayout = true) {
+        ++current.strings;
+        position = glm::floor(position);
+        if (!cacheLayout) {
+            layoutInto(text, position, scale, color);
+            return;
+        }
+
+        key.assign(text.data(), text.size());
+        auto it = layouts.find(key);
+        if (it == layouts.end()) {
+            ++current.cacheMisses;
+            it = layouts.emplace(key, Layout()).first;
+            layout(text, it->second);
+        } else {
+            ++current.cacheHits;
+        }
+        it->second.lastUsed = frame;
+
+        float cell = FONT_GLYPH_SIZE * scale;
+        for (const PlacedGlyph& glyph : it->second.glyphs) {
+            instances.push_back({ position.x + glyph.column * cell, position.y + glyph.row * cell * lineSpacing,
+                                  cell, cell, font.uv(glyph.glyph), color });
+        }
+    }
+
+    // Size in pixels that add() would cover
+    glm::vec2 measure(std::string_view text, float scale = 1.0f) const {
+        int columns = 0, widest = 0, lines = 1;
+        for (char c : text) {
+            if (c == '\n') {
+                ++lines;
+                columns = 0;
+            } else {
+                widest = std::max(widest, ++columns);
+            }
+        }
+        float cell = FONT_GLYPH_SIZE * scale;
+        return glm::vec2(widest * cell, cell + (lines - 1) * cell * lineSpacing);
+    }
+
+    // Draw everything queued since the last call into the bound framebuffer of width x height pixels
+    void draw(int width, int height) {
+        current.glyphs = instances.size();
+        if (!instances.empty()) {
+            StreamAllocation allocation = stream.allocate(instances.size() * sizeof(TextInstance), sizeof(TextInstance));
+            std::memcpy(allocation.data, instances.data(), allocation.size);
+            stream.commit(allocation);
+
+            // Instanced attributes cannot take a base vertex, so point them at this frame's allocation
+            glState().bindVertexArray(vao);
+            glState().bindBuffer(GL_ARRAY_BUFFER, stream.buffer);
+            glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(TextInstance), (void*)allocation.offset);
+            glVertexAttribPointer(1, 4, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(TextInstance),
+                                  (void*)(allocation.offset + offsetof(TextInstance, uv)));
+            glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(TextInstance),
+                                  (void*)(allocation.offset + offsetof(TextInstance, color)));
+            glState().countIssued(3);
+
+            shader.use();
+            glState().bindTexture(0, font.atlas.textureID);
+            Shader::setInt(fontLocation, 0);
+            Shader::setVec2(screenSizeLocation, glm::vec2(width, height));
+            glState().countIssued(2);
+
+            glState().setBlend(true);
+            glState().blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(instances.size()));
+            glState().countDrawCall();
+            stream.endFrame();
+        }
+
+        if (layouts.size() > maxCachedLayouts) evictUnused();
+        current.cachedLayouts = layouts.size();
+        stats = current;
+        current = TextStats();
+        instances.clear();
+        ++frame;
+    }
+
+    const TextStats& lastStats() const { return stats; }
+
+private:
+    struct PlacedGlyph {
+        uint16_t glyph;
+        uint16_t column, row;
+    };
+    struct Layout {
+        std::vector<PlacedGlyph> glyphs;
+        uint64_t lastUsed = 0;
+    };
+
+    Shader shader;
+    StreamBuffer stream;
+    GLuint vao = 0;
+    GLint screenSizeLocation, fontLocation;
+    std::vector<TextInstance> instances;
+    std::unordered_map<std::string, Layout> layouts;
+    std::string key;  // Lookup buffer, so finding a cached layout does not allocate
+    uint64_t frame = 0;
+    TextStats current, stats;
+
+    // Monospaced: a glyph's cell is its column and line; spaces take a cell but no quad
+    template <typename Fn>
+    static void forEachGlyph(std::string_view text, Fn&& fn) {
+        uint16_t column = 0, row = 0;
+        for (char c : text) {
+            if (c == '\n') {
+                column = 0;
+                ++row;
+                continue;
+            }
+            if (c != ' ') fn(PlacedGlyph{ static_cast<uint16_t>(BitmapFont::glyphIndex(c)), column, row });
+            ++column;
+        }
+    }
+
+    void layout(std::string_view text, Layout& out) const {
+        out.glyphs.clear();
+        forEachGlyph(text, [&](const PlacedGlyph& glyph) { out.glyphs.push_back(glyph); });
+    }
+
+    void layoutInto(std::string_view text, glm::vec2 position, float scale, uint32_t color) {
+        float cell = FONT_GLYPH_SIZE * scale;
+        forEachGlyph(text, [&](const PlacedGlyph& glyph) {
+            instances.push_back({ position.x + glyph.column * cell, position.y + glyph.row * cell * lineSpacing,
+                                  cell, cell, font.uv(glyph.glyph), color });
+        });
+    }
+
+    void evictUnused() {
+        for (auto it = layouts.begin(); it != layouts.end();) {
+            if (it->second.lastUsed != frame) it = layouts.erase(it);
+            else ++it;
+        }
+    }
+};
+
+#endif  // TEXT_RENDERER_H
@@ -0,0 +1,94 @@
+#ifndef TEXTURE_ATLAS_H
+#define TEXTURE_ATLAS_H
+
+#include <glad/glad.h>
+#include <string>
+#include "gl_state.h"
+#include "atlas_packer.h"
+
+// GL page backed by an AtlasPacker. Sprites can come from an offline-packed
+// atlas file or be added at runtime, in which case only their slot is uploaded.
+class TextureAtlas {
+public:
+    AtlasPacker packer;
+    GLuint textureID = 0;
+
+    TextureAtlas(int width, int height, int padding = 2, int extrude = 1)
+        : packer(width, height, padding, extrude) {
+        createTexture(nullptr);
+    }
+
+    ~TextureAtlas() {
+        if (textureID) glState().deleteTexture(textureID);
+    }
+
+    TextureAtlas(const TextureAtlas&) = delete;
+    TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+    // Pack a sprite at runtime; returns nullptr when the page is full
+    const AtlasRegion* addSprite(const std::string& name, const Image& sprite) {
+        int existing = packer.find(name);
+        if (existing >= 0) return &packer.getRegions()[existing];
+
+        int index = packer.add(name, sprite);
+        if (index < 0) {
+            std::cerr << "Texture atlas is full, cannot add " << name << std::endl;
+            return nullptr;
+        }
+
+        // Upload the whole slot so the extruded border goes up with the sprite
+        const PackRect& slot = packer.lastSlotRect();
+        const Image& page = packer.getPage();
+        glState().bindTexture(0, textureID);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, page.width);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, slot.x, slot.y, slot.width - packer.padding, slot.height - packer.padding,
+                        GL_RGBA, GL_UNSIGNED_BYTE, page.pixel(slot.x, slot.y));
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        return &packer.getRegions()[index];
+    }
+
+    // Decode an image file and add it under its path
+    const AtlasRegion* addSprite(const char* path) {
+        int existing = packer.find(path);
+        if (existing >= 0) return &packer.getRegions()[existing];
+
+        Image sprite;
+        if (!loadImage(path, sprite)) return nullptr;
+        return addSprite(path, sprite);
+    }
+
+    // Replace the page with one produced by tools/atlas_packer
+    bool loadFromFile(const char* atlasPath) {
+        std::string imagePath;
+        if (!packer.load(atlasPath, imagePath)) return false;
+
+        Image page;
+        if (!loadImage(imagePath.c_str(), page)) return false;
+        if (page.width != packer.width || page.height != packer.height) {
+            std::cerr << "Atlas image size does not match " << atlasPath << std::endl;
+            return false;
+        }
+        createTexture(page.pixels.data());
+        return true;
+    }
+
+    const AtlasRegion* find(const std::string& name) const {
+        int index = packer.find(name);
+        return index < 0 ? nullptr : &packer.getRegions()[index];
+    }
+
+private:
+    void createTexture(const unsigned char* pixels) {
+        if (!textureID) glGenTextures(1, &textureID);
+        glState().bindTexture(0, textureID);
+
+        // No mipmaps: lower levels would blend neighbouring sprites regardless of padding
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, packer.width, packer.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    }
+};
+
+#endif  // TEXTURE_ATLAS_H
@@ -0,0 +1,421 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <list>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "async_texture_loader.h"
+#include "gl_state.h"
+#include "hash.h"
+#include "texture_container.h"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#define TEXTURE_CACHE_INOTIFY
+#endif
+
+// Small dense ids for paths, so lookups after the first compare integers
+class PathInterner {
+public:
+    using Id = uint32_t;
+
+    // Same id for every spelling of a path ("a/./b.png" and "a/b.png")
+    Id intern(const std::string& path) {
+        std::string normal = normalize(path);
+        auto it = ids.find(normal);
+        if (it != ids.end()) return it->second;
+        Id id = static_cast<Id>(paths.size());
+        ids.emplace(normal, id);
+        paths.push_back(std::move(normal));
+        return id;
+    }
+
+    // The id of a path interned before, without adding one for a path never seen
+    bool find(const std::string& path, Id& id) const {
+        auto it = ids.find(normalize(path));
+        if (it == ids.end()) return false;
+        id = it->second;
+        return true;
+    }
+
+    const std::string& path(Id id) const { return paths[id]; }
+    size_t size() const { return paths.size(); }
+
+private:
+    static std::string normalize(const std::string& path) {
+        return std::filesystem::path(path).lexically_normal().generic_string();
+    }
+
+    std::unordered_map<std::string, Id> ids;
+    std::vector<std::string> paths;
+};
+
+// Counters for TextureCache
+struct TextureCacheStats {
+    uint64_t requests = 0;
+    uint64_t pathHits = 0;      // Path already resident
+    uint64_t contentHits = 0;   // New path, but the same bytes as a resident texture
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t reloads = 0;
+    size_t residentBytes = 0;   // GPU bytes of every uploaded level
+    size_t textures = 0;
+    size_t unreferenced = 0;    // Resident but held by no handle; first to go
+
+    double hitRate() const { return requests ? static_cast<double>(pathHits + contentHits) / requests : 0.0; }
+};
+
+class TextureCache;
+
+// Counted reference to the texture for a path; the texture stays resident
+// while any handle holds it, and the handle follows the path to a new texture
+// when a reload gives the path one of its own
+class TextureHandle {
+public:
+    TextureHandle() = default;
+    TextureHandle(const TextureHandle& other);
+    TextureHandle(TextureHandle&& other) noexcept : cache(other.cache), path(other.path) { other.cache = nullptr; }
+    TextureHandle& operator=(TextureHandle other) noexcept {
+        std::swap(cache, other.cache);
+        std::swap(path, other.path);
+        return *this;
+    }
+    ~TextureHandle();
+
+    GLuint id() const;
+    explicit operator bool() const { return cache != nullptr; }
+
+private:
+    friend class TextureCache;
+    TextureHandle(TextureCache* owner, PathInterner::Id id);
+
+    TextureCache* cache = nullptr;
+    PathInterner::Id path = 0;
+};
+
+// Textures shared by path and by content. acquire() returns a handle to the
+// resident texture for a path when there is one; a new path whose file has
+// the same bytes as a resident texture (compared by hashWords) shares it too.
+// Anything else is loaded through the AsyncTextureLoader. Textures no handle
+// holds stay resident on an LRU list and are only deleted once resident bytes
+// pass the budget, so dropping and re-acquiring a texture costs nothing.
+// Files are watched (inotify on Linux, modification times elsewhere) and a
+// changed file is decoded again into the same texture name, unless other paths
+// share that texture: then the changed path moves to a texture of its own.
+class TextureCache {
+public:
+    size_t budgetBytes = size_t(256) << 20;
+    int pollInterval = 30;  // update() calls between modification-time checks where inotify is unavailable
+
+    explicit TextureCache(AsyncTextureLoader& textureLoader) : loader(textureLoader) {
+#ifdef TEXTURE_CACHE_INOTIFY
+        watchFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+    }
+
+    ~TextureCache() {
+        for (Entry& entry : entries) {
+            if (entry.texture) glState().deleteTexture(entry.texture);
+        }
+#ifdef TEXTURE_CACHE_INOTIFY
+        if (watchFd >= 0) close(watchFd);
+#endif
+    }
+
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    // Empty handle when the file cannot be read
+    TextureHandle acquire(const char* path) {
+        ++stats.requests;
+        PathInterner::Id id = paths.intern(path);
+        if (pathSlots.count(id)) {
+            ++stats.pathHits;
+            return TextureHandle(this, id);
+        }
+
+        uint64_t hash;
+        if (!hashFile(paths.path(id), hash)) return TextureHandle();
+        auto byContent = contentSlots.find(hash);
+        if (byContent != contentSlots.end()) {
+            ++stats.contentHits;
+            addPath(byContent->second, id);
+            return TextureHandle(this, id);
+        }
+
+        ++stats.misses;
+        addPath(loadSlot(id, hash), id);
+        return TextureHandle(this, id);
+    }
+
+    // Once per frame on the GL thread: reload changed files, upload what the
+    // loader has ready and evict past the budget. Returns the textures completed.
+    size_t update() {
+        reloadChanged();
+        size_t completed = loader.update();
+        for (const LoadedTexture& loaded : loader.lastCompleted()) {
+            auto it = textureSlots.find(loaded.texture);
+            if (it == textureSlots.end()) continue;
+            Entry& entry = entries[it->second];
+            stats.residentBytes = stats.residentBytes - entry.bytes + loaded.bytes;
+            entry.bytes = loaded.bytes;
+            --entry.loadsInFlight;
+        }
+        for (GLuint texture : loader.lastFailed()) {
+            auto it = textureSlots.find(texture);
+            if (it != textureSlots.end()) --entries[it->second].loadsInFlight;
+        }
+        evict(budgetBytes);
+        return completed;
+    }
+
+    // Delete every texture no handle holds
+    void trim() { evict(0); }
+
+    const TextureCacheStats& lastStats() const { return stats; }
+
+private:
+    friend class TextureHandle;
+
+    struct Entry {
+        GLuint texture = 0;
+        uint64_t contentHash = 0;
+        uint32_t references = 0;    // Handles over every path on this entry
+        uint32_t loadsInFlight = 0; // The loader still writes to the texture, so it cannot be deleted yet
+        size_t bytes = 0;
+        std::vector<PathInterner::Id> paths;
+        std::list<uint32_t>::iterator lruPosition;
+        bool inLru = false;
+    };
+    struct PathEntry {
+        uint32_t slot;
+        uint32_t references = 0;    // Handles acquired through this path
+    };
+
+    AsyncTextureLoader& loader;
+    PathInterner paths;
+    std::vector<Entry> entries;
+    std::vector<uint32_t> freeSlots;
+    std::unordered_map<PathInterner::Id, PathEntry> pathSlots;
+    std::unordered_map<uint64_t, uint32_t> contentSlots;
+    std::unordered_map<GLuint, uint32_t> textureSlots;
+    std::list<uint32_t> lru;  // Unreferenced entries, least recently released at the back
+    TextureCacheStats stats;
+
+#ifdef TEXTURE_CACHE_INOTIFY
+    int watchFd = -1;
+    std::unordered_map<int, std::string> watchedDirectories;  // Watch descriptor to directory
+#else
+    std::unordered_map<PathInterner::Id, std::filesystem::file_time_type> modifiedTimes;
+    int updatesSincePoll = 0;
+#endif
+
+    void retain(PathInterner::Id id) {
+        PathEntry& path = pathSlots.find(id)->second;
+        ++path.references;
+        retainSlot(path.slot, 1);
+    }
+
+    void release(PathInterner::Id id) {
+        PathEntry& path = pathSlots.find(id)->second;
+        --path.references;
+        releaseSlot(path.slot, 1);
+    }
+
+    void retainSlot(uint32_t slot, uint32_t count) {
+        Entry& entry = entries[slot];
+        if (entry.references == 0 && entry.inLru) {
+            lru.erase(entry.lruPosition);
+            entry.inLru = false;
+        }
+        entry.references += count;
+    }
+
+    void releaseSlot(uint32_t slot, uint32_t count) {
+        Entry& entry = entries[slot];
+        entry.references -= count;
+        if (entry.references == 0 && !entry.inLru) {
+            lru.push_front(slot);
+            entry.lruPosition = lru.begin();
+            entry.inLru = true;
+        }
+    }
+
+    uint32_t allocateSlot() {
+        if (!freeSlots.empty()) {
+            uint32_t slot = freeSlots.back();
+            freeSlots.pop_back();
+            return slot;
+        }
+        entries.emplace_back();
+        return static_cast<uint32_t>(entries.size()) - 1;
+    }
+
+    // A new entry whose texture the loader fills from the file at 'id'
+    uint32_t loadSlot(PathInterner::Id id, uint64_t hash) {
+        uint32_t slot = allocateSlot();
+        Entry& entry = entries[slot];
+        entry.texture = loader.load(paths.path(id).c_str());
+        entry.contentHash = hash;
+        entry.loadsInFlight = 1;
+        contentSlots[hash] = slot;
+        textureSlots[entry.texture] = slot;
+        return slot;
+    }
+
+    void addPath(uint32_t slot, PathInterner::Id id) {
+        entries[slot].paths.push_back(id);
+        pathSlots[id] = PathEntry{ slot };
+        watch(id);
+    }
+
+    // Move a path, and the handles acquired through it, onto another entry.
+    // An entry left with no handles goes on the LRU list like any other.
+    void movePath(PathInterner::Id id, uint32_t slot) {
+        PathEntry& path = pathSlots.find(id)->second;
+        std::vector<PathInterner::Id>& from = entries[path.slot].paths;
+        from.erase(std::find(from.begin(), from.end(), id));
+        entries[slot].paths.push_back(id);
+        if (path.references > 0) retainSlot(slot, path.references);
+        else releaseSlot(slot, 0);
+        releaseSlot(path.slot, path.references);
+        path.slot = slot;
+    }
+
+    static bool hashFile(const std::string& path, uint64_t& hash) {
+        std::vector<uint8_t> bytes;
+        if (!readFile(path.c_str(), bytes) || bytes.empty()) {
+            std::cerr << "Failed to open texture: " << path << std::endl;
+            return false;
+        }
+        hash = hashWords(bytes.data(), bytes.size());
+        return true;
+    }
+
+    void evict(size_t budget) {
+        for (auto it = lru.end(); stats.residentBytes > budget && it != lru.begin();) {
+            uint32_t slot = *--it;
+            Entry& entry = entries[slot];
+            if (entry.loadsInFlight > 0) continue;
+            it = lru.erase(it);
+            for (PathInterner::Id id : entry.paths) pathSlots.erase(id);
+            auto byContent = contentSlots.find(entry.contentHash);
+            if (byContent != contentSlots.end() && byContent->second == slot) contentSlots.erase(byContent);
+            textureSlots.erase(entry.texture);
+            glState().deleteTexture(entry.texture);
+            stats.residentBytes -= entry.bytes;
+            ++stats.evictions;
+            entry = Entry();
+            freeSlots.push_back(slot);
+        }
+        stats.textures = textureSlots.size();
+        stats.unreferenced = lru.size();
+    }
+
+    // A changed file goes back through the loader into the texture it already
+    // has when no other path shares it. Paths deduplicated onto the same texture
+    // did not change, so then the changed path gets a texture of its own, or
+    // joins a resident one that already holds the new bytes.
+    void reload(PathInterner::Id id) {
+        auto it = pathSlots.find(id);
+        if (it == pathSlots.end()) return;
+        uint32_t slot = it->second.slot;
+        uint64_t hash;
+        if (!hashFile(paths.path(id), hash) || hash == entries[slot].contentHash) return;
+        ++stats.reloads;
+
+        auto byContent = contentSlots.find(hash);
+        if (byContent != contentSlots.end()) {
+            movePath(id, byContent->second);
+            return;
+        }
+        if (entries[slot].paths.size() > 1) {
+            movePath(id, loadSlot(id, hash));
+            return;
+        }
+
+        Entry& entry = entries[slot];
+        auto old = contentSlots.find(entry.contentHash);
+        if (old != contentSlots.end() && old->second == slot) contentSlots.erase(old);
+        entry.contentHash = hash;
+        contentSlots.emplace(hash, slot);
+        loader.loadInto(entry.texture, paths.path(id).c_str());
+        ++entry.loadsInFlight;
+    }
+
+#ifdef TEXTURE_CACHE_INOTIFY
+    void watch(PathInterner::Id id) {
+        if (watchFd < 0) return;
+        std::string directory = std::filesystem::path(paths.path(id)).parent_path().generic_string();
+        if (directory.empty()) directory = ".";
+        // Editors save by writing in place or by renaming a temporary over the file; catch both
+        int descriptor = inotify_add_watch(watchFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (descriptor >= 0) watchedDirectories[descriptor] = directory;
+    }
+
+    void reloadChanged() {
+        if (watchFd < 0) return;
+        alignas(inotify_event) char buffer[4096];
+        std::vector<PathInterner::Id> changed;
+        for (;;) {
+            ssize_t length = read(watchFd, buffer, sizeof(buffer));
+            if (length <= 0) break;
+            for (char* cursor = buffer; cursor < buffer + length;) {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(cursor);
+                cursor += sizeof(inotify_event) + event->len;
+                auto directory = watchedDirectories.find(event->wd);
+                if (event->len == 0 || directory == watchedDirectories.end()) continue;
+                PathInterner::Id id;
+                if (!paths.find(directory->second + "/" + event->name, id)) continue;
+                if (pathSlots.count(id) && std::find(changed.begin(), changed.end(), id) == changed.end()) changed.push_back(id);
+            }
+        }
+        for (PathInterner::Id id : changed) reload(id);
+    }
+#else
+    void watch(PathInterner::Id id) {
+        std::error_code error;
+        modifiedTimes[id] = std::filesystem::last_write_time(paths.path(id), error);
+    }
+
+    void reloadChanged() {
+        if (++updatesSincePoll < pollInterval) return;
+        updatesSincePoll = 0;
+        for (auto& [id, time] : modifiedTimes) {
+            if (!pathSlots.count(id)) continue;
+            std::error_code error;
+            auto modified = std::filesystem::last_write_time(paths.path(id), error);
+            if (error || modified == time) continue;
+            time = modified;
+            reload(id);
+        }
+    }
+#endif
+};
+
+inline TextureHandle::TextureHandle(TextureCache* owner, PathInterner::Id id) : cache(owner), path(id) {
+    cache->retain(path);
+}
+
+inline TextureHandle::TextureHandle(const TextureHandle& other) : cache(other.cache), path(other.path) {
+    if (cache) cache->retain(path);
+}
+
+inline TextureHandle::~TextureHandle() {
+    if (cache) cache->release(path);
+}
+
+inline GLuint TextureHandle::id() const {
+    return cache ? cache->entries[cache->pathSlots.find(path)->second.slot].texture : 0;
+}
+
+#endif  // TEXTURE_CACHE_H
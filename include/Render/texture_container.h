@@ -0,0 +1,273 @@
+#ifndef TEXTURE_CONTAINER_H
+#define TEXTURE_CONTAINER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+#include "image.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read-only memory mapping of a whole file. Pages are read in as they are
+// touched, so handing a mapped level straight to GL copies it out of the page
+// cache without an intermediate buffer.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            close();
+            bytes = other.bytes;
+            length = other.length;
+#ifdef _WIN32
+            mapping = other.mapping;
+            other.mapping = nullptr;
+#endif
+            other.bytes = nullptr;
+            other.length = 0;
+        }
+        return *this;
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const char* path) {
+        close();
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+            CloseHandle(file);
+            return false;
+        }
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);  // The mapping keeps the file open
+        if (!mapping) return false;
+        bytes = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!bytes) {
+            CloseHandle(mapping);
+            mapping = nullptr;
+            return false;
+        }
+        length = static_cast<size_t>(fileSize.QuadPart);
+#else
+        int file = ::open(path, O_RDONLY);
+        if (file < 0) return false;
+        struct stat info;
+        if (fstat(file, &info) != 0 || info.st_size == 0) {
+            ::close(file);
+            return false;
+        }
+        void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+        ::close(file);  // The mapping keeps the file open
+        if (view == MAP_FAILED) return false;
+        bytes = static_cast<const uint8_t*>(view);
+        length = static_cast<size_t>(info.st_size);
+#endif
+        return true;
+    }
+
+    void close() {
+        if (!bytes) return;
+#ifdef _WIN32
+        UnmapViewOfFile(bytes);
+        CloseHandle(mapping);
+        mapping = nullptr;
+#else
+        munmap(const_cast<uint8_t*>(bytes), length);
+#endif
+        bytes = nullptr;
+        length = 0;
+    }
+
+    const uint8_t* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const uint8_t* bytes = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    HANDLE mapping = nullptr;
+#endif
+};
+
+// Pixel layout of every level in a container
+enum class TextureFormat : uint32_t {
+    RGBA8 = 0,
+    BC1 = 1,  // 4x4 blocks of 8 bytes, 1-bit alpha
+};
+
+// On-disk layout, little-endian: header, level table, then the level data,
+// each level starting on a 16-byte boundary. Levels are bottom-up like the
+// images loadImage returns, largest first, ready for glTexImage2D as they are.
+struct TextureFileHeader {
+    char magic[4];           // "TEX1"
+    uint32_t version;
+    uint32_t format;         // TextureFormat
+    uint32_t width, height;  // Level 0
+    uint32_t levelCount;
+    uint32_t checksum[2];    // Low and high half of a checksum of the level data; 0 when not recorded
+};
+
+struct TextureFileLevel {
+    uint64_t offset;         // From the start of the file
+    uint64_t size;
+    uint32_t width, height;
+};
+
+constexpr uint32_t TEXTURE_FILE_VERSION = 1;
+constexpr uint32_t TEXTURE_MAX_LEVELS = 16;
+
+// Bytes of one level of the given format
+inline size_t textureLevelSize(TextureFormat format, uint32_t width, uint32_t height) {
+    if (format == TextureFormat::BC1) return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * 8;
+    return static_cast<size_t>(width) * height * 4;
+}
+
+// One level as stored, pointing into the mapping
+struct TextureLevel {
+    uint32_t width = 0, height = 0;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+};
+
+// A cooked texture opened through a file mapping. Nothing is copied: levels
+// point straight into the mapped file and stay valid while this is open.
+class TextureContainer {
+public:
+    bool open(const char* path) {
+        if (!file.open(path)) {
+            std::cerr << "Failed to open texture container: " << path << std::endl;
+            return false;
+        }
+        if (!parse()) {
+            std::cerr << "Malformed texture container: " << path << std::endl;
+            file.close();
+            return false;
+        }
+        return true;
+    }
+
+    bool isOpen() const { return file.data() != nullptr; }
+    TextureFormat format() const { return static_cast<TextureFormat>(header().format); }
+    uint32_t width() const { return header().width; }
+    uint32_t height() const { return header().height; }
+    uint32_t levelCount() const { return static_cast<uint32_t>(levels.size()); }
+    const TextureLevel& level(uint32_t index) const { return levels[index]; }
+    uint64_t checksum() const { return static_cast<uint64_t>(header().checksum[1]) << 32 | header().checksum[0]; }
+
+private:
+    MappedFile file;
+    std::vector<TextureLevel> levels;
+
+    const TextureFileHeader& header() const { return *reinterpret_cast<const TextureFileHeader*>(file.data()); }
+
+    bool parse() {
+        levels.clear();
+        if (file.size() < sizeof(TextureFileHeader)) return false;
+        const TextureFileHeader& head = header();
+        if (std::memcmp(head.magic, "TEX1", 4) != 0 || head.version != TEXTURE_FILE_VERSION) return false;
+        if (head.format > static_cast<uint32_t>(TextureFormat::BC1)) return false;
+        if (head.levelCount == 0 || head.levelCount > TEXTURE_MAX_LEVELS) return false;
+        if (file.size() < sizeof(TextureFileHeader) + head.levelCount * sizeof(TextureFileLevel)) return false;
+
+        const TextureFileLevel* table = reinterpret_cast<const TextureFileLevel*>(file.data() + sizeof(TextureFileHeader));
+        for (uint32_t i = 0; i < head.levelCount; ++i) {
+            const TextureFileLevel& entry = table[i];
+            uint32_t expectedWidth = std::max(1u, head.width >> i), expectedHeight = std::max(1u, head.height >> i);
+            if (entry.width != expectedWidth || entry.height != expectedHeight) return false;
+            if (entry.size != textureLevelSize(format(), entry.width, entry.height)) return false;
+            if (entry.offset > file.size() || entry.size > file.size() - entry.offset) return false;
+            levels.push_back({ entry.width, entry.height, file.data() + entry.offset, static_cast<size_t>(entry.size) });
+        }
+        return true;
+    }
+};
+
+// Write levels (largest first, each already in 'format') as a container
+inline bool writeTextureContainer(const char* path, TextureFormat format, uint32_t width, uint32_t height,
+                                  const std::vector<std::vector<uint8_t>>& levelData, uint64_t checksum = 0) {
+    if (levelData.empty() || levelData.size() > TEXTURE_MAX_LEVELS) {
+        std::cerr << "Texture container needs 1 to " << TEXTURE_MAX_LEVELS << " levels: " << path << std::endl;
+        return false;
+    }
+
+    TextureFileHeader head = {};
+    std::memcpy(head.magic, "TEX1", 4);
+    head.version = TEXTURE_FILE_VERSION;
+    head.format = static_cast<uint32_t>(format);
+    head.width = width;
+    head.height = height;
+    head.levelCount = static_cast<uint32_t>(levelData.size());
+    head.checksum[0] = static_cast<uint32_t>(checksum);
+    head.checksum[1] = static_cast<uint32_t>(checksum >> 32);
+
+    std::vector<TextureFileLevel> table(levelData.size());
+    uint64_t offset = sizeof(TextureFileHeader) + table.size() * sizeof(TextureFileLevel);
+    for (size_t i = 0; i < levelData.size(); ++i) {
+        offset = (offset + 15) & ~uint64_t(15);
+        table[i] = { offset, levelData[i].size(), std::max(1u, width >> i), std::max(1u, height >> i) };
+        if (levelData[i].size() != textureLevelSize(format, table[i].width, table[i].height)) {
+            std::cerr << "Level " << i << " has the wrong size for " << path << std::endl;
+            return false;
+        }
+        offset += levelData[i].size();
+    }
+
+    FILE* out = std::fopen(path, "wb");
+    if (!out) {
+        std::cerr << "Failed to open file for saving: " << path << std::endl;
+        return false;
+    }
+    std::fwrite(&head, sizeof(head), 1, out);
+    std::fwrite(table.data(), sizeof(TextureFileLevel), table.size(), out);
+    long position = static_cast<long>(sizeof(head) + table.size() * sizeof(TextureFileLevel));
+    static const uint8_t zeros[16] = {};
+    for (size_t i = 0; i < levelData.size(); ++i) {
+        std::fwrite(zeros, 1, static_cast<size_t>(table[i].offset - position), out);
+        std::fwrite(levelData[i].data(), 1, levelData[i].size(), out);
+        position = static_cast<long>(table[i].offset + table[i].size);
+    }
+    bool ok = std::ferror(out) == 0;
+    std::fclose(out);
+    return ok;
+}
+
+// The cooked container for a source image: same path with a .tex extension.
+// Empty when there is none or it is older than the source, so stale cooks are ignored.
+inline std::string cookedTexturePath(const char* sourcePath) {
+    std::filesystem::path source(sourcePath);
+    if (source.extension() == ".tex") return sourcePath;
+
+    std::filesystem::path cooked = source;
+    cooked.replace_extension(".tex");
+    std::error_code error;
+    auto cookedTime = std::filesystem::last_write_time(cooked, error);
+    if (error) return std::string();
+    auto sourceTime = std::filesystem::last_write_time(source, error);
+    if (!error && sourceTime > cookedTime) return std::string();
+    return cooked.string();
+}
+
+#endif  // TEXTURE_CONTAINER_H
@@ -0,0 +1,184 @@
+#ifndef TEXTURE_COOK_H
+#define TEXTURE_COOK_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "image.h"
+#include "image_kernels.h"
+#include "texture_container.h"
+
+// Offline steps that turn a decoded image into container levels: the mip
+// chain, and BC1 block compression for formats that want it.
+
+// Half-size level by averaging 2x2 texels. An odd last row or column is dropped;
+// a side only one texel long is clamped instead. See downsampleBox2x.
+inline Image downsampleBox(const Image& source) {
+    Image result(std::max(1, source.width / 2), std::max(1, source.height / 2));
+    downsampleBox2x(source.pixels.data(), source.width, source.height, result.pixels.data());
+    return result;
+}
+
+// How mip levels are filtered from the one above
+struct MipOptions {
+    ResampleFilter filter = ResampleFilter::Box;
+    bool srgb = false;  // Colour is sRGB-encoded: filter it in linear light
+};
+
+// Level 0 followed by every smaller level down to 1x1, the chain glGenerateMipmap would build
+inline std::vector<Image> buildMipChain(const Image& base, bool withMips = true, const MipOptions& options = MipOptions(),
+                                        ThreadPool* pool = nullptr) {
+    std::vector<Image> levels;
+    levels.push_back(base);
+    ResizeScratch scratch;
+    while (withMips && (levels.back().width > 1 || levels.back().height > 1) && levels.size() < TEXTURE_MAX_LEVELS) {
+        const Image& above = levels.back();
+        Image level(std::max(1, above.width / 2), std::max(1, above.height / 2));
+        downsampleLevel(above.pixels.data(), above.width, above.height, level.pixels.data(), options.filter, options.srgb,
+                        pool, &scratch);
+        levels.push_back(std::move(level));
+    }
+    return levels;
+}
+
+namespace BC1 {
+    inline uint16_t pack565(const unsigned char* color) {
+        return static_cast<uint16_t>(((color[0] * 31 + 127) / 255) << 11 | ((color[1] * 63 + 127) / 255) << 5 | ((color[2] * 31 + 127) / 255));
+    }
+
+    inline void unpack565(uint16_t packed, unsigned char* color) {
+        int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+        color[0] = static_cast<unsigned char>((r << 3) | (r >> 2));
+        color[1] = static_cast<unsigned char>((g << 2) | (g >> 4));
+        color[2] = static_cast<unsigned char>((b << 3) | (b >> 2));
+        color[3] = 255;
+    }
+
+    // The four (or three plus transparent) colours a block's endpoints select between
+    inline void palette(uint16_t color0, uint16_t color1, unsigned char out[4][4]) {
+        unpack565(color0, out[0]);
+        unpack565(color1, out[1]);
+        for (int channel = 0; channel < 3; ++channel) {
+            if (color0 > color1) {
+                out[2][channel] = static_cast<unsigned char>((2 * out[0][channel] + out[1][channel] + 1) / 3);
+                out[3][channel] = static_cast<unsigned char>((out[0][channel] + 2 * out[1][channel] + 1) / 3);
+            } else {
+                out[2][channel] = static_cast<unsigned char>((out[0][channel] + out[1][channel] + 1) / 2);
+                out[3][channel] = 0;
+            }
+        }
+        out[2][3] = 255;
+        out[3][3] = color0 > color1 ? 255 : 0;
+    }
+
+    // Endpoints from the block's bounding box, inset a little so the palette covers the bulk of
+    // the colours rather than the extremes. Blocks with cut-out texels use the three-colour mode.
+    inline void encodeBlock(const unsigned char texels[16][4], uint8_t* out) {
+        unsigned char low[3] = { 255, 255, 255 }, high[3] = { 0, 0, 0 };
+        bool transparent = false;
+        for (int i = 0; i < 16; ++i) {
+            if (texels[i][3] < 128) {
+                transparent = true;
+                continue;
+            }
+            for (int channel = 0; channel < 3; ++channel) {
+                low[channel] = std::min(low[channel], texels[i][channel]);
+                high[channel] = std::max(high[channel], texels[i][channel]);
+            }
+        }
+        if (low[0] > high[0]) {  // Fully transparent block
+            std::memset(low, 0, 3);
+            std::memset(high, 0, 3);
+        }
+        for (int channel = 0; channel < 3; ++channel) {
+            int inset = (high[channel] - low[channel]) / 16;
+            low[channel] = static_cast<unsigned char>(low[channel] + inset);
+            high[channel] = static_cast<unsigned char>(high[channel] - inset);
+        }
+
+        // high >= low in every channel, so color0 >= color1: the four-colour mode unless swapped.
+        // Equal endpoints decode as three colours, which is still exact for index 0.
+        uint16_t color0 = pack565(high), color1 = pack565(low);
+        if (transparent) std::swap(color0, color1);
+        int candidates = color0 > color1 ? 4 : 3;
+
+        unsigned char colors[4][4];
+        palette(color0, color1, colors);
+        uint32_t indices = 0;
+        for (int i = 0; i < 16; ++i) {
+            int best = 0;
+            if (transparent && texels[i][3] < 128) {
+                best = 3;
+            } else {
+                int bestDistance = 1 << 30;
+                for (int candidate = 0; candidate < candidates; ++candidate) {
+                    int dr = texels[i][0] - colors[candidate][0];
+                    int dg = texels[i][1] - colors[candidate][1];
+                    int db = texels[i][2] - colors[candidate][2];
+                    int distance = dr * dr + dg * dg + db * db;
+                    if (distance < bestDistance) {
+                        bestDistance = distance;
+                        best = candidate;
+                    }
+                }
+            }
+            indices |= static_cast<uint32_t>(best) << (i * 2);
+        }
+
+        out[0] = color0 & 0xFF;
+        out[1] = color0 >> 8;
+        out[2] = color1 & 0xFF;
+        out[3] = color1 >> 8;
+        for (int i = 0; i < 4; ++i) out[4 + i] = static_cast<uint8_t>(indices >> (i * 8));
+    }
+}
+
+// Compress an RGBA8 image; blocks hanging over the edge repeat the last row and column
+inline std::vector<uint8_t> encodeBC1(const Image& image) {
+    int blocksX = (image.width + 3) / 4, blocksY = (image.height + 3) / 4;
+    std::vector<uint8_t> out(static_cast<size_t>(blocksX) * blocksY * 8);
+    unsigned char texels[16][4];
+    for (int by = 0; by < blocksY; ++by) {
+        for (int bx = 0; bx < blocksX; ++bx) {
+            for (int i = 0; i < 16; ++i) {
+                int x = std::min(bx * 4 + (i & 3), image.width - 1), y = std::min(by * 4 + (i >> 2), image.height - 1);
+                std::memcpy(texels[i], image.pixel(x, y), 4);
+            }
+            BC1::encodeBlock(texels, &out[(static_cast<size_t>(by) * blocksX + bx) * 8]);
+        }
+    }
+    return out;
+}
+
+// Expand BC1 data back to RGBA8, for GL drivers without S3TC and for the software rasterizer
+inline void decodeBC1(const uint8_t* blocks, int width, int height, Image& out) {
+    out = Image(width, height);
+    int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    for (int by = 0; by < blocksY; ++by) {
+        for (int bx = 0; bx < blocksX; ++bx) {
+            const uint8_t* block = blocks + (static_cast<size_t>(by) * blocksX + bx) * 8;
+            unsigned char colors[4][4];
+            BC1::palette(static_cast<uint16_t>(block[0] | block[1] << 8), static_cast<uint16_t>(block[2] | block[3] << 8), colors);
+            uint32_t indices = block[4] | block[5] << 8 | block[6] << 16 | static_cast<uint32_t>(block[7]) << 24;
+            for (int i = 0; i < 16; ++i) {
+                int x = bx * 4 + (i & 3), y = by * 4 + (i >> 2);
+                if (x < width && y < height) std::memcpy(out.pixel(x, y), colors[(indices >> (i * 2)) & 3], 4);
+            }
+        }
+    }
+}
+
+// A container level as RGBA8, decoding BC1 when needed
+inline void decodeTextureLevel(const TextureContainer& container, uint32_t index, Image& out) {
+    const TextureLevel& level = container.level(index);
+    if (container.format() == TextureFormat::BC1) {
+        decodeBC1(level.data, static_cast<int>(level.width), static_cast<int>(level.height), out);
+        return;
+    }
+    out.width = static_cast<int>(level.width);
+    out.height = static_cast<int>(level.height);
+    out.pixels.assign(level.data, level.data + level.size);
+}
+
+#endif  // TEXTURE_COOK_H
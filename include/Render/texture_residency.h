@@ -0,0 +1,195 @@
+#ifndef TEXTURE_RESIDENCY_H
+#define TEXTURE_RESIDENCY_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Finest mip level worth keeping for a texture whose larger side covers 'screenPixels'
+// on screen: the smallest level that still has at least one texel per pixel
+inline uint32_t requiredMipLevel(uint32_t width, uint32_t height, float screenPixels) {
+    float texels = static_cast<float>(std::max(width, height));
+    if (!(screenPixels > 0.0f) || texels <= screenPixels) return 0;
+    return static_cast<uint32_t>(std::floor(std::log2(texels / screenPixels)));
+}
+
+struct StreamedLevel {
+    uint32_t width, height;
+    size_t bytes;
+};
+
+// Levels [first, end) of a texture, to load or to release
+struct LevelRange {
+    uint32_t texture;
+    uint32_t first, end;
+};
+
+// Which mip levels of every streamed texture should be resident; no GL, so it
+// can be driven by a simulation as easily as by TextureStreamer. Each texture
+// keeps a contiguous run of levels from 'base' down to 1x1. The small levels
+// (at most tailSize texels across) load when the texture is added and stay;
+// finer ones load when use() asks for them and go again, least recently used
+// texture first, whenever a load would take memory past the budget.
+class TextureResidency {
+public:
+    size_t budgetBytes;
+    uint32_t tailSize = 32;
+
+    explicit TextureResidency(size_t budget) : budgetBytes(budget) {}
+
+    uint32_t add(std::vector<StreamedLevel> levels) {
+        Texture texture;
+        texture.levels = std::move(levels);
+        uint32_t count = static_cast<uint32_t>(texture.levels.size());
+        texture.tail = count - 1;
+        for (uint32_t i = 0; i < count; ++i) {
+            if (std::max(texture.levels[i].width, texture.levels[i].height) <= tailSize) {
+                texture.tail = i;
+                break;
+            }
+        }
+        texture.base = texture.pending = texture.wanted = count;
+        textures.push_back(std::move(texture));
+        added.push_back(static_cast<uint32_t>(textures.size()) - 1);
+        return static_cast<uint32_t>(textures.size()) - 1;
+    }
+
+    // Record that a texture is drawn this frame with its larger side 'screenPixels' across
+    void use(uint32_t id, float screenPixels) {
+        Texture& texture = textures[id];
+        const StreamedLevel& top = texture.levels[0];
+        uint32_t level = std::min(requiredMipLevel(top.width, top.height, screenPixels), texture.tail);
+        if (texture.lastUsed != frame) {
+            texture.lastUsed = frame;
+            texture.wanted = level;
+            used.push_back(id);
+        } else {
+            texture.wanted = std::min(texture.wanted, level);
+        }
+    }
+
+    // Once per frame after every use(): the levels to start loading and the ones to
+    // release so that resident plus in-flight bytes stay within the budget
+    void plan(std::vector<LevelRange>& loads, std::vector<LevelRange>& drops) {
+        loads.clear();
+        drops.clear();
+        victims.clear();
+        victimsBuilt = false;
+        nextVictim = 0;
+
+        // Tails are not optional; they are what a texture shows until anything finer arrives
+        for (uint32_t id : added) {
+            Texture& texture = textures[id];
+            if (texture.failed) continue;
+            texture.pending = texture.tail;
+            committed += bytes(texture, texture.tail, texture.base);
+            loads.push_back({ id, texture.tail, texture.base });
+        }
+        added.clear();
+
+        for (uint32_t id : used) {
+            Texture& texture = textures[id];
+            // One load per texture at a time; a texture still loading asks again next frame
+            if (texture.failed || texture.pending < texture.base || texture.wanted >= texture.pending) continue;
+            uint32_t target = texture.wanted;
+            size_t need = bytes(texture, target, texture.pending);
+            while (target < texture.pending && committed + need > budgetBytes) {
+                if (!evictOne(drops)) need -= texture.levels[target++].bytes;  // Settle for a coarser level
+            }
+            if (target == texture.pending) continue;
+            loads.push_back({ id, target, texture.pending });
+            committed += need;
+            texture.pending = target;
+        }
+        used.clear();
+
+        // The budget may have been lowered
+        while (committed > budgetBytes && evictOne(drops)) {}
+        ++frame;
+    }
+
+    // The levels requested for a texture are all uploaded
+    void loaded(uint32_t id) {
+        Texture& texture = textures[id];
+        resident += bytes(texture, texture.pending, texture.base);
+        texture.base = texture.pending;
+    }
+
+    // A texture could not be read; it keeps what it has and is never loaded again
+    void failed(uint32_t id) {
+        Texture& texture = textures[id];
+        committed -= bytes(texture, texture.pending, texture.base);
+        texture.pending = texture.base;
+        texture.failed = true;
+    }
+
+    uint32_t baseLevel(uint32_t id) const { return textures[id].base; }
+    size_t residentBytes() const { return resident; }
+    size_t committedBytes() const { return committed; }  // Resident plus in flight
+    size_t size() const { return textures.size(); }
+
+private:
+    struct Texture {
+        std::vector<StreamedLevel> levels;
+        uint32_t tail = 0;      // First level that is always resident
+        uint32_t base = 0;      // Finest resident level; levels.size() when none
+        uint32_t pending = 0;   // Finest level resident or loading
+        uint32_t wanted = 0;    // Finest level use() asked for this frame
+        uint64_t lastUsed = 0;
+        bool failed = false;
+    };
+
+    std::vector<Texture> textures;
+    std::vector<uint32_t> added;
+    std::vector<uint32_t> used;
+    std::vector<uint32_t> victims;
+    bool victimsBuilt = false;
+    size_t nextVictim = 0;
+    uint64_t frame = 1;
+    size_t resident = 0;
+    size_t committed = 0;
+
+    static size_t bytes(const Texture& texture, uint32_t first, uint32_t end) {
+        size_t total = 0;
+        for (uint32_t i = first; i < end; ++i) total += texture.levels[i].bytes;
+        return total;
+    }
+
+    // Finest level a texture may keep: what it asked for this frame, otherwise just its tail
+    uint32_t keepLevel(const Texture& texture) const {
+        return texture.lastUsed == frame ? texture.wanted : texture.tail;
+    }
+
+    // Release the finest level of the least recently used texture holding more than it
+    // needs. Textures with a load in flight are left alone until it lands.
+    bool evictOne(std::vector<LevelRange>& drops) {
+        if (!victimsBuilt) {
+            for (uint32_t id = 0; id < textures.size(); ++id) {
+                const Texture& texture = textures[id];
+                if (texture.pending == texture.base && texture.base < keepLevel(texture)) victims.push_back(id);
+            }
+            std::sort(victims.begin(), victims.end(),
+                      [this](uint32_t a, uint32_t b) { return textures[a].lastUsed < textures[b].lastUsed; });
+            victimsBuilt = true;
+        }
+        while (nextVictim < victims.size()) {
+            uint32_t id = victims[nextVictim];
+            Texture& texture = textures[id];
+            if (texture.pending != texture.base || texture.base >= keepLevel(texture)) {
+                ++nextVictim;
+                continue;
+            }
+            size_t levelBytes = texture.levels[texture.base].bytes;
+            resident -= levelBytes;
+            committed -= levelBytes;
+            if (!drops.empty() && drops.back().texture == id && drops.back().end == texture.base) ++drops.back().end;
+            else drops.push_back({ id, texture.base, texture.base + 1 });
+            texture.pending = ++texture.base;
+            return true;
+        }
+        return false;
+    }
+};
+
+#endif  // TEXTURE_RESIDENCY_H
@@ -0,0 +1,282 @@
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "gl_state.h"
+#include "image.h"
+#include "image_cache.h"
+#include "render_queue.h"
+#include "texture_container.h"
+#include "texture_cook.h"
+#include "texture_residency.h"
+#include "texture_upload.h"
+#include "thread_pool.h"
+
+// Counters for TextureStreamer; upload figures are for the last update()
+struct TextureStreamStats {
+    size_t textures = 0;
+    size_t residentBytes = 0;
+    size_t committedBytes = 0;  // Resident plus loading
+    size_t budgetBytes = 0;
+    size_t loading = 0;         // Level loads on the workers or waiting to upload
+    size_t uploadedBytes = 0;
+    size_t levelsLoaded = 0;
+    size_t levelsDropped = 0;
+};
+
+// Streams mip levels of large texture sets against a memory budget. add()
+// returns an id whose texture holds a placeholder until the small levels
+// arrive; each frame, use() reports how large a texture is on screen, and
+// update() loads the finer levels that calls for on the workers and releases
+// the least recently used ones, following TextureResidency.
+// Released levels are respecified as 0x0 and GL_TEXTURE_BASE_LEVEL moves past
+// them, so the texture name never changes and sampling stays complete.
+// Only the levels asked for are copied out of a cooked .tex or, for plain
+// images, out of the image cache entry the first load decodes them into.
+class TextureStreamer {
+public:
+    TextureResidency residency;
+    size_t uploadBudget = 4 << 20;  // Bytes per update(); at least one level always goes up
+    glm::vec4 placeholderColor = glm::vec4(0.5f, 0.5f, 0.5f, 1.0f);
+
+    explicit TextureStreamer(ThreadPool& workerPool, size_t budgetBytes = size_t(64) << 20)
+        : residency(budgetBytes), pool(workerPool), shared(std::make_shared<Shared>()) {
+        compressedUploads = supportsS3TC();
+    }
+
+    ~TextureStreamer() {
+        for (const Source& source : sources) glState().deleteTexture(source.texture);
+    }
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    // An unreadable file keeps the placeholder for good
+    uint32_t add(const char* path) {
+        Source source;
+        source.path = path;
+        std::vector<StreamedLevel> levels = describe(source);
+        bool readable = !levels.empty();
+        if (!readable) levels.push_back({ 1, 1, 4 });
+
+        glGenTextures(1, &source.texture);
+        glState().bindTexture(0, source.texture);
+        GLint last = static_cast<GLint>(levels.size()) - 1;
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, last > 0 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, last);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, last);
+        // Uncompressed and the size of the last level; the tail load replaces it
+        const StreamedLevel& smallest = levels.back();
+        std::vector<uint32_t> placeholder(static_cast<size_t>(smallest.width) * smallest.height, packColor(placeholderColor));
+        glTexImage2D(GL_TEXTURE_2D, last, GL_RGBA8, smallest.width, smallest.height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                     placeholder.data());
+        glState().countIssued(7);
+
+        sources.push_back(std::move(source));
+        uint32_t id = residency.add(std::move(levels));
+        if (!readable) residency.failed(id);
+        return id;
+    }
+
+    GLuint texture(uint32_t id) const { return sources[id].texture; }
+
+    void use(uint32_t id, float screenPixels) { residency.use(id, screenPixels); }
+
+    // Once per frame on the GL thread, after every use(): release, request and
+    // upload levels. Returns how many textures changed what they sample.
+    size_t update() {
+        residency.plan(loads, drops);
+        size_t changed = 0;
+
+        for (const LevelRange& drop : drops) {
+            glState().bindTexture(0, sources[drop.texture].texture);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(drop.end));
+            for (uint32_t level = drop.first; level < drop.end; ++level) {
+                glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), GL_RGBA8, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            }
+            glState().countIssued(1 + drop.end - drop.first);
+            stats.levelsDropped += drop.end - drop.first;
+            ++changed;
+        }
+
+        for (const LevelRange& load : loads) {
+            std::shared_ptr<Shared> state = shared;
+            const Source& source = sources[load.texture];
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                ++state->decoding;
+            }
+            pool.submit([state, path = source.path, cooked = source.cooked, compressed = source.compressed, load] {
+                auto job = std::make_unique<Job>();
+                job->range = load;
+                job->ok = decode(path, cooked, compressed, *job);
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->ready.push_back(std::move(job));
+                --state->decoding;
+            });
+        }
+
+        // Coarse levels first, each one exposed as it lands, so detail sharpens progressively
+        size_t spent = 0;
+        while (spent < uploadBudget) {
+            if (!current) {
+                std::lock_guard<std::mutex> lock(shared->mutex);
+                if (shared->ready.empty()) break;
+                current = std::move(shared->ready.front());
+                shared->ready.pop_front();
+            }
+            if (!current->ok) {
+                residency.failed(current->range.texture);
+                current.reset();
+                continue;
+            }
+            spent += uploadLevel(*current);
+            if (current->next == current->range.first) {
+                residency.loaded(current->range.texture);
+                ++changed;
+                current.reset();
+            }
+        }
+
+        stats.textures = sources.size();
+        stats.residentBytes = residency.residentBytes();
+        stats.committedBytes = residency.committedBytes();
+        stats.budgetBytes = residency.budgetBytes;
+        stats.uploadedBytes = spent;
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        stats.loading = shared->decoding + shared->ready.size() + (current ? 1 : 0);
+        return changed;
+    }
+
+    const TextureStreamStats& lastStats() const { return stats; }
+
+private:
+    struct Source {
+        GLuint texture = 0;
+        std::string path;
+        std::string cooked;       // Up-to-date .tex next to the image, if any
+        bool compressed = false;  // BC1 levels uploaded as is
+    };
+    // Levels of one load, decoded on a worker
+    struct Job {
+        LevelRange range;
+        bool ok = false;
+        std::vector<StreamedLevel> sizes;         // Indexed from range.first
+        std::vector<std::vector<uint8_t>> data;
+        uint32_t next = 0;                        // One past the next level to upload
+    };
+    struct Shared {
+        std::mutex mutex;
+        std::deque<std::unique_ptr<Job>> ready;
+        size_t decoding = 0;
+    };
+
+    ThreadPool& pool;
+    std::shared_ptr<Shared> shared;
+    std::vector<Source> sources;
+    std::vector<LevelRange> loads, drops;
+    std::unique_ptr<Job> current;
+    bool compressedUploads = false;
+    TextureStreamStats stats;
+
+    // Level sizes without decoding: the container's table, or the chain buildMipChain would make
+    std::vector<StreamedLevel> describe(Source& source) const {
+        std::vector<StreamedLevel> levels;
+        source.cooked = cookedTexturePath(source.path.c_str());
+        TextureContainer container;
+        if (!source.cooked.empty() && container.open(source.cooked.c_str())) {
+            source.compressed = container.format() == TextureFormat::BC1 && compressedUploads;
+            for (uint32_t i = 0; i < container.levelCount(); ++i) {
+                const TextureLevel& level = container.level(i);
+                levels.push_back({ level.width, level.height, source.compressed ? level.size : size_t(level.width) * level.height * 4 });
+            }
+            return levels;
+        }
+        source.cooked.clear();
+
+        int width, height, channels;
+        if (!stbi_info(source.path.c_str(), &width, &height, &channels)) {
+            std::cerr << "Failed to read texture: " << source.path << std::endl;
+            return levels;
+        }
+        uint32_t w = static_cast<uint32_t>(width), h = static_cast<uint32_t>(height);
+        levels.push_back({ w, h, size_t(w) * h * 4 });
+        while ((w > 1 || h > 1) && levels.size() < TEXTURE_MAX_LEVELS) {
+            w = std::max(1u, w / 2);
+            h = std::max(1u, h / 2);
+            levels.push_back({ w, h, size_t(w) * h * 4 });
+        }
+        return levels;
+    }
+
+    // Worker side: copy the levels out of the cooked container or the image cache entry,
+    // or decode the image and build its chain when neither can be had
+    static bool decode(const std::string& path, const std::string& cooked, bool compressed, Job& job) {
+        const LevelRange& range = job.range;
+        job.next = range.end;
+        TextureContainer container;
+        bool mapped = cooked.empty() ? imageCache().load(path.c_str(), ImageDecodeOptions(), container) : container.open(cooked.c_str());
+        if (!mapped && !cooked.empty()) return false;
+        if (mapped) {
+            if (container.levelCount() < range.end) return false;
+            for (uint32_t i = range.first; i < range.end; ++i) {
+                const TextureLevel& level = container.level(i);
+                job.sizes.push_back({ level.width, level.height, level.size });
+                if (container.format() == TextureFormat::BC1 && !compressed) {
+                    Image decoded;
+                    decodeTextureLevel(container, i, decoded);
+                    job.sizes.back().bytes = decoded.pixels.size();
+                    job.data.push_back(std::move(decoded.pixels));
+                } else {
+                    job.data.emplace_back(level.data, level.data + level.size);
+                }
+            }
+            return true;
+        }
+
+        Image image;
+        if (!loadImageThreadSafe(path.c_str(), image)) return false;
+        std::vector<Image> chain = buildMipChain(image);
+        if (chain.size() < range.end) return false;
+        for (uint32_t i = range.first; i < range.end; ++i) {
+            job.sizes.push_back({ static_cast<uint32_t>(chain[i].width), static_cast<uint32_t>(chain[i].height), chain[i].pixels.size() });
+            job.data.push_back(std::move(chain[i].pixels));
+        }
+        return true;
+    }
+
+    // GL side: upload the next (coarsest remaining) level and sample from it; returns its bytes
+    size_t uploadLevel(Job& job) {
+        uint32_t level = --job.next;
+        const Source& source = sources[job.range.texture];
+        const StreamedLevel& size = job.sizes[level - job.range.first];
+        std::vector<uint8_t> data = std::move(job.data[level - job.range.first]);
+        GLsizei width = static_cast<GLsizei>(size.width), height = static_cast<GLsizei>(size.height);
+
+        glState().bindTexture(0, source.texture);
+        if (source.compressed) {
+            glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, width, height, 0,
+                                   static_cast<GLsizei>(data.size()), data.data());
+        } else {
+            glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data.data());
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(level));
+        glState().countIssued(2);
+        ++stats.levelsLoaded;
+        return data.size();
+    }
+};
+
+#endif  // TEXTURE_STREAMER_H
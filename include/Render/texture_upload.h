@@ -0,0 +1,72 @@
+#ifndef TEXTURE_UPLOAD_H
+#define TEXTURE_UPLOAD_H
+
+#include <glad/glad.h>
+#include <cstring>
+#include "gl_state.h"
+#include "image.h"
+#include "texture_container.h"
+#include "texture_cook.h"
+
+// S3TC is an extension rather than core 3.3, so the loader headers do not define it
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+
+// Whether the context takes BC1 data as is; checked once per process
+inline bool supportsS3TC() {
+    static const bool supported = [] {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; ++i) {
+            const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+            if (name && std::strcmp(name, "GL_EXT_texture_compression_s3tc") == 0) return true;
+        }
+        return false;
+    }();
+    return supported;
+}
+
+// Create a texture from a cooked container: every level goes up exactly as
+// stored, with no decode and no glGenerateMipmap. BC1 is decoded to RGBA8
+// only when the driver cannot take it. Same wrap and filtering as
+// MathUtils::loadTexture, with trilinear minification once there are mips.
+inline GLuint uploadTextureContainer(const TextureContainer& container) {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glState().bindTexture(0, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, container.levelCount() > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(container.levelCount()) - 1);
+
+    bool compressed = container.format() == TextureFormat::BC1;
+    Image decoded;
+    for (uint32_t i = 0; i < container.levelCount(); ++i) {
+        const TextureLevel& level = container.level(i);
+        GLsizei width = static_cast<GLsizei>(level.width), height = static_cast<GLsizei>(level.height);
+        if (compressed && supportsS3TC()) {
+            glCompressedTexImage2D(GL_TEXTURE_2D, i, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, width, height, 0,
+                                   static_cast<GLsizei>(level.size), level.data);
+        } else if (compressed) {
+            decodeTextureLevel(container, i, decoded);
+            glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, decoded.pixels.data());
+        } else {
+            glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, level.data);
+        }
+    }
+    glState().countIssued(5 + container.levelCount());
+    return texture;
+}
+
+// The cooked .tex next to 'path' when there is an up-to-date one; 0 otherwise, so callers fall back to decoding
+inline GLuint loadCookedTexture(const char* path) {
+    std::string cooked = cookedTexturePath(path);
+    if (cooked.empty()) return 0;
+    TextureContainer container;
+    if (!container.open(cooked.c_str())) return 0;
+    return uploadTextureContainer(container);
+}
+
+#endif  // TEXTURE_UPLOAD_H
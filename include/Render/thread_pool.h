@@ -0,0 +1,154 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed set of worker threads for CPU-side frame work (culling, list building,
+// vertex generation) and background jobs (decoding). GL calls never run here.
+class ThreadPool {
+public:
+    // 0 = one worker per hardware thread, minus the caller's
+    explicit ThreadPool(unsigned workers = 0) {
+        if (workers == 0) {
+            unsigned hardware = std::thread::hardware_concurrency();
+            workers = hardware > 1 ? hardware - 1 : 0;
+        }
+        for (unsigned i = 0; i < workers; ++i) {
+            threads.emplace_back([this, i] { workerLoop(i + 1); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& thread : threads) thread.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Workers plus the calling thread; the range of 'threadIndex' in parallelFor
+    unsigned threadCount() const { return static_cast<unsigned>(threads.size()) + 1; }
+
+    // Run fn(begin, end, threadIndex) over [0, count) in chunks of 'grain'. The caller
+    // takes part and the call returns when every chunk is done. Caller's index is 0.
+    // Must only be called from one thread at a time (the frame thread).
+    template <typename Fn>
+    void parallelFor(size_t count, size_t grain, Fn&& fn) {
+        if (count == 0) return;
+        grain = std::max<size_t>(grain, 1);
+        if (threads.empty() || count <= grain) {
+            fn(size_t(0), count, 0u);
+            return;
+        }
+
+        ForJob job;
+        job.count = count;
+        job.grain = grain;
+        job.context = &fn;
+        job.invoke = [](void* context, size_t begin, size_t end, unsigned threadIndex) {
+            (*static_cast<std::remove_reference_t<Fn>*>(context))(begin, end, threadIndex);
+        };
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            currentJob = &job;
+            ++jobGeneration;
+        }
+        wake.notify_all();
+
+        runChunks(job, 0);
+
+        // Wait until no worker is still inside this job before it goes out of scope
+        std::unique_lock<std::mutex> lock(mutex);
+        currentJob = nullptr;
+        done.wait(lock, [&] { return job.active == 0; });
+    }
+
+    // Queue a background task; it runs on some worker (or inline when there are none)
+    void submit(std::function<void()> task) {
+        if (threads.empty()) {
+            task();
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_back(std::move(task));
+        }
+        wake.notify_one();
+    }
+
+private:
+    struct ForJob {
+        size_t count = 0;
+        size_t grain = 1;
+        std::atomic<size_t> next{ 0 };
+        int active = 0;  // Workers currently inside, guarded by the pool mutex
+        void* context = nullptr;
+        void (*invoke)(void*, size_t, size_t, unsigned) = nullptr;
+    };
+
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::deque<std::function<void()>> tasks;
+    ForJob* currentJob = nullptr;
+    unsigned long long jobGeneration = 0;
+    bool stopping = false;
+
+    static void runChunks(ForJob& job, unsigned threadIndex) {
+        for (;;) {
+            size_t begin = job.next.fetch_add(job.grain);
+            if (begin >= job.count) break;
+            size_t end = std::min(begin + job.grain, job.count);
+            job.invoke(job.context, begin, end, threadIndex);
+        }
+    }
+
+    void workerLoop(unsigned threadIndex) {
+        unsigned long long seenGeneration = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            wake.wait(lock, [&] {
+                return stopping || !tasks.empty() || (currentJob && jobGeneration != seenGeneration);
+            });
+
+            // Frame work first: the frame thread is blocked on it
+            if (currentJob && jobGeneration != seenGeneration) {
+                seenGeneration = jobGeneration;
+                ForJob* job = currentJob;
+                ++job->active;
+                lock.unlock();
+                runChunks(*job, threadIndex);
+                lock.lock();
+                if (--job->active == 0) done.notify_all();
+                continue;
+            }
+
+            if (!tasks.empty()) {
+                std::function<void()> task = std::move(tasks.front());
+                tasks.pop_front();
+                lock.unlock();
+                task();
+                lock.lock();
+                continue;
+            }
+
+            if (stopping) return;
+        }
+    }
+};
+
+#endif  // THREAD_POOL_H
@@ -0,0 +1,148 @@
+#ifndef TILED_LIGHTS_H
+#define TILED_LIGHTS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "gl_state.h"
+#include "light_binning.h"
+#include "light_visibility.h"
+#include "shader.h"
+
+constexpr const char* TILED_LIGHTS_VERTEX_SHADER = R"(
+    #version 330 core
+    void main() {
+        vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+        gl_Position = vec4(corner * 4.0 - 1.0, 0.0, 1.0);
+    }
+)";
+
+// Each pixel walks only its tile's list: offsets first in 'lightList', then
+// indices into 'lightData' (two texels per light: position and radius, colour)
+constexpr const char* TILED_LIGHTS_FRAGMENT_SHADER = R"(
+    #version 330 core
+    out vec4 FragColor;
+
+    uniform usamplerBuffer lightList;
+    uniform samplerBuffer lightData;
+    uniform int tileSize;
+    uniform int tileColumns;
+    uniform int tileCount;
+    uniform vec2 viewportSize;
+    uniform mat4 inverseViewProjection;
+
+    void main() {
+        ivec2 tile = ivec2(gl_FragCoord.xy) / tileSize;
+        int index = tile.y * tileColumns + tile.x;
+        int begin = int(texelFetch(lightList, index).r);
+        int end = int(texelFetch(lightList, index + 1).r);
+
+        vec2 ndc = gl_FragCoord.xy / viewportSize * 2.0 - 1.0;
+        vec2 world = (inverseViewProjection * vec4(ndc, 0.0, 1.0)).xy;
+        vec3 light = vec3(0.0);
+        for (int i = begin; i < end; ++i) {
+            int id = int(texelFetch(lightList, tileCount + 1 + i).r);
+            vec4 shape = texelFetch(lightData, id * 2);
+            vec3 color = texelFetch(lightData, id * 2 + 1).rgb;
+            float falloff = max(1.0 - length(world - shape.xy) / shape.z, 0.0);
+            light += color * falloff * falloff;
+        }
+        FragColor = vec4(light, 1.0);
+    }
+)";
+
+// Many small lights that do not cast shadows, shaded in one fullscreen pass
+// over tiles binned on the CPU. Cost per pixel is the lights in its tile
+// rather than all of them. Adds into whatever is bound, normally the LightMap.
+class TiledLightRenderer {
+public:
+    LightTileBinner binner;
+
+    TiledLightRenderer() : shader(TILED_LIGHTS_VERTEX_SHADER, TILED_LIGHTS_FRAGMENT_SHADER) {
+        lightListLocation = shader.uniform("lightList");
+        lightDataLocation = shader.uniform("lightData");
+        tileSizeLocation = shader.uniform("tileSize");
+        tileColumnsLocation = shader.uniform("tileColumns");
+        tileCountLocation = shader.uniform("tileCount");
+        viewportSizeLocation = shader.uniform("viewportSize");
+        inverseViewProjectionLocation = shader.uniform("inverseViewProjection");
+
+        glGenVertexArrays(1, &vao);
+        glGenBuffers(1, &listBuffer);
+        glGenBuffers(1, &dataBuffer);
+        glGenTextures(1, &listTexture);
+        glGenTextures(1, &dataTexture);
+        glState().bindBuffer(GL_TEXTURE_BUFFER, listBuffer);
+        glState().bindTexture(LIST_UNIT, listTexture, GL_TEXTURE_BUFFER);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, listBuffer);
+        glState().bindBuffer(GL_TEXTURE_BUFFER, dataBuffer);
+        glState().bindTexture(DATA_UNIT, dataTexture, GL_TEXTURE_BUFFER);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, dataBuffer);
+        glState().countIssued(2);
+    }
+
+    ~TiledLightRenderer() {
+        glState().deleteVertexArray(vao);
+        glState().deleteTexture(listTexture);
+        glState().deleteTexture(dataTexture);
+        glState().deleteBuffer(listBuffer);
+        glState().deleteBuffer(dataBuffer);
+    }
+
+    TiledLightRenderer(const TiledLightRenderer&) = delete;
+    TiledLightRenderer& operator=(const TiledLightRenderer&) = delete;
+
+    // Bin the lights for a width x height target seen through viewProjection
+    // and add them into the bound framebuffer. The pool, when given, bins in parallel.
+    void draw(const std::vector<PointLight>& lights, const glm::mat4& viewProjection, int width, int height,
+              ThreadPool* pool = nullptr) {
+        binner.bin(lights.data(), lights.size(), viewProjection, width, height, pool);
+        if (binner.lastStats().indices == 0) return;
+
+        lightData.resize(lights.size() * 2);
+        for (size_t i = 0; i < lights.size(); ++i) {
+            lightData[i * 2] = glm::vec4(lights[i].position, lights[i].radius, 0.0f);
+            lightData[i * 2 + 1] = glm::vec4(glm::vec3(lights[i].color) * lights[i].color.a, 0.0f);
+        }
+        // Orphan and refill; the lists are rebuilt every frame anyway
+        const std::vector<uint32_t>& list = binner.packed();
+        glState().bindBuffer(GL_TEXTURE_BUFFER, listBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, list.size() * sizeof(uint32_t), list.data(), GL_STREAM_DRAW);
+        glState().bindBuffer(GL_TEXTURE_BUFFER, dataBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, lightData.size() * sizeof(glm::vec4), lightData.data(), GL_STREAM_DRAW);
+        glState().countIssued(2);
+
+        shader.use();
+        glState().bindTexture(LIST_UNIT, listTexture, GL_TEXTURE_BUFFER);
+        glState().bindTexture(DATA_UNIT, dataTexture, GL_TEXTURE_BUFFER);
+        Shader::setInt(lightListLocation, LIST_UNIT);
+        Shader::setInt(lightDataLocation, DATA_UNIT);
+        Shader::setInt(tileSizeLocation, binner.tileSize);
+        Shader::setInt(tileColumnsLocation, binner.tileColumns());
+        Shader::setInt(tileCountLocation, static_cast<int>(binner.tileCount()));
+        Shader::setVec2(viewportSizeLocation, glm::vec2(width, height));
+        Shader::setMat4(inverseViewProjectionLocation, glm::inverse(viewProjection));
+        glState().countIssued(7);
+
+        glState().bindVertexArray(vao);
+        glState().setBlend(true);
+        glState().blendFunc(GL_ONE, GL_ONE);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glState().countDrawCall();
+    }
+
+private:
+    static constexpr GLuint LIST_UNIT = 1;
+    static constexpr GLuint DATA_UNIT = 2;
+
+    Shader shader;
+    GLuint vao = 0;
+    GLuint listBuffer = 0, dataBuffer = 0;
+    GLuint listTexture = 0, dataTexture = 0;
+    GLint lightListLocation, lightDataLocation, tileSizeLocation, tileColumnsLocation;
+    GLint tileCountLocation, viewportSizeLocation, inverseViewProjectionLocation;
+    std::vector<glm::vec4> lightData;
+};
+
+#endif  // TILED_LIGHTS_H
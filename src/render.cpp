@@ -6,12 +6,86 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
 #include <iostream>
+#include <memory>
+#include <string>
 #include <Gameplay/character.h>
 #include <Gameplay/camera.h>
 #include <Gameplay/math_utils.h>
 #include <Gameplay/gridEditor.h>
 #include <Gameplay/collision_util.h>
+#include <Render/dynamic_resolution.h>
+#include <Render/frame_readback.h>
+#include <Render/gl_backend.h>
+#include <Render/gl_state.h>
+#include <Render/image.h>
+#include <Render/light_map.h>
+#include <Render/light_visibility.h>
+#include <Render/particle_renderer.h>
+#include <Render/particle_system.h>
+#include <Render/post_process.h>
+#include <Render/render_builder.h>
+#include <Render/render_queue.h>
+#include <Render/render_target.h>
+#include <Render/scroll_cache.h>
+#include <Render/software_rasterizer.h>
+#include <Render/sprite_animation.h>
+#include <Render/sprite_mesh.h>
+#include <Render/text_renderer.h>
+#include <Render/texture_cache.h>
+#include <Render/texture_streamer.h>
+#include <Render/thread_pool.h>
+#include <Render/tiled_lights.h>
+
+// Command-line options; with no flags the game opens its window as before
+struct AppOptions {
+    bool headless = false;
+    bool software = false;    // CPU rasterizer instead of GL, needs no GPU at all
+    int frames = 120;
+    int width = 800;
+    int height = 600;
+    int captureEvery = 1;
+    int tolerance = 2;        // Per-channel difference still accepted against a golden image
+    std::string captureDir;   // frame_NNNNN.png files are written here
+    std::string goldenDir;    // and compared against the same names here
+    std::string mapFile;
+};
+
+static const char* USAGE =
+    "usage: render [--headless] [--software] [--frames N] [--size WxH] [--map file]\n"
+    "              [--capture dir] [--capture-every N] [--golden dir] [--tolerance N]\n";
+
+bool parseOptions(int argc, char** argv, AppOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--headless") options.headless = true;
+        else if (arg == "--software") options.software = options.headless = true;
+        else if (arg == "--frames" && hasValue) options.frames = std::atoi(argv[++i]);
+        else if (arg == "--size" && hasValue && std::sscanf(argv[++i], "%dx%d", &options.width, &options.height) == 2) {}
+        else if (arg == "--map" && hasValue) options.mapFile = argv[++i];
+        else if (arg == "--capture" && hasValue) options.captureDir = argv[++i];
+        else if (arg == "--capture-every" && hasValue) options.captureEvery = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--golden" && hasValue) options.goldenDir = argv[++i];
+        else if (arg == "--tolerance" && hasValue) options.tolerance = std::atoi(argv[++i]);
+        else {
+            std::cerr << "Unknown or incomplete option: " << arg << "\n" << USAGE;
+            return false;
+        }
+    }
+    if (options.width <= 0 || options.height <= 0 || options.frames <= 0) {
+        std::cerr << "Frame count and size must be positive\n" << USAGE;
+        return false;
+    }
+    return true;
+}
 
 // Function to handle input
 enum class AppMode { EDIT, PLAY };
@@ -51,191 +125,536 @@ void processInput(GLFWwindow* window, Character& player, Camera& camera, Editor&
     }
 }
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
-    glViewport(0, 0, width, height);
-}
-
-unsigned int compileShader(unsigned int type, const char* source) {
-    unsigned int id = glCreateShader(type);
-    glShaderSource(id, 1, &source, nullptr);
-    glCompileShader(id);
-
-    int success;
-    glGetShaderiv(id, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        char infoLog[512];
-        glGetShaderInfoLog(id, 512, nullptr, infoLog);
-        std::cout << "ERROR::SHADER::COMPILATION_FAILED\n" << infoLog << std::endl;
+    glState().viewport(0, 0, width, height);
+    // The offscreen world target follows lazily, on the next frame that draws into it
+    if (auto* resolution = static_cast<DynamicResolution*>(glfwGetWindowUserPointer(window))) {
+        resolution->setOutputSize(width, height);
     }
-
-    return id;
 }
 
-unsigned int createShaderProgram(const char* vertexShaderSource, const char* fragmentShaderSource) {
-    unsigned int program = glCreateProgram();
-    unsigned int vs = compileShader(GL_VERTEX_SHADER, vertexShaderSource);
-    unsigned int fs = compileShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
-
-    glAttachShader(program, vs);
-    glAttachShader(program, fs);
-    glLinkProgram(program);
-
-    int success;
-    glGetProgramiv(program, GL_LINK_STATUS, &success);
-    if (!success) {
-        char infoLog[512];
-        glGetProgramInfoLog(program, 512, nullptr, infoLog);
-        std::cout << "ERROR::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
-    }
-
-    glDeleteShader(vs);
-    glDeleteShader(fs);
-
-    return program;
+// Queue everything visible this frame and sort it. Tile columns are split into
+// chunks that the workers cull and submit in parallel.
+void queueScene(RenderQueue& renderQueue, ParallelRenderBuilder& renderBuilder, const Editor& editor,
+                const Character& player, const Camera& camera, uint8_t spriteShaderId) {
+    renderQueue.clear();
+    glm::vec4 viewBounds = camera.getViewBounds();
+    const int columnsPerChunk = 8;
+    size_t chunkCount = (editor.gridWidth + columnsPerChunk - 1) / columnsPerChunk;
+    renderBuilder.build(chunkCount, [&](size_t chunk, RenderQueue& local) {
+        int begin = static_cast<int>(chunk) * columnsPerChunk;
+        editor.submitTiles(local, spriteShaderId, viewBounds, begin, std::min(begin + columnsPerChunk, editor.gridWidth));
+    }, renderQueue);
+    player.submit(renderQueue, spriteShaderId);
+    renderQueue.sort();
 }
 
-int main() {
-    // Initialize GLFW
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    // Create a window
-    GLFWwindow* window = glfwCreateWindow(800, 600, "Character Render", nullptr, nullptr);
-    if (window == nullptr) {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        return -1;
+// Owns every GL resource, so their destructors run while the context is still current
+// The outline of a sprite's visible texels, traced from the level 0 the texture
+// loader uploads: the cooked .tex when there is one, otherwise the image cache entry
+bool traceSpriteOutline(const char* path, SpriteMesh& mesh) {
+    TextureContainer container;
+    std::string cooked = cookedTexturePath(path);
+    if ((cooked.empty() || !container.open(cooked.c_str())) && !imageCache().load(path, ImageDecodeOptions(), container)) {
+        return false;
     }
-    glfwMakeContextCurrent(window);
-
-    // Load OpenGL function pointers using GLAD
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cout << "Failed to initialize GLAD" << std::endl;
-        return -1;
+    if (container.format() == TextureFormat::BC1) {
+        Image decoded;
+        decodeTextureLevel(container, 0, decoded);
+        mesh = buildSpriteMesh(decoded);
+        return true;
     }
+    const TextureLevel& level = container.level(0);
+    int width = static_cast<int>(level.width), height = static_cast<int>(level.height);
+    mesh = buildSpriteMesh(level.data, width, height, { 0, 0, width, height });
+    return true;
+}
 
-    glViewport(0, 0, 800, 600);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-
-    const char* vertexShaderSource = R"(
-        #version 330 core
-        layout (location = 0) in vec2 aPos;
-        layout (location = 1) in vec2 aTexCoord;
-
-        out vec2 TexCoord;
-
-        uniform mat4 model;
-        uniform mat4 projection;
-        uniform mat4 view;
-
-        void main() {
-            gl_Position = projection * view * model * vec4(aPos, 0.0, 1.0);
-            TexCoord = aTexCoord;
-        }
-    )";
-
-    const char* fragmentShaderSource = R"(
-        #version 330 core
-        out vec4 FragColor;
-
-        in vec2 TexCoord;
-        uniform sampler2D texture1;
-
-        void main() {
-            FragColor = texture(texture1, TexCoord);
-        }
-    )";
-
-    unsigned int shaderProgram = createShaderProgram(vertexShaderSource, fragmentShaderSource);
-
-    float vertices[] = {
-        // Positions    // Texture Coords
-        -0.5f, -0.5f,  0.0f, 0.0f,
-         0.5f, -0.5f,  1.0f, 0.0f,
-         0.5f,  0.5f,  1.0f, 1.0f,
-        -0.5f,  0.5f,  0.0f, 1.0f
+void runGame(GLFWwindow* window) {
+    // Workers cull and build command lists and vertices; GL stays on this thread
+    ThreadPool threadPool;
+    ParallelRenderBuilder renderBuilder(threadPool);
+
+    // Sprite program, camera UBO and the triple-buffered vertex stream live in the backend
+    GLRenderBackend backend(&renderBuilder);
+    uint8_t spriteShaderId = backend.spriteShader();
+    GridRenderer gridRenderer;
+    RenderQueue renderQueue;
+    renderQueue.reserve(4096);
+
+    // Tiles only change when edited, so they are drawn through the scrolling cache
+    ScrollCache tileCache;
+    RenderQueue tileQueue;
+    tileQueue.reserve(4096);
+
+    // The world renders below window resolution when frames run over budget
+    DynamicResolution resolution;
+    GpuFrameTimer gpuTimer;
+    int framebufferWidth, framebufferHeight;
+    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+    resolution.setOutputSize(framebufferWidth, framebufferHeight);
+    glfwSetWindowUserPointer(window, &resolution);
+    float gpuMs = 0.0f;  // Timer results arrive a few frames late
+
+    // Textures decode on the workers and stream in over the first frames; until then they show a placeholder.
+    // Saving an image on disk reloads it into the same texture.
+    AsyncTextureLoader textureLoader(threadPool);
+    TextureCache textures(textureLoader);
+    TextureHandle playerTexture = textures.acquire("images/character.jpg");
+    // Tilesets only keep the mip levels the zoom calls for
+    TextureStreamer tilesets(threadPool);
+    uint32_t wallTileset = tilesets.add("images/wall.jpg");
+    Character player(glm::vec2(400.0f, 300.0f), 100.0f, playerTexture.id());
+    // Sprites draw the outline of their visible texels instead of the whole quad.
+    // Once the loader has the texture in, a worker traces the outline from the
+    // same level 0 it uploaded; the player draws the quad until the mesh is
+    // registered. A reload traces it again into the same mesh id. The outline
+    // covers the whole texture, so it is only traced for single-cell sheets.
+    SpriteMeshTable spriteMeshes;
+    backend.setSpriteMeshes(&spriteMeshes);
+    struct TracedMesh {
+        std::atomic<bool> done{ false };
+        bool traced = false;
+        SpriteMesh mesh;
     };
-
-    unsigned int indices[] = {
-        0, 1, 2,
-        2, 3, 0
+    std::shared_ptr<TracedMesh> playerOutline;  // Shared with the worker, which may outlive the frame loop
+    Camera camera(800.0f, 600.0f);
+    Editor editor(40, 30, 20.0f, tilesets.texture(wallTileset));  // 40x30 grid with 20x20 pixel tiles
+    AppMode currentMode = AppMode::PLAY;
+    float lastStatsUpdate = 0.0f;
+
+    // character.jpg is a single cell; a real sheet only changes the layout and cell ranges
+    const SpriteSheet playerSheet{ 1, 1 };
+    ClipLibrary clips;
+    ClipId idleClip = clips.addFromSheet("player_idle", playerSheet, 0, 1, 4.0f);
+    ClipId walkClip = clips.addFromSheet("player_walk", playerSheet, 0, 1, 10.0f);
+    SpriteAnimator animations(clips);
+    uint32_t playerAnimation = animations.add(idleClip);
+
+    // Lights blocked by the walls; a light's visibility is only recomputed when
+    // it moves or an edit lands within its radius. Particles collide with the
+    // same walls as a bitset.
+    WallEdges wallEdges;
+    TileBitset wallBits;
+    LightVisibilityCache lights;
+    LightMap lightMap;
+    auto rebuildWalls = [&] {
+        auto isWall = [&](int i, int j) { return editor.tileMap[i][j] == TileType::WALL; };
+        wallEdges.build(editor.gridWidth, editor.gridHeight, editor.tileSize, isWall);
+        wallBits.build(editor.gridWidth, editor.gridHeight, editor.tileSize, isWall);
     };
+    rebuildWalls();
+    uint32_t playerLight = lights.add({ player.position, 260.0f, glm::vec4(1.0f, 0.9f, 0.7f, 1.0f) });
+    lights.add({ glm::vec2(150.0f, 150.0f), 220.0f, glm::vec4(0.3f, 0.5f, 1.0f, 0.8f) });
+    lights.add({ glm::vec2(650.0f, 450.0f), 220.0f, glm::vec4(1.0f, 0.4f, 0.3f, 0.8f) });
+
+    // Dust behind the player and debris from edits; particles bounce off the walls
+    ParticleSystem particles(1 << 18);
+    ParticleRenderer particleRenderer;
+    particles.walls = &wallBits;
+
+    // Small lights without shadows go through the tiled pass, so their count barely matters
+    TiledLightRenderer tiledLights;
+    std::vector<PointLight> glowLights;
+    for (int i = 0; i < editor.gridWidth; i += 4) {
+        for (int j : { 0, editor.gridHeight - 1 }) {
+            glm::vec2 position = (glm::vec2(i, j) + 0.5f) * editor.tileSize;
+            glowLights.push_back({ position, 60.0f, glm::vec4(1.0f, 0.6f, 0.2f, 0.5f) });
+        }
+    }
 
-    unsigned int VBO, VAO, EBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
-
-    glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+    // Screen effects, off until toggled with keys 1-4; the world only leaves the window for them
+    RenderTargetPool renderTargets;
+    PostProcessChain postProcess(renderTargets);
+    postProcess.grading.contrast = 1.1f;
+    postProcess.grading.saturation = 1.15f;
+    bool* postToggles[] = { &postProcess.grading.enabled, &postProcess.vignette.enabled, &postProcess.bloom.enabled,
+                            &postProcess.crt.enabled };
+    bool postKeysDown[4] = {};
 
-    Character player(glm::vec2(400.0f, 300.0f), 100.0f, "images/character.jpg");
-    Camera camera(800.0f, 600.0f);
-    Editor editor(40, 30, 20.0f);  // 40x30 grid with 20x20 pixel tiles
-    AppMode currentMode = AppMode::PLAY;
+    // Perf HUD and debug labels, drawn at window resolution over everything else
+    TextRenderer text;
+    char hudLine[192];
 
     while (!glfwWindowShouldClose(window)) {
+        auto frameStart = std::chrono::steady_clock::now();
         processInput(window, player, camera, editor, currentMode);
+        for (int i = 0; i < 4; ++i) {  // Toggle on the press, not every frame the key is held
+            bool down = glfwGetKey(window, GLFW_KEY_1 + i) == GLFW_PRESS;
+            if (down && !postKeysDown[i]) *postToggles[i] = !*postToggles[i];
+            postKeysDown[i] = down;
+        }
 
         float currentFrame = glfwGetTime();
         static float lastFrame = 0.0f;
         float deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
         player.update(deltaTime);
+        animations.play(playerAnimation, glm::length(player.velocity) > 0.0f ? walkClip : idleClip);
+        animations.update(deltaTime);
+        player.uv = animations.uv(playerAnimation);
         // Camera follows the player smoothly in Play Mode
         if (currentMode == AppMode::PLAY) {
             camera.lerpFollow(player.position);
         }
-        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        camera.viewportWidth = static_cast<float>(framebufferWidth);  // One world unit per pixel at zoom 1
+        camera.viewportHeight = static_cast<float>(framebufferHeight);
+
+        // The world covers the whole window at any scale; only the pixel count changes
+        gpuTimer.begin();
+        int renderWidth = resolution.width(), renderHeight = resolution.height();
+        float renderScale = static_cast<float>(renderWidth) / framebufferWidth;
+
+        // Cached tiles may still show a placeholder or another mip level, so texture changes redraw them
+        tilesets.use(wallTileset, editor.tileSize * camera.zoomLevel * renderScale);
+        size_t texturesChanged = textures.update() + tilesets.update();
+        if (texturesChanged > 0) tileCache.invalidate();
+        for (const LoadedTexture& loaded : textureLoader.lastCompleted()) {
+            if (loaded.texture != playerTexture.id() || playerSheet.columns * playerSheet.rows != 1) continue;
+            playerOutline = std::make_shared<TracedMesh>();
+            threadPool.submit([outline = playerOutline] {
+                outline->traced = traceSpriteOutline("images/character.jpg", outline->mesh);
+                outline->done.store(true, std::memory_order_release);
+            });
+        }
+        if (playerOutline && playerOutline->done.load(std::memory_order_acquire)) {
+            if (playerOutline->traced && player.mesh != 0) spriteMeshes.replace(player.mesh, playerOutline->mesh);
+            else if (playerOutline->traced) player.mesh = spriteMeshes.add(playerOutline->mesh);
+            playerOutline.reset();
+        }
 
+        // Static tiles: only strips scrolled into view and edited tiles are redrawn
+        if (editor.mapReloaded || !editor.editedTiles.empty()) rebuildWalls();
+        if (editor.mapReloaded) {
+            tileCache.invalidate();
+            lights.invalidateAll();
+        }
+        editor.mapReloaded = false;
+        for (const glm::ivec2& tile : editor.editedTiles) {
+            glm::vec4 tileBounds = glm::vec4(glm::vec2(tile), glm::vec2(tile + 1)) * editor.tileSize;
+            tileCache.invalidateRect(tileBounds);
+            lights.invalidateRect(tileBounds);
+
+            ParticleEmitter debris;
+            debris.position = (glm::vec2(tile) + 0.5f) * editor.tileSize;
+            debris.positionJitter = editor.tileSize * 0.5f;
+            debris.velocity = glm::vec2(0.0f, 120.0f);
+            debris.speedJitter = 150.0f;
+            debris.life = 1.2f;
+            debris.lifeJitter = 0.4f;
+            debris.color = packColor(glm::vec4(0.7f, 0.6f, 0.5f, 1.0f));
+            particles.emit(debris, 200);
+        }
+        editor.editedTiles.clear();
+        if (glm::length(player.velocity) > 0.0f) {
+            ParticleEmitter dust;
+            dust.position = player.position - glm::vec2(0.0f, player.size * 0.5f);
+            dust.positionJitter = player.size * 0.25f;
+            dust.velocity = -player.velocity * 0.2f + glm::vec2(0.0f, 40.0f);
+            dust.speedJitter = 30.0f;
+            dust.life = 0.6f;
+            dust.lifeJitter = 0.2f;
+            dust.size = 3.0f;
+            dust.color = packColor(glm::vec4(0.8f, 0.75f, 0.6f, 0.6f));
+            particles.emit(dust, 8);
+        }
+        particles.update(deltaTime, &threadPool);
+
+        PointLight carried = lights.light(playerLight);
+        carried.position = player.position;
+        lights.set(playerLight, carried);
+        lights.update(wallEdges, &threadPool);
+        glm::vec4 viewBounds = camera.getViewBounds();
+        glm::vec2 viewOrigin(viewBounds.x, viewBounds.y);
+        tileCache.update(renderWidth, renderHeight, camera.zoomLevel * renderScale, viewOrigin,
+                         [&](const glm::vec4& regionBounds, const glm::mat4& projection) {
+            backend.setCamera(projection, glm::mat4(1.0f));
+            tileQueue.clear();
+            editor.submitTiles(tileQueue, spriteShaderId, regionBounds);
+            tileQueue.sort();
+            backend.draw(tileQueue);
+        });
+
+        // Camera matrices go up once per frame, shared by every program
+        backend.setCamera(camera.getProjectionMatrix(), camera.getViewMatrix());
+        lightMap.render(lights, renderWidth, renderHeight);
+        tiledLights.draw(glowLights, camera.getProjectionMatrix() * camera.getViewMatrix(), lightMap.width(),
+                         lightMap.height(), &threadPool);
+
+        bool postProcessing = postProcess.active();
+        resolution.begin(postProcessing);
+        backend.beginFrame(renderWidth, renderHeight, glm::vec4(0.2f, 0.3f, 0.3f, 1.0f));
+        tileCache.draw(viewOrigin);
+
+        // Game code only queues commands; sorting groups them by layer, shader and texture
+        renderQueue.clear();
+        player.submit(renderQueue, spriteShaderId);
+        renderQueue.sort();
+        backend.draw(renderQueue);
+        particleRenderer.draw(particles, &threadPool);
+        lightMap.composite();
+        if (postProcessing) {
+            // The fused pass writes the window directly, upscaling on the way
+            postProcess.apply(resolution.sceneTexture(), renderWidth, renderHeight, framebufferWidth, framebufferHeight);
+        } else {
+            resolution.present();
+        }
         if (currentMode == AppMode::EDIT) {
-            editor.renderGrid();  // Show grid only in Edit Mode
+            editor.renderGrid(gridRenderer);  // Show grid only in Edit Mode, over the tiles, at window resolution
+
+            // Label the shadow-casting lights where they sit on screen
+            glm::mat4 viewProjection = camera.getProjectionMatrix() * camera.getViewMatrix();
+            for (uint32_t id = 0; id < lights.size(); ++id) {
+                glm::vec4 clip = viewProjection * glm::vec4(lights.light(id).position, 0.0f, 1.0f);
+                glm::vec2 screen = (glm::vec2(clip.x, -clip.y) * 0.5f + 0.5f) * glm::vec2(framebufferWidth, framebufferHeight);
+                std::snprintf(hudLine, sizeof(hudLine), "light %u", id);
+                text.add(hudLine, screen + glm::vec2(6.0f), 1.0f, packColor(glm::vec4(1.0f, 1.0f, 0.6f, 1.0f)));
+            }
         }
-        //editor.renderWalls();
 
-        glUseProgram(shaderProgram);
+        // Values change every frame, so these lines skip the layout cache
+        const uint32_t hudColor = packColor(glm::vec4(1.0f, 1.0f, 1.0f, 0.9f));
+        std::snprintf(hudLine, sizeof(hudLine), "frame %.2f ms (gpu %.2f), scale %d%%", resolution.controller.frameMs(),
+                      gpuMs, static_cast<int>(resolution.controller.scale() * 100.0f + 0.5f));
+        text.add(hudLine, glm::vec2(8.0f, 8.0f), 2.0f, hudColor, false);
+        glState().formatStats(hudLine, sizeof(hudLine));
+        text.add(hudLine, glm::vec2(8.0f, 28.0f), 2.0f, hudColor, false);
+        std::snprintf(hudLine, sizeof(hudLine), "particles %zu, lights %zu + %zu, text %zu glyphs",
+                      particles.count(), lights.size(), glowLights.size(), text.lastStats().glyphs);
+        text.add(hudLine, glm::vec2(8.0f, 48.0f), 2.0f, hudColor, false);
+        text.add(currentMode == AppMode::EDIT ? "EDIT  (P to play)" : "PLAY  (E to edit)", glm::vec2(8.0f, 68.0f), 2.0f,
+                 hudColor);
+        const TextureCacheStats& cached = textures.lastStats();
+        std::snprintf(hudLine, sizeof(hudLine), "textures %zu, %.1f MB resident, %.0f%% hits", cached.textures,
+                      cached.residentBytes / (1024.0 * 1024.0), cached.hitRate() * 100.0);
+        text.add(hudLine, glm::vec2(8.0f, 88.0f), 2.0f, hudColor, false);
+        const TextureStreamStats& streamed = tilesets.lastStats();
+        std::snprintf(hudLine, sizeof(hudLine), "tilesets %.1f / %.0f MB, %zu levels loading",
+                      streamed.residentBytes / (1024.0 * 1024.0), streamed.budgetBytes / (1024.0 * 1024.0), streamed.loading);
+        text.add(hudLine, glm::vec2(8.0f, 108.0f), 2.0f, hudColor, false);
+        if (postProcessing) {
+            const PostProcessStats& post = postProcess.lastStats();
+            std::snprintf(hudLine, sizeof(hudLine), "post %u passes, %u effects fused, %zu targets (%.1f MB)",
+                          post.passes, post.fusedEffects, renderTargets.size(), renderTargets.bytes() / (1024.0 * 1024.0));
+            text.add(hudLine, glm::vec2(8.0f, 128.0f), 2.0f, hudColor, false);
+        } else {
+            text.add("post off (1-4: grade, vignette, bloom, crt)", glm::vec2(8.0f, 128.0f), 2.0f, hudColor);
+        }
+        const TextureLoadStats& loading = textureLoader.lastStats();
+        if (loading.decoding + loading.waiting > 0) {
+            std::snprintf(hudLine, sizeof(hudLine), "loading textures: %zu decoding, %zu uploading",
+                          loading.decoding, loading.waiting);
+            text.add(hudLine, glm::vec2(8.0f, 148.0f), 2.0f, hudColor, false);
+        }
+        text.draw(framebufferWidth, framebufferHeight);
+        backend.endFrame();
+        gpuTimer.end();
+
+        // Whichever side is slower sets the frame time; the CPU part stops before vsync waits
+        float cpuMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+        float measuredGpuMs = gpuTimer.poll();
+        if (measuredGpuMs >= 0.0f) gpuMs = measuredGpuMs;
+        resolution.update(std::max(cpuMs, gpuMs));
+
+        glfwSwapBuffers(window);
+        glfwPollEvents();
 
-        glm::mat4 projection = camera.getProjectionMatrix();
-        unsigned int projectionLoc = glGetUniformLocation(shaderProgram, "projection");
-        glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
+        // Per-frame GL call counts, refreshed in the title twice a second
+        glState().endFrame();
+        renderTargets.endFrame();
+        if (currentFrame - lastStatsUpdate > 0.5f) {
+            char title[192];
+            glState().formatStats(title, sizeof(title));
+            const StreamStats& stream = backend.vertexStream.lastFrameStats();
+            size_t length = std::strlen(title);
+            std::snprintf(title + length, sizeof(title) - length,
+                          ", stream stalls %u (%.2f ms), orphans %u, scale %d%% (%.1f ms)", stream.stalls,
+                          stream.stallMs, stream.orphans, static_cast<int>(resolution.controller.scale() * 100.0f + 0.5f),
+                          resolution.controller.frameMs());
+            glfwSetWindowTitle(window, title);
+            lastStatsUpdate = currentFrame;
+        }
+    }
+    glfwSetWindowUserPointer(window, nullptr);
+}
 
-        glm::mat4 view = camera.getViewMatrix();
-        unsigned int viewLoc = glGetUniformLocation(shaderProgram, "view");
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
+// Writes captured frames and checks them against the golden set
+struct FrameCheck {
+    const AppOptions& options;
+    int written = 0;
+    int compared = 0;
+    int failed = 0;
+
+    void operator()(uint64_t frame, const Image& image) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "frame_%05d.png", static_cast<int>(frame));
+        if (!options.captureDir.empty() && writePNG((options.captureDir + "/" + name).c_str(), image)) ++written;
+        if (options.goldenDir.empty()) return;
+
+        ++compared;
+        Image golden;
+        if (!loadImage((options.goldenDir + "/" + name).c_str(), golden)) {
+            ++failed;
+            return;
+        }
+        ImageDiff diff = compareImages(image, golden, options.tolerance);
+        if (diff.sizeMismatch || diff.differingPixels > 0) {
+            std::cerr << "Golden mismatch " << name << ": " << diff.differingPixels << " pixels differ, max delta "
+                      << diff.maxDelta << (diff.sizeMismatch ? " (size differs)" : "") << std::endl;
+            ++failed;
+        }
+    }
+};
+
+// The scripted scene every headless run draws: fixed time step, the player
+// circling the map, so frame N is identical from run to run
+struct HeadlessScene {
+    Character player;
+    Camera camera;
+    Editor editor;
+    RenderQueue queue;
+
+    HeadlessScene(RenderBackend& backend, const AppOptions& options)
+        : player(glm::vec2(400.0f, 300.0f), 100.0f, backend.loadTexture("images/character.jpg")),
+          camera(static_cast<float>(options.width), static_cast<float>(options.height)),
+          editor(40, 30, 20.0f, backend.loadTexture("images/wall.jpg")) {
+        if (!options.mapFile.empty()) {
+            editor.loadFromFile(options.mapFile);
+        } else {
+            // Border walls plus a few pillars so tiles are exercised without a map file
+            for (int i = 0; i < editor.gridWidth; ++i) {
+                editor.tileMap[i][0] = editor.tileMap[i][editor.gridHeight - 1] = TileType::WALL;
+            }
+            for (int j = 0; j < editor.gridHeight; ++j) {
+                editor.tileMap[0][j] = editor.tileMap[editor.gridWidth - 1][j] = TileType::WALL;
+            }
+            for (int i = 5; i < editor.gridWidth - 5; i += 6) {
+                for (int j = 5; j < editor.gridHeight - 5; j += 6) editor.tileMap[i][j] = TileType::WALL;
+            }
+        }
+        queue.reserve(4096);
+    }
 
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(player.position, 0.0f));
-        model = glm::scale(model, glm::vec3(player.size));
-        unsigned int modelLoc = glGetUniformLocation(shaderProgram, "model");
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+    void render(RenderBackend& backend, ParallelRenderBuilder& renderBuilder, int frame, int width, int height) {
+        const float deltaTime = 1.0f / 60.0f;
+        float angle = frame * deltaTime;
+        player.setVelocity(glm::vec2(-std::sin(angle), std::cos(angle)));
+        player.update(deltaTime);
+        camera.lerpFollow(player.position);
 
-        player.bindTexture();
+        backend.beginFrame(width, height, glm::vec4(0.2f, 0.3f, 0.3f, 1.0f));
+        backend.setCamera(camera.getProjectionMatrix(), camera.getViewMatrix());
+        queueScene(queue, renderBuilder, editor, player, camera, backend.spriteShader());
+        backend.draw(queue);
+        backend.endFrame();
+    }
+};
+
+void reportHeadless(const char* backendName, const AppOptions& options, double totalMs, const FrameCheck& check) {
+    std::cout << "headless " << backendName << ": " << options.frames << " frames " << options.width << "x"
+              << options.height << " in " << totalMs << " ms (" << totalMs / options.frames << " ms/frame, "
+              << options.frames * 1000.0 / totalMs << " fps), captured " << check.written;
+    if (!options.goldenDir.empty()) std::cout << ", golden " << check.compared - check.failed << "/" << check.compared << " passed";
+    std::cout << std::endl;
+}
 
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+// CPU rasterizer: no window, no GL, no GPU
+int runHeadlessSoftware(const AppOptions& options) {
+    ThreadPool threadPool;
+    ParallelRenderBuilder renderBuilder(threadPool);
+    SoftwareRasterizer backend(&threadPool);
+    HeadlessScene scene(backend, options);
+    FrameCheck check{ options };
+
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < options.frames; ++frame) {
+        scene.render(backend, renderBuilder, frame, options.width, options.height);
+        if (frame % options.captureEvery == 0) check(frame, backend.framebuffer());
+    }
+    double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+    reportHeadless("software", options, totalMs, check);
+    return check.failed > 0 ? 1 : 0;
+}
+
+// GL into an offscreen framebuffer; frames come back through the PBO ring
+// while later frames render, and nothing waits for vsync
+int runHeadlessGL(const AppOptions& options) {
+    ThreadPool threadPool;
+    ParallelRenderBuilder renderBuilder(threadPool);
+    GLRenderBackend backend(&renderBuilder);
+    RenderTarget target(options.width, options.height);
+    FrameReadback readback;
+    HeadlessScene scene(backend, options);
+    FrameCheck check{ options };
+    bool capturing = !options.captureDir.empty() || !options.goldenDir.empty();
+
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < options.frames; ++frame) {
+        target.bind();
+        scene.render(backend, renderBuilder, frame, options.width, options.height);
+        if (capturing && frame % options.captureEvery == 0) readback.request(options.width, options.height, frame, check);
+        readback.collect(check);
+        glState().endFrame();
+    }
+    readback.collect(check, true);
+    glFinish();
+    double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    reportHeadless("gl", options, totalMs, check);
+    if (readback.stalls() > 0) std::cout << "readback stalls " << readback.stalls() << std::endl;
+    return check.failed > 0 ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    AppOptions options;
+    if (!parseOptions(argc, argv, options)) return 2;
+    if (!options.captureDir.empty()) std::filesystem::create_directories(options.captureDir);
+    if (options.software) return runHeadlessSoftware(options);
+
+    // Initialize GLFW; headless runs use the null platform, which needs no display server
+    if (options.headless) glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    // Create a window; without one the context comes from EGL, or OSMesa as a last resort
+    GLFWwindow* window = nullptr;
+    if (options.headless) {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+        window = glfwCreateWindow(options.width, options.height, "Character Render", nullptr, nullptr);
+        if (window == nullptr) {
+            glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+            window = glfwCreateWindow(options.width, options.height, "Character Render", nullptr, nullptr);
+        }
+    } else {
+        window = glfwCreateWindow(800, 600, "Character Render", nullptr, nullptr);
     }
+    if (window == nullptr) {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
 
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteBuffers(1, &EBO);
-    glDeleteProgram(shaderProgram);
+    // Load OpenGL function pointers using GLAD
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    // GL objects owned by the game loop are released before the context goes away
+    int result = 0;
+    if (options.headless) {
+        glfwSwapInterval(0);
+        result = runHeadlessGL(options);
+    } else {
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+        runGame(window);
+    }
 
     glfwTerminate();
-    return 0;
+    return result;
 }
\ No newline at end of file
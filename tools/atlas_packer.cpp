@@ -0,0 +1,80 @@
+// File: tools/atlas_packer.cpp
+// Offline atlas build step: packs images into one page and writes the page
+// (.tga) plus the UV lookup table (.atlas) that TextureAtlas::loadFromFile reads.
+// Paths in the table, the region names included, are relative to the .atlas file.
+//
+// Build: g++ -O2 -Iinclude tools/atlas_packer.cpp -o atlas_packer
+// Usage: atlas_packer [-s size] [-p padding] [-e extrude] [-h maxrects|area|bottomleft|skyline] out images...
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <Render/atlas_packer.h>
+
+static void printUsage() {
+    std::cout << "usage: atlas_packer [-s size] [-p padding] [-e extrude] "
+                 "[-h maxrects|area|bottomleft|skyline] out images..." << std::endl;
+}
+
+int main(int argc, char** argv) {
+    int size = 2048, padding = 2, extrude = 1;
+    PackHeuristic heuristic = PackHeuristic::MaxRectsBestShortSide;
+    std::vector<std::string> inputs;
+    std::string output;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-s" && i + 1 < argc) size = std::atoi(argv[++i]);
+        else if (arg == "-p" && i + 1 < argc) padding = std::atoi(argv[++i]);
+        else if (arg == "-e" && i + 1 < argc) extrude = std::atoi(argv[++i]);
+        else if (arg == "-h" && i + 1 < argc) {
+            std::string name = argv[++i];
+            if (name == "maxrects") heuristic = PackHeuristic::MaxRectsBestShortSide;
+            else if (name == "area") heuristic = PackHeuristic::MaxRectsBestArea;
+            else if (name == "bottomleft") heuristic = PackHeuristic::MaxRectsBottomLeft;
+            else if (name == "skyline") heuristic = PackHeuristic::Skyline;
+            else {
+                std::cerr << "Unknown heuristic: " << name << std::endl;
+                printUsage();
+                return 1;
+            }
+        }
+        else if (output.empty()) output = arg;
+        else inputs.push_back(arg);
+    }
+
+    if (output.empty() || inputs.empty()) {
+        printUsage();
+        return 1;
+    }
+
+    // Decode everything first so sprites can be packed tallest-first
+    std::vector<Image> images(inputs.size());
+    std::vector<size_t> order;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        if (loadImage(inputs[i].c_str(), images[i])) order.push_back(i);
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return images[a].height > images[b].height;
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    AtlasPacker packer(size, size, padding, extrude, heuristic);
+    for (size_t i : order) {
+        if (packer.add(atlasRelativePath(inputs[i], output + ".atlas"), images[i]) < 0) {
+            std::cerr << "Atlas is full, could not pack " << inputs[i] << std::endl;
+            return 1;
+        }
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    if (!packer.save(output + ".atlas", output + ".tga")) return 1;
+    std::cout << "Packed " << order.size() << " sprites into " << size << "x" << size
+              << " (" << packer.occupancy() * 100.0f << "% occupancy, " << ms << " ms)" << std::endl;
+    return 0;
+}
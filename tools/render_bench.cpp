@@ -0,0 +1,815 @@
+// File: tools/render_bench.cpp
+// CPU-side benchmarks for the renderer building blocks. Runs without a GL context.
+//
+// Build: g++ -O2 -Iinclude tools/render_bench.cpp -o render_bench
+// Usage: render_bench [name...]   (no names runs everything)
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <chrono>
+#include <filesystem>
+#include <glm/gtc/matrix_transform.hpp>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <Render/atlas_packer.h>
+#include <Render/depth_sort.h>
+#include <Render/image_cache.h>
+#include <Render/image_kernels.h>
+#include <Render/light_binning.h>
+#include <Render/light_visibility.h>
+#include <Render/particle_system.h>
+#include <Render/render_builder.h>
+#include <Render/render_queue.h>
+#include <Render/software_rasterizer.h>
+#include <Render/sprite_animation.h>
+#include <Render/sprite_mesh.h>
+#include <Render/texture_container.h>
+#include <Render/texture_cook.h>
+#include <Render/texture_residency.h>
+#include <Render/thread_pool.h>
+
+using BenchClock = std::chrono::steady_clock;
+
+static double elapsedMs(BenchClock::time_point start) {
+    return std::chrono::duration<double, std::milli>(BenchClock::now() - start).count();
+}
+
+// Packing efficiency and time for thousands of randomly sized sprites
+static void benchAtlas() {
+    struct Heuristic { const char* name; PackHeuristic value; };
+    const Heuristic heuristics[] = {
+        { "maxrects-bssf", PackHeuristic::MaxRectsBestShortSide },
+        { "maxrects-baf", PackHeuristic::MaxRectsBestArea },
+        { "maxrects-bl", PackHeuristic::MaxRectsBottomLeft },
+        { "skyline", PackHeuristic::Skyline },
+    };
+
+    for (int count : { 1000, 4000 }) {
+        std::mt19937 rng(1234);
+        std::uniform_int_distribution<int> side(8, 64);
+        std::vector<std::pair<int, int>> sizes(count);
+        for (auto& s : sizes) s = { side(rng), side(rng) };
+        std::sort(sizes.begin(), sizes.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+
+        for (const Heuristic& h : heuristics) {
+            // Smallest power-of-two page that takes every sprite
+            for (int pageSize = 256; pageSize <= 8192; pageSize *= 2) {
+                AtlasPacker packer(pageSize, pageSize, 2, 1, h.value);
+                auto start = BenchClock::now();
+                int packed = 0;
+                for (int i = 0; i < count; ++i) {
+                    if (packer.pack(std::to_string(i), sizes[i].first, sizes[i].second) < 0) break;
+                    ++packed;
+                }
+                double ms = elapsedMs(start);
+                if (packed < count) continue;
+
+                std::cout << "atlas " << h.name << " sprites=" << count << " page=" << pageSize
+                          << " occupancy=" << packer.occupancy() * 100.0f << "% time=" << ms << "ms" << std::endl;
+                break;
+            }
+        }
+    }
+}
+
+// Submit and radix-sort a million commands, against std::sort on the same keys,
+// and whether the sort fits a 60 Hz frame on its own
+static void benchSort() {
+    const size_t count = 1000000;
+    const double frameMs = 1000.0 / 60.0;
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<uint32_t> any;
+
+    RenderQueue queue;
+    queue.reserve(count);
+    RenderCommand cmd = {};
+    std::vector<SortEntry> reference;
+
+    // A few layers and shaders, a few dozen textures; depth either random (worst case) or unused.
+    // Each case runs a few frames and reports its fastest.
+    for (bool randomDepth : { true, false }) {
+        double submitMs = 1e9, radixMs = 1e9, stdMs = 1e9;
+        bool same = true;
+        for (int frame = 0; frame < 3; ++frame) {
+            queue.clear();
+            auto start = BenchClock::now();
+            for (size_t i = 0; i < count; ++i) {
+                uint32_t r = any(rng);
+                cmd.texture = r % 64;
+                queue.submit(SortKey::batched(r % 4, (r >> 8) % 3, cmd.texture, randomDepth ? any(rng) : 0), cmd);
+            }
+            submitMs = std::min(submitMs, elapsedMs(start));
+
+            reference = queue.getEntries();
+            start = BenchClock::now();
+            queue.sort();
+            radixMs = std::min(radixMs, elapsedMs(start));
+
+            start = BenchClock::now();
+            std::stable_sort(reference.begin(), reference.end(),
+                             [](const SortEntry& a, const SortEntry& b) { return a.key < b.key; });
+            stdMs = std::min(stdMs, elapsedMs(start));
+
+            same &= std::equal(reference.begin(), reference.end(), queue.getEntries().begin(),
+                               [](const SortEntry& a, const SortEntry& b) { return a.index == b.index && a.key == b.key; });
+        }
+        std::cout << "sort commands=" << count << (randomDepth ? " depth=random" : " depth=none") << " submit=" << submitMs << "ms radix=" << radixMs
+                  << "ms std::stable_sort=" << stdMs << "ms frame-budget=" << (radixMs <= frameMs ? "met" : "MISSED")
+                  << (same ? "" : " MISMATCH") << std::endl;
+    }
+}
+
+// Cull and build a large tile map's command list and vertices on 1..N threads
+static void benchBuild() {
+    const int mapSize = 2048;
+    const int columnsPerChunk = 32;
+    std::mt19937 rng(7);
+    std::vector<unsigned char> walls(static_cast<size_t>(mapSize) * mapSize);
+    for (unsigned char& wall : walls) wall = rng() % 3 == 0;
+
+    // View covering most of the map so culling keeps plenty of work
+    const glm::vec4 view(100.0f, 100.0f, 1900.0f, 1900.0f);
+    unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+
+    for (unsigned threads = 1; threads <= std::max(4u, hardware); threads *= 2) {
+        ThreadPool pool(threads - 1);
+        ParallelRenderBuilder builder(pool);
+        RenderQueue queue;
+        std::vector<SpriteVertex> vertices;
+
+        double best = 1e9;
+        for (int frame = 0; frame < 5; ++frame) {
+            auto start = BenchClock::now();
+            queue.clear();
+            builder.build(mapSize / columnsPerChunk, [&](size_t chunk, RenderQueue& local) {
+                RenderCommand cmd = {};
+                cmd.size = glm::vec2(1.0f);
+                cmd.uv = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+                cmd.color = COLOR_WHITE;
+                int begin = static_cast<int>(chunk) * columnsPerChunk;
+                for (int x = begin; x < begin + columnsPerChunk; ++x) {
+                    if (x < view.x || x > view.z) continue;
+                    for (int y = static_cast<int>(view.y); y <= static_cast<int>(view.w); ++y) {
+                        if (!walls[static_cast<size_t>(x) * mapSize + y]) continue;
+                        cmd.position = glm::vec2(x, y);
+                        cmd.texture = (x / 256) * 8 + y / 256;
+                        local.submit(SortKey::batched(RenderLayer::Tiles, 0, cmd.texture, 0), cmd);
+                    }
+                }
+            }, queue);
+            queue.sort();
+            vertices.resize(queue.size() * 4);
+            builder.buildVertices(queue, vertices.data());
+            best = std::min(best, elapsedMs(start));
+        }
+        std::cout << "build threads=" << threads << " commands=" << queue.size()
+                  << " build+sort+vertices=" << best << "ms" << std::endl;
+    }
+    if (hardware == 1) std::cout << "build (single hardware thread here: no scaling to observe)" << std::endl;
+}
+
+// Software rasterizer throughput: 32x32 alpha-blended sprites over a 1280x720 frame
+static void benchRaster() {
+    const int width = 1280, height = 720;
+    const int spriteCount = 20000;
+    const float spriteSize = 32.0f;
+
+    Image sprite(64, 64);
+    for (int y = 0; y < sprite.height; ++y) {
+        for (int x = 0; x < sprite.width; ++x) {
+            unsigned char* p = sprite.pixel(x, y);
+            p[0] = static_cast<unsigned char>(x * 4);
+            p[1] = static_cast<unsigned char>(y * 4);
+            p[2] = 128;
+            p[3] = (x / 8 + y / 8) % 2 ? 255 : 128;
+        }
+    }
+
+    std::mt19937 rng(99);
+    std::uniform_real_distribution<float> px(-spriteSize, float(width)), py(-spriteSize, float(height));
+    RenderQueue queue;
+    RenderCommand cmd = {};
+    cmd.size = glm::vec2(spriteSize);
+    cmd.uv = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+    cmd.color = COLOR_WHITE;
+    cmd.texture = 1;
+    for (int i = 0; i < spriteCount; ++i) {
+        cmd.position = glm::vec2(px(rng), py(rng));
+        queue.submit(SortKey::ordered(RenderLayer::Sprites, SortKey::depthFromFloat(float(i)), 0, 1), cmd);
+    }
+    queue.sort();
+
+    glm::mat4 projection = glm::ortho(0.0f, float(width), 0.0f, float(height));
+    unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+
+    for (SampleFilter filter : { SampleFilter::Nearest, SampleFilter::Bilinear }) {
+        for (unsigned threads = 1; threads <= std::max(4u, hardware); threads *= 2) {
+            ThreadPool pool(threads - 1);
+            SoftwareRasterizer rasterizer(&pool);
+            rasterizer.filter = filter;
+            rasterizer.createTexture(sprite);
+            rasterizer.setCamera(projection, glm::mat4(1.0f));
+
+            double best = 1e9;
+            for (int frame = 0; frame < 3; ++frame) {
+                auto start = BenchClock::now();
+                rasterizer.beginFrame(width, height, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+                rasterizer.draw(queue);
+                rasterizer.endFrame();
+                best = std::min(best, elapsedMs(start));
+            }
+
+            const RasterStats& stats = rasterizer.stats();
+            double seconds = best / 1000.0;
+            double mpix = stats.pixelsShaded / seconds / 1e6;
+            std::cout << "raster " << (filter == SampleFilter::Nearest ? "nearest " : "bilinear") << " threads=" << threads
+                      << " frame=" << best << "ms sprites/s=" << static_cast<uint64_t>(spriteCount / seconds)
+                      << " fill=" << mpix << "Mpix/s (" << mpix / std::min(threads, hardware) << " per core)"
+                      << " overdraw=" << double(stats.pixelsShaded) / (double(width) * height) << std::endl;
+        }
+    }
+    if (hardware == 1) std::cout << "raster (single hardware thread here: no scaling to observe)" << std::endl;
+}
+
+// Per-frame y-sort of many moving sprites: incremental order vs sorting from scratch
+static void benchYSort() {
+    const size_t count = 100000;
+    const int frames = 20;
+
+    for (bool worstCase : { false, true }) {
+        std::mt19937 rng(11);
+        std::uniform_real_distribution<float> world(0.0f, 10000.0f), step(-2.0f, 2.0f);
+        std::vector<float> y(count);
+        for (float& value : y) value = world(rng);
+
+        DepthOrder order;
+        order.update(y.data(), count);
+        std::vector<uint32_t> stdOrder = order.ids();
+        std::vector<SortEntry> entries(count), scratch(count);
+
+        double incrementalMs = 0.0, stdMs = 0.0, radixMs = 0.0;
+        size_t shifts = 0;
+        int fallbacks = 0;
+        bool same = true;
+        for (int frame = 0; frame < frames; ++frame) {
+            // Typical: everyone walks a couple of units. Worst case: everyone teleports.
+            for (float& value : y) value = worstCase ? world(rng) : value + step(rng);
+
+            auto start = BenchClock::now();
+            order.update(y.data(), count);
+            incrementalMs += elapsedMs(start);
+            shifts += order.lastStats().shifts;
+            fallbacks += order.lastStats().usedRadix;
+
+            start = BenchClock::now();
+            std::sort(stdOrder.begin(), stdOrder.end(), [&](uint32_t a, uint32_t b) {
+                return y[a] > y[b] || (y[a] == y[b] && a < b);
+            });
+            stdMs += elapsedMs(start);
+
+            start = BenchClock::now();
+            for (uint32_t i = 0; i < count; ++i) {
+                entries[i] = { (static_cast<uint64_t>(~SortKey::depthFromFloat(y[i])) << 32) | i, i, 0 };
+            }
+            radixSortEntries(entries.data(), scratch.data(), count);
+            radixMs += elapsedMs(start);
+
+            same &= stdOrder == order.ids();
+        }
+        std::cout << "ysort sprites=" << count << (worstCase ? " motion=teleport" : " motion=walk")
+                  << " incremental=" << incrementalMs / frames << "ms (shifts/sprite " << double(shifts) / (count * frames)
+                  << ", radix fallbacks " << fallbacks << "/" << frames << ") std::sort=" << stdMs / frames
+                  << "ms radix=" << radixMs / frames << "ms" << (same ? "" : " MISMATCH") << std::endl;
+    }
+}
+
+// Visibility polygons for hundreds of shadow-casting lights on a walled map: a
+// full rebuild on 1..N threads, then the per-frame cost when a few lights move
+// and after a single tile edit
+static void benchLights() {
+    const int mapSize = 512;
+    const float tileSize = 16.0f;
+    const size_t lightCount = 500;
+    std::mt19937 rng(13);
+
+    // 16x16 rooms with a doorway per wall, plus scattered pillars
+    std::vector<unsigned char> walls(static_cast<size_t>(mapSize) * mapSize, 0);
+    for (int i = 0; i < mapSize; ++i) {
+        for (int j = 0; j < mapSize; ++j) {
+            bool roomWall = (i % 16 == 0 && j % 16 != 8) || (j % 16 == 0 && i % 16 != 8);
+            walls[static_cast<size_t>(j) * mapSize + i] = roomWall || rng() % 40 == 0;
+        }
+    }
+    auto isWall = [&](int i, int j) { return walls[static_cast<size_t>(j) * mapSize + i] != 0; };
+
+    WallEdges edges;
+    auto start = BenchClock::now();
+    edges.build(mapSize, mapSize, tileSize, isWall);
+    double edgeMs = elapsedMs(start);
+    std::cout << "lights map=" << mapSize << "x" << mapSize << " edges=" << edges.segments().size()
+              << " build=" << edgeMs << "ms" << std::endl;
+
+    std::uniform_real_distribution<float> place(0.0f, mapSize * tileSize), radius(96.0f, 256.0f);
+    std::vector<PointLight> lights(lightCount);
+    for (PointLight& light : lights) light = { glm::vec2(place(rng), place(rng)), radius(rng), glm::vec4(1.0f) };
+
+    unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned threads = 1; threads <= std::max(4u, hardware); threads *= 2) {
+        ThreadPool pool(threads - 1);
+        LightVisibilityCache cache;
+        for (const PointLight& light : lights) cache.add(light);
+
+        start = BenchClock::now();
+        cache.update(edges, &pool);
+        double fullMs = elapsedMs(start);
+        const LightingStats& full = cache.lastStats();
+        std::cout << "lights threads=" << threads << " lights=" << lightCount << " full=" << fullMs << "ms (edges/light "
+                  << double(full.edgesConsidered) / full.rebuilt << ", points/light " << double(full.polygonPoints) / full.rebuilt
+                  << ")";
+
+        // A few lights move each frame; the rest keep their cached polygons
+        const int frames = 20;
+        double movingMs = 0.0;
+        size_t rebuilt = 0;
+        std::uniform_real_distribution<float> step(-3.0f, 3.0f);
+        for (int frame = 0; frame < frames; ++frame) {
+            for (uint32_t id = frame % 10; id < lightCount; id += 10) {
+                PointLight light = cache.light(id);
+                light.position += glm::vec2(step(rng), step(rng));
+                cache.set(id, light);
+            }
+            start = BenchClock::now();
+            cache.update(edges, &pool);
+            movingMs += elapsedMs(start);
+            rebuilt += cache.lastStats().rebuilt;
+        }
+
+        // One edited tile: walls rebuilt, only lights reaching it recomputed
+        glm::ivec2 tile(mapSize / 2 + 3, mapSize / 2 + 3);
+        walls[static_cast<size_t>(tile.y) * mapSize + tile.x] ^= 1;
+        start = BenchClock::now();
+        edges.build(mapSize, mapSize, tileSize, isWall);
+        cache.invalidateRect(glm::vec4(glm::vec2(tile), glm::vec2(tile + 1)) * tileSize);
+        cache.update(edges, &pool);
+        double editMs = elapsedMs(start);
+        walls[static_cast<size_t>(tile.y) * mapSize + tile.x] ^= 1;
+        edges.build(mapSize, mapSize, tileSize, isWall);
+
+        std::cout << " 10%-moving=" << movingMs / frames << "ms (" << rebuilt / frames << " rebuilt)"
+                  << " tile-edit=" << editMs << "ms (" << cache.lastStats().rebuilt << " rebuilt)" << std::endl;
+    }
+    if (hardware == 1) std::cout << "lights (single hardware thread here: no scaling to observe)" << std::endl;
+}
+
+// Screen-tile binning of 1,000 lights at 1080p on 1..N threads, and the light
+// evaluations per pixel the tiled pass does against shading every light
+static void benchTiledLights() {
+    const int width = 1920, height = 1080;
+    const size_t lightCount = 1000;
+    std::mt19937 rng(17);
+    std::uniform_real_distribution<float> x(-100.0f, width + 100.0f), y(-100.0f, height + 100.0f), radius(24.0f, 160.0f);
+    std::vector<PointLight> lights(lightCount);
+    for (PointLight& light : lights) light = { glm::vec2(x(rng), y(rng)), radius(rng), glm::vec4(1.0f) };
+    glm::mat4 viewProjection = glm::ortho(0.0f, float(width), 0.0f, float(height), -1.0f, 1.0f);
+
+    std::vector<uint32_t> reference;
+    unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned threads = 1; threads <= std::max(4u, hardware); threads *= 2) {
+        ThreadPool pool(threads - 1);
+        LightTileBinner binner;
+        double best = 1e9;
+        for (int frame = 0; frame < 10; ++frame) {
+            auto start = BenchClock::now();
+            binner.bin(lights.data(), lights.size(), viewProjection, width, height, &pool);
+            best = std::min(best, elapsedMs(start));
+        }
+        if (reference.empty()) reference = binner.packed();
+
+        const LightBinStats& stats = binner.lastStats();
+        double perPixel = double(stats.indices) * binner.tileSize * binner.tileSize / (double(width) * height);
+        std::cout << "tiledlights threads=" << threads << " lights=" << lightCount << " tiles=" << binner.tileCount()
+                  << " bin=" << best << "ms lights/pixel=" << perPixel << " (all lights: " << lightCount
+                  << ") max/tile=" << stats.maxPerTile << " upload=" << binner.packed().size() * 4 / 1024 << "KB"
+                  << (binner.packed() == reference ? "" : " MISMATCH") << std::endl;
+    }
+    if (hardware == 1) std::cout << "tiledlights (single hardware thread here: no scaling to observe)" << std::endl;
+}
+
+// One million live particles: integration with and without wall collisions on
+// 1..N threads, plus writing the instance data the renderer uploads
+static void benchParticles() {
+    const size_t count = 1 << 20;
+    const int frames = 20;
+    const float dt = 1.0f / 60.0f;
+
+    // 256x256 tiles of 8 units with scattered walls
+    std::mt19937 rng(19);
+    TileBitset walls;
+    walls.build(256, 256, 8.0f, [&](int, int) { return rng() % 8 == 0; });
+    std::vector<ParticleInstance> instances(count);
+
+    unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    for (bool collide : { false, true }) {
+        for (unsigned threads = 1; threads <= std::max(4u, hardware); threads *= 2) {
+            ThreadPool pool(threads - 1);
+            ParticleSystem particles(count);
+            particles.walls = collide ? &walls : nullptr;
+            ParticleEmitter emitter;
+            emitter.position = glm::vec2(1024.0f);
+            emitter.positionJitter = 1000.0f;
+            emitter.speedJitter = 200.0f;
+            emitter.life = 4.0f;
+            emitter.lifeJitter = 3.9f;
+            particles.emit(emitter, count);
+
+            double updateMs = 0.0, writeMs = 0.0;
+            size_t died = 0, collisions = 0;
+            for (int frame = 0; frame < frames; ++frame) {
+                auto start = BenchClock::now();
+                particles.update(dt, &pool);
+                updateMs += elapsedMs(start);
+                died += particles.lastStats().died;
+                collisions += particles.lastStats().collisions;
+                particles.emit(emitter, count - particles.count());  // Keep the count at a million
+
+                start = BenchClock::now();
+                particles.writeInstances(instances.data(), &pool);
+                writeMs += elapsedMs(start);
+            }
+            std::cout << "particles threads=" << threads << " live=" << count << (collide ? " collide=walls" : " collide=off")
+                      << " update=" << updateMs / frames << "ms (died/frame " << died / frames << ", bounces/frame "
+                      << collisions / frames << ") instances=" << writeMs / frames << "ms" << std::endl;
+        }
+    }
+    if (hardware == 1) std::cout << "particles (single hardware thread here: no scaling to observe)" << std::endl;
+}
+
+// Startup cost of 1,000 textures: stb decode plus a mip chain (the CPU side of
+// loadTexture and glGenerateMipmap) against mapping cooked containers and
+// reading every level once, which is what the upload copies out of the mapping
+static volatile uint8_t textureSink;  // Keeps the reads from being optimised away
+
+static void benchTextureStartup() {
+    const char* source = "images/wall.jpg";
+    const int count = 1000;
+    Image image;
+    if (!loadImage(source, image)) {
+        std::cout << "texstartup skipped: run from the repository root so " << source << " can be found" << std::endl;
+        return;
+    }
+
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "render_bench_textures";
+    std::filesystem::create_directories(directory);
+    for (TextureFormat format : { TextureFormat::RGBA8, TextureFormat::BC1 }) {
+        std::vector<std::vector<uint8_t>> levels;
+        for (const Image& mip : buildMipChain(image)) levels.push_back(format == TextureFormat::BC1 ? encodeBC1(mip) : mip.pixels);
+        std::string name = (directory / (format == TextureFormat::BC1 ? "wall_bc1.tex" : "wall_rgba8.tex")).string();
+        if (!writeTextureContainer(name.c_str(), format, image.width, image.height, levels)) return;
+    }
+
+    auto start = BenchClock::now();
+    for (int i = 0; i < count; ++i) {
+        Image decoded;
+        loadImage(source, decoded);
+        std::vector<Image> mips = buildMipChain(decoded);
+        textureSink = mips.back().pixels[0];
+    }
+    double stbMs = elapsedMs(start);
+    std::cout << "texstartup " << count << "x " << image.width << "x" << image.height << " stb+mips=" << stbMs << "ms";
+
+    for (const char* name : { "wall_rgba8.tex", "wall_bc1.tex" }) {
+        std::string path = (directory / name).string();
+        start = BenchClock::now();
+        for (int i = 0; i < count; ++i) {
+            TextureContainer container;
+            if (!container.open(path.c_str())) return;
+            for (uint32_t level = 0; level < container.levelCount(); ++level) {
+                const TextureLevel& data = container.level(level);
+                for (size_t offset = 0; offset < data.size; offset += 64) textureSink = data.data[offset];
+            }
+        }
+        double ms = elapsedMs(start);
+        std::cout << " " << name << "=" << ms << "ms (" << stbMs / ms << "x)";
+    }
+    std::cout << std::endl;
+    std::filesystem::remove_all(directory);
+}
+
+// Mip and resize kernels on a 2048x2048 image, in source megapixels per
+// second, single-threaded and across the pool. The scalar box loop is the one
+// downsampleBox used before the kernels, for the SSE2 speedup.
+static void benchKernels() {
+    const int size = 2048;
+    std::mt19937 rng(47);
+    std::vector<uint8_t> source(static_cast<size_t>(size) * size * 4);
+    for (uint8_t& value : source) value = static_cast<uint8_t>(rng());
+    std::vector<uint8_t> destination(source.size());
+    const double megapixels = size * double(size) / 1e6;
+
+    auto measure = [&](auto&& kernel) {
+        int runs = 0;
+        auto start = BenchClock::now();
+        do {
+            kernel();
+            ++runs;
+        } while (elapsedMs(start) < 300.0);
+        return megapixels * runs / (elapsedMs(start) / 1000.0);
+    };
+
+    double scalar = measure([&] {
+        int half = size / 2;
+        for (int y = 0; y < half; ++y) {
+            for (int x = 0; x < half; ++x) {
+                const uint8_t* a = &source[(static_cast<size_t>(y * 2) * size + x * 2) * 4];
+                const uint8_t* c = a + size * 4;
+                for (int channel = 0; channel < 4; ++channel) {
+                    destination[(static_cast<size_t>(y) * half + x) * 4 + channel] =
+                        static_cast<uint8_t>((a[channel] + a[4 + channel] + c[channel] + c[4 + channel] + 2) >> 2);
+                }
+            }
+        }
+    });
+    std::cout << "kernels " << size << "x" << size << " box scalar=" << scalar << "MP/s" << std::endl;
+
+    unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned threads : { 1u, hardware }) {
+        ThreadPool pool(threads - 1);
+        ThreadPool* rows = threads > 1 ? &pool : nullptr;
+        ResizeScratch scratch;
+        struct Kernel { const char* name; ResampleFilter filter; bool srgb; int width, height; };
+        const Kernel kernels[] = {
+            { "box", ResampleFilter::Box, false, size / 2, size / 2 },
+            { "box-srgb", ResampleFilter::Box, true, size / 2, size / 2 },
+            { "kaiser", ResampleFilter::Kaiser, false, size / 2, size / 2 },
+            { "kaiser-srgb", ResampleFilter::Kaiser, true, size / 2, size / 2 },
+            { "lanczos", ResampleFilter::Lanczos3, false, size / 2, size / 2 },
+            { "lanczos-1280x720", ResampleFilter::Lanczos3, false, 1280, 720 },
+        };
+        std::cout << "kernels threads=" << threads;
+        for (const Kernel& kernel : kernels) {
+            double rate = measure([&] {
+                if (kernel.width == size / 2 && kernel.height == size / 2) {
+                    downsampleLevel(source.data(), size, size, destination.data(), kernel.filter, kernel.srgb, rows, &scratch);
+                } else {
+                    resizeImage(source.data(), size, size, destination.data(), kernel.width, kernel.height, kernel.filter,
+                                kernel.srgb, rows, &scratch);
+                }
+            });
+            std::cout << " " << kernel.name << "=" << rate << "MP/s";
+        }
+        std::cout << std::endl;
+        if (hardware == 1) break;
+    }
+    textureSink = destination[0];
+}
+
+// Second-launch cost of an image: stb decode plus mips against mapping and
+// validating the image cache entry an earlier run wrote
+static void benchImageCache() {
+    const int count = 50;
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "render_bench_image_cache";
+    std::filesystem::remove_all(directory);
+    ImageCache cache(directory.string());
+
+    for (const char* source : { "images/wall.jpg", "images/character.jpg" }) {
+        TextureContainer entry;
+        auto start = BenchClock::now();
+        if (!cache.load(source, ImageDecodeOptions(), entry)) {
+            std::cout << "imagecache skipped: run from the repository root so " << source << " can be found" << std::endl;
+            return;
+        }
+        double missMs = elapsedMs(start);
+
+        start = BenchClock::now();
+        for (int i = 0; i < count; ++i) {
+            Image decoded;
+            loadImage(source, decoded);
+            std::vector<Image> mips = buildMipChain(decoded);
+            textureSink = mips.back().pixels[0];
+        }
+        double stbMs = elapsedMs(start) / count;
+
+        start = BenchClock::now();
+        for (int i = 0; i < count; ++i) {
+            TextureContainer hit;
+            cache.load(source, ImageDecodeOptions(), hit);
+            textureSink = hit.level(hit.levelCount() - 1).data[0];
+        }
+        double hitMs = elapsedMs(start) / count;
+        std::cout << "imagecache " << source << " " << entry.width() << "x" << entry.height() << ": stb+mips=" << stbMs
+                  << "ms, first load (decode+write)=" << missMs << "ms, cached=" << hitMs << "ms (" << stbMs / hitMs << "x)"
+                  << std::endl;
+    }
+    std::filesystem::remove_all(directory);
+}
+
+// A 64x64 world of unique 512x512 tilesets (5.6 GB with mips) against a 256 MB
+// budget while the camera pans and zooms across it. Loads land one frame after
+// they are planned, standing in for the workers.
+static void benchStreaming() {
+    const int worldTiles = 64;
+    const float tileSize = 256.0f;
+    const uint32_t textureSize = 512;
+    const int frames = 3000;
+    TextureResidency residency(size_t(256) << 20);
+
+    size_t totalBytes = 0;
+    for (int i = 0; i < worldTiles * worldTiles; ++i) {
+        std::vector<StreamedLevel> levels;
+        for (uint32_t size = textureSize; size >= 1; size /= 2) levels.push_back({ size, size, size_t(size) * size * 4 });
+        for (const StreamedLevel& level : levels) totalBytes += level.bytes;
+        residency.add(std::move(levels));
+    }
+
+    std::vector<LevelRange> loads, drops, inFlight;
+    size_t peakBytes = 0, loadedLevels = 0, droppedLevels = 0, sharpFrames = 0;
+    double planMs = 0.0;
+    for (int frame = 0; frame < frames; ++frame) {
+        for (const LevelRange& load : inFlight) residency.loaded(load.texture);
+
+        // A slow figure-eight over the world, zooming between 0.25x and 2x
+        float t = frame / 600.0f;
+        float zoom = 0.25f + 1.75f * (0.5f + 0.5f * std::sin(t * 1.7f));
+        glm::vec2 center = glm::vec2(0.5f + 0.4f * std::sin(t), 0.5f + 0.4f * std::sin(t * 2.0f)) * (worldTiles * tileSize);
+        glm::vec2 halfExtent = glm::vec2(1280.0f, 720.0f) * (0.5f / zoom);
+        glm::ivec2 low = glm::clamp(glm::ivec2((center - halfExtent) / tileSize), glm::ivec2(0), glm::ivec2(worldTiles - 1));
+        glm::ivec2 high = glm::clamp(glm::ivec2((center + halfExtent) / tileSize), glm::ivec2(0), glm::ivec2(worldTiles - 1));
+
+        auto start = BenchClock::now();
+        for (int y = low.y; y <= high.y; ++y) {
+            for (int x = low.x; x <= high.x; ++x) residency.use(static_cast<uint32_t>(y * worldTiles + x), tileSize * zoom);
+        }
+        residency.plan(loads, drops);
+        planMs += elapsedMs(start);
+
+        inFlight = loads;
+        for (const LevelRange& load : loads) loadedLevels += load.end - load.first;
+        for (const LevelRange& drop : drops) droppedLevels += drop.end - drop.first;
+        peakBytes = std::max(peakBytes, residency.committedBytes());
+        uint32_t wanted = requiredMipLevel(textureSize, textureSize, tileSize * zoom);
+        sharpFrames += residency.baseLevel(static_cast<uint32_t>((low.y + high.y) / 2 * worldTiles + (low.x + high.x) / 2)) <= wanted;
+    }
+
+    std::cout << "streaming " << worldTiles * worldTiles << " textures (" << totalBytes / (1 << 20) << " MB with mips), budget "
+              << residency.budgetBytes / (1 << 20) << " MB: peak " << peakBytes / (1 << 20) << " MB, end "
+              << residency.residentBytes() / (1 << 20) << " MB, plan=" << planMs / frames * 1000.0 << "us/frame, levels loaded "
+              << loadedLevels << " dropped " << droppedLevels << ", centre tile at required mip "
+              << 100.0 * sharpFrames / frames << "% of frames" << std::endl;
+}
+
+// 100K entities sharing 64 clips over an 8x8 sheet, each started at a random
+// frame, against the same entities with a float timer per entity and an fmod
+static void benchAnimation() {
+    const uint32_t count = 100000;
+    const int frames = 1000;
+    const float dt = 1.0f / 60.0f;
+    const SpriteSheet sheet{ 8, 8 };
+    ClipLibrary clips;
+    for (int i = 0; i < 64; ++i) {
+        AnimationLoop loop = static_cast<AnimationLoop>(i % 3);
+        clips.addFromSheet("clip" + std::to_string(i), sheet, i % 56, 4 + i % 5, 6.0f + i % 10, loop);
+    }
+
+    std::mt19937 rng(48);
+    SpriteAnimator animator(clips);
+    std::vector<float> timers(count);
+    std::vector<ClipId> timerClips(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        timerClips[i] = static_cast<ClipId>(rng() % clips.size());
+        timers[i] = (rng() % 1000) / 100.0f;
+        animator.add(timerClips[i], timers[i]);
+    }
+
+    auto start = BenchClock::now();
+    for (int frame = 0; frame < frames; ++frame) animator.update(dt);
+    double soaMs = elapsedMs(start) / frames;
+
+    start = BenchClock::now();
+    for (int frame = 0; frame < frames; ++frame) {
+        for (uint32_t i = 0; i < count; ++i) {
+            const AnimationClip& clip = clips.clip(timerClips[i]);
+            timers[i] = std::fmod(timers[i] + dt * clip.framesPerSecond, static_cast<float>(clip.frameCount));
+        }
+    }
+    double timerMs = elapsedMs(start) / frames;
+
+    // Resolving every entity's frame rect, as a sprite submit would
+    float checksum = 0.0f;
+    start = BenchClock::now();
+    for (uint32_t i = 0; i < count; ++i) checksum += animator.uv(i).x;
+    double uvMs = elapsedMs(start);
+
+    std::cout << "animation entities=" << count << " clips=" << clips.size() << ": update=" << soaMs * 1000.0
+              << "us (" << sizeof(ClipId) + sizeof(uint32_t) << " bytes/entity), float timers+fmod=" << timerMs * 1000.0
+              << "us, uv lookup=" << uvMs * 1000.0 << "us (checksum " << checksum + timers[0] << ")" << std::endl;
+}
+
+// A crowded scene of sprites with transparent borders (a disc, a diamond and a
+// narrow figure) drawn as full quads, as trimmed rects and as 8-vertex hulls.
+// The shaded pixel counts give the overdraw; the frames must come out identical.
+static void benchOverdraw() {
+    const int width = 1280, height = 720, spriteCount = 4000, size = 64;
+    std::vector<Image> sprites(3, Image(size, size));
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            float dx = x + 0.5f - size / 2, dy = y + 0.5f - size / 2;
+            bool shapes[3] = { dx * dx + dy * dy < 24.0f * 24.0f, std::fabs(dx) + std::fabs(dy) < 26.0f,
+                               std::fabs(dx) < 10.0f + y / 16 && y > 4 && y < 60 };
+            for (int i = 0; i < 3; ++i) {
+                unsigned char* p = sprites[i].pixel(x, y);
+                p[0] = static_cast<unsigned char>(x * 4);
+                p[1] = static_cast<unsigned char>(y * 4);
+                p[2] = static_cast<unsigned char>(80 * i);
+                p[3] = shapes[i] ? 255 : 0;
+            }
+        }
+    }
+
+    std::mt19937 rng(49);
+    std::uniform_real_distribution<float> px(-96.0f, float(width)), py(-96.0f, float(height)), scale(48.0f, 96.0f);
+    std::vector<RenderCommand> commands(spriteCount);
+    for (int i = 0; i < spriteCount; ++i) {
+        RenderCommand& cmd = commands[i];
+        cmd = RenderCommand{};
+        cmd.position = glm::vec2(px(rng), py(rng));
+        cmd.size = glm::vec2(scale(rng));
+        cmd.uv = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+        cmd.color = COLOR_WHITE;
+        cmd.texture = 1 + rng() % 3;
+    }
+    glm::mat4 projection = glm::ortho(0.0f, float(width), 0.0f, float(height));
+
+    ThreadPool pool;
+    Image reference;
+    for (int maxVertices : { 0, 4, 8 }) {
+        SpriteMeshTable meshes;
+        uint16_t ids[3] = {};
+        auto start = BenchClock::now();
+        for (int i = 0; i < 3 && maxVertices > 0; ++i) ids[i] = meshes.add(buildSpriteMesh(sprites[i], maxVertices));
+        double buildMs = elapsedMs(start);
+
+        RenderQueue queue;
+        for (int i = 0; i < spriteCount; ++i) {
+            RenderCommand cmd = commands[i];
+            cmd.mesh = ids[cmd.texture - 1];
+            queue.submit(SortKey::ordered(RenderLayer::Sprites, SortKey::depthFromFloat(float(i)), 0, cmd.texture), cmd);
+        }
+        queue.sort();
+
+        SoftwareRasterizer rasterizer(&pool);
+        for (const Image& sprite : sprites) rasterizer.createTexture(sprite);
+        rasterizer.setSpriteMeshes(&meshes);
+        rasterizer.setCamera(projection, glm::mat4(1.0f));
+        double best = 1e9;
+        for (int frame = 0; frame < 3; ++frame) {
+            start = BenchClock::now();
+            rasterizer.beginFrame(width, height, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+            rasterizer.draw(queue);
+            best = std::min(best, elapsedMs(start));
+        }
+
+        const RasterStats& stats = rasterizer.stats();
+        if (reference.empty()) reference = rasterizer.framebuffer();
+        ImageDiff diff = compareImages(reference, rasterizer.framebuffer(), 0);
+        double screen = double(width) * height;
+        std::cout << "overdraw " << (maxVertices == 0 ? "quads  " : maxVertices == 4 ? "trimmed" : "hull8  ")
+                  << " mesh area";
+        for (int i = 0; i < 3; ++i) std::cout << " " << meshes[ids[i]].area();
+        std::cout << " build=" << buildMs * 1000.0 << "us: triangles=" << stats.triangles << " shaded=" << stats.pixelsShaded
+                  << " (overdraw " << stats.pixelsShaded / screen << ", visible " << stats.pixelsWritten / screen
+                  << ") frame=" << best << "ms, " << diff.differingPixels << " pixels differ from quads (max delta " << diff.maxDelta
+                  << ")" << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    struct Bench { const char* name; void (*run)(); };
+    const Bench benches[] = {
+        { "atlas", benchAtlas },
+        { "sort", benchSort },
+        { "build", benchBuild },
+        { "raster", benchRaster },
+        { "ysort", benchYSort },
+        { "lights", benchLights },
+        { "tiledlights", benchTiledLights },
+        { "particles", benchParticles },
+        { "texstartup", benchTextureStartup },
+        { "imagecache", benchImageCache },
+        { "kernels", benchKernels },
+        { "streaming", benchStreaming },
+        { "animation", benchAnimation },
+        { "overdraw", benchOverdraw },
+    };
+
+    for (const Bench& bench : benches) {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; ++i) selected |= std::strcmp(argv[i], bench.name) == 0;
+        if (selected) bench.run();
+    }
+    return 0;
+}
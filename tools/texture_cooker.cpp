@@ -0,0 +1,101 @@
+// File: tools/texture_cooker.cpp
+// Offline texture build step: decodes images once and writes .tex containers
+// with the full mip chain (RGBA8 or BC1) that the loaders map and upload as is.
+// Each input gets a .tex next to it, which loadTexture then picks up in place
+// of the source as long as it is not older. Mips are filtered on the CPU
+// (Render/image_kernels.h), rows split across every core.
+//
+// Build: g++ -O2 -Iinclude tools/texture_cooker.cpp -o texture_cooker -lpthread
+// Usage: texture_cooker [-f rgba8|bc1] [-m box|kaiser|lanczos] [-s] [-n] [-o out.tex] images...
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <Render/image.h>
+#include <Render/texture_container.h>
+#include <Render/texture_cook.h>
+#include <Render/thread_pool.h>
+
+static void printUsage() {
+    std::cout << "usage: texture_cooker [-f rgba8|bc1] [-m box|kaiser|lanczos] [-s] [-n] [-o out.tex] images...\n"
+                 "  -f  level format (default rgba8)\n"
+                 "  -m  mip filter (default box)\n"
+                 "  -s  colour is sRGB: filter mips in linear light\n"
+                 "  -n  no mip chain, level 0 only\n"
+                 "  -o  output path; only with a single input" << std::endl;
+}
+
+static bool cook(const std::string& input, const std::string& output, TextureFormat format, bool withMips,
+                 const MipOptions& mipOptions, ThreadPool& pool) {
+    Image image;
+    if (!loadImage(input.c_str(), image)) return false;
+
+    std::vector<Image> mips = buildMipChain(image, withMips, mipOptions, &pool);
+    std::vector<std::vector<uint8_t>> levels;
+    size_t bytes = 0;
+    for (const Image& mip : mips) {
+        levels.push_back(format == TextureFormat::BC1 ? encodeBC1(mip) : mip.pixels);
+        bytes += levels.back().size();
+    }
+    if (!writeTextureContainer(output.c_str(), format, image.width, image.height, levels)) return false;
+
+    std::cout << output << ": " << image.width << "x" << image.height << ", " << levels.size() << " levels, "
+              << bytes / 1024 << " KB" << std::endl;
+    return true;
+}
+
+int main(int argc, char** argv) {
+    TextureFormat format = TextureFormat::RGBA8;
+    MipOptions mipOptions;
+    bool withMips = true;
+    std::string output;
+    std::vector<std::string> inputs;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-f" && i + 1 < argc) {
+            std::string name = argv[++i];
+            if (name == "bc1") format = TextureFormat::BC1;
+            else if (name != "rgba8") {
+                printUsage();
+                return 1;
+            }
+        }
+        else if (arg == "-m" && i + 1 < argc) {
+            std::string name = argv[++i];
+            if (name == "kaiser") mipOptions.filter = ResampleFilter::Kaiser;
+            else if (name == "lanczos") mipOptions.filter = ResampleFilter::Lanczos3;
+            else if (name != "box") {
+                printUsage();
+                return 1;
+            }
+        }
+        else if (arg == "-s") mipOptions.srgb = true;
+        else if (arg == "-n") withMips = false;
+        else if (arg == "-o" && i + 1 < argc) output = argv[++i];
+        else inputs.push_back(arg);
+    }
+
+    if (inputs.empty() || (!output.empty() && inputs.size() > 1)) {
+        printUsage();
+        return 1;
+    }
+
+    ThreadPool pool;
+    auto start = std::chrono::steady_clock::now();
+    int failed = 0;
+    for (const std::string& input : inputs) {
+        std::string target = output;
+        if (target.empty()) target = std::filesystem::path(input).replace_extension(".tex").string();
+        if (!cook(input, target, format, withMips, mipOptions, pool)) ++failed;
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << inputs.size() - failed << "/" << inputs.size() << " cooked in " << ms << " ms" << std::endl;
+    return failed == 0 ? 0 : 1;
+}